@@ -0,0 +1,111 @@
+// FileSorts comparators : the previous string parsing getters against the typed slots.
+//
+//   ./filesorts-benchmark [games=20000] [runs=5]
+//
+// Each run stable_sorts a shuffled copy of the games, like FolderData::sort does. Times are averaged over the runs.
+
+#include "FileSorts.h"
+#include "SyntheticGamelist.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+typedef SyntheticGamelist::LegacyGame LegacyGame;
+
+template<typename T, typename Compare>
+static double timeSorts(const std::vector<T*>& items, int runs, Compare compare)
+{
+	std::mt19937 random(1234);
+	double total = 0;
+
+	for (int i = 0; i < runs; i++)
+	{
+		std::vector<T*> copy = items;
+		std::shuffle(copy.begin(), copy.end(), random);
+
+		auto start = std::chrono::steady_clock::now();
+		std::stable_sort(copy.begin(), copy.end(), compare);
+		total += SyntheticGamelist::elapsedMs(start);
+	}
+
+	return total / runs;
+}
+
+template<typename T, typename Filter>
+static double timeScan(const std::vector<T*>& items, int runs, Filter filter)
+{
+	double total = 0;
+	size_t found = 0;
+
+	for (int i = 0; i < runs; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (auto item : items)
+			if (filter(item))
+				found++;
+
+		total += SyntheticGamelist::elapsedMs(start);
+	}
+
+	if (found == 0)
+		std::cout << "(no match)" << std::endl;
+
+	return total / runs;
+}
+
+static void report(const std::string& name, double before, double after)
+{
+	std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(10) << before << std::setw(10) << after << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	int count = argc > 1 ? atoi(argv[1]) : 20000;
+	int runs = argc > 2 ? atoi(argv[2]) : 5;
+
+	MetaDataList::initMetadata();
+
+	auto games = SyntheticGamelist::generateGames("snes", count);
+
+	std::vector<LegacyGame*> legacy;
+	for (auto& game : games)
+		legacy.push_back(SyntheticGamelist::createLegacyGame(game));
+
+	SystemData* system = SyntheticGamelist::createSystem("snes", games);
+
+	std::vector<FileData*> files;
+	for (auto file : system->getRootFolder()->getChildren())
+		files.push_back(file);
+
+	std::cout << count << " games, " << runs << " shuffled stable_sorts (avg ms)" << std::endl;
+	std::cout << std::left << std::setw(14) << "" << std::right << std::setw(10) << "strings" << std::setw(10) << "slots" << std::endl;
+
+	report("rating",
+		timeSorts(legacy, runs, [](const LegacyGame* a, const LegacyGame* b) { return a->getFloat(MetaDataId::Rating) < b->getFloat(MetaDataId::Rating); }),
+		timeSorts(files, runs, FileSorts::compareRating));
+
+	report("timesplayed",
+		timeSorts(legacy, runs, [](const LegacyGame* a, const LegacyGame* b) { return a->getInt(MetaDataId::PlayCount) < b->getInt(MetaDataId::PlayCount); }),
+		timeSorts(files, runs, FileSorts::compareTimesPlayed));
+
+	report("players",
+		timeSorts(legacy, runs, [](const LegacyGame* a, const LegacyGame* b) { return a->getInt(MetaDataId::Players) < b->getInt(MetaDataId::Players); }),
+		timeSorts(files, runs, FileSorts::compareNumPlayers));
+
+	report("releasedate",
+		timeSorts(legacy, runs, [](const LegacyGame* a, const LegacyGame* b) { return a->get(MetaDataId::ReleaseDate) < b->get(MetaDataId::ReleaseDate); }),
+		timeSorts(files, runs, FileSorts::compareReleaseDate));
+
+	report("favorites",
+		timeScan(legacy, runs, [](const LegacyGame* a) { return a->get(MetaDataId::Favorite) == "true"; }),
+		timeScan(files, runs, [](FileData* a) { return a->getFavorite(); }));
+
+	delete system;
+
+	for (auto game : legacy)
+		delete game;
+
+	return 0;
+}
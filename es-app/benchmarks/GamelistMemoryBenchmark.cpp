@@ -0,0 +1,66 @@
+// Heap used by a synthetic gamelist : the previous layout (full path + map of strings) against FileData.
+//
+//   ./gamelist-memory-benchmark [games=100000]
+//
+// Each game has a rom path, image/thumbnail/video/marquee paths and the usual scraped fields.
+// Measured with mallinfo2 (glibc), so the numbers include the allocator overhead.
+
+#include "SyntheticGamelist.h"
+#include "utils/InternedPath.h"
+#include <cstdlib>
+#include <iostream>
+#include <malloc.h>
+
+static size_t getHeapUsed()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	return mallinfo2().uordblks;
+#elif defined(__GLIBC__)
+	return (size_t)(unsigned int)mallinfo().uordblks;
+#else
+	return 0;
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	int count = argc > 1 ? atoi(argv[1]) : 100000;
+
+	MetaDataList::initMetadata();
+
+	auto games = SyntheticGamelist::generateGames("snes", count);
+
+	size_t legacyBytes;
+	{
+		size_t before = getHeapUsed();
+
+		std::vector<SyntheticGamelist::LegacyGame*> legacy;
+		legacy.reserve(count);
+		for (auto& game : games)
+			legacy.push_back(SyntheticGamelist::createLegacyGame(game));
+
+		legacyBytes = getHeapUsed() - before;
+
+		for (auto game : legacy)
+			delete game;
+	}
+
+	size_t fileDataBytes;
+	{
+		size_t before = getHeapUsed();
+
+		SystemData* system = SyntheticGamelist::createSystem("snes", games);
+		fileDataBytes = getHeapUsed() - before;
+
+		Utils::InternedPathStats stats = Utils::InternedPath::getStats();
+		std::cout << "interned paths : " << stats.paths << " paths sharing " << stats.folders << " folders" << std::endl;
+
+		delete system;
+	}
+
+	std::cout << count << " games" << std::endl;
+	std::cout << "  std::string path + std::map values : " << (legacyBytes / 1024) << " KB" << std::endl;
+	std::cout << "  FileData (InternedPath + slots)    : " << (fileDataBytes / 1024) << " KB" << std::endl;
+
+	return 0;
+}
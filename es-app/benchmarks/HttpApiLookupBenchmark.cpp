@@ -0,0 +1,111 @@
+// Latency of the HTTP API game requests (/systems/{sys}/games/{id}) : the previous md5 tree walk against the SystemData id index.
+//
+//   ./httpapi-lookup-benchmark [games=10000] [requests=1000]
+//
+// A request is the game lookup followed by its JSON serialization, as HttpServerThread does.
+
+#include "SyntheticGamelist.h"
+#include "services/HttpApi.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stack>
+
+// HttpApi::findFileData before the id index : one md5 per game until the id is found
+static FileData* findByTreeWalk(SystemData* system, const std::string& id)
+{
+	std::stack<FolderData*> stack;
+	stack.push(system->getRootFolder());
+
+	while (stack.size())
+	{
+		FolderData* current = stack.top();
+		stack.pop();
+
+		for (auto it : current->getChildren())
+		{
+			if (it->getType() == FOLDER)
+				stack.push((FolderData*)it);
+			else if (SystemData::getGameId(it) == id)
+				return it;
+		}
+	}
+
+	return nullptr;
+}
+
+struct Latency
+{
+	double lookupMs;
+	double requestMs;
+	double maxRequestMs;
+};
+
+template<typename Find>
+static Latency timeRequests(SystemData* system, const std::vector<std::string>& ids, Find find)
+{
+	Latency latency = { 0, 0, 0 };
+	size_t bytes = 0;
+
+	for (auto& id : ids)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		FileData* game = find(system, id);
+		latency.lookupMs += SyntheticGamelist::elapsedMs(start);
+
+		if (game != nullptr)
+			bytes += HttpApi::ToJson(game).size();
+
+		double ms = SyntheticGamelist::elapsedMs(start);
+		latency.requestMs += ms;
+		latency.maxRequestMs = std::max(latency.maxRequestMs, ms);
+	}
+
+	if (bytes == 0)
+		std::cout << "(no game found)" << std::endl;
+
+	latency.lookupMs /= ids.size();
+	latency.requestMs /= ids.size();
+	return latency;
+}
+
+static void report(const std::string& name, const Latency& latency)
+{
+	std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(4)
+		<< std::setw(12) << latency.lookupMs << std::setw(12) << latency.requestMs << std::setw(12) << latency.maxRequestMs << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	int count = argc > 1 ? atoi(argv[1]) : 10000;
+	int requests = argc > 2 ? atoi(argv[2]) : 1000;
+
+	MetaDataList::initMetadata();
+
+	auto games = SyntheticGamelist::generateGames("snes", count);
+	SystemData* system = SyntheticGamelist::createSystem("snes", games);
+
+	// Ids polled by a dashboard : random games of the system
+	std::mt19937 random(1234);
+	std::vector<std::string> ids;
+	for (int i = 0; i < requests; i++)
+		ids.push_back(SystemData::getGameId(system->getRootFolder()->getChildren()[random() % count]));
+
+	// The index is built by the first lookup
+	auto start = std::chrono::steady_clock::now();
+	HttpApi::findFileData(system, ids[0]);
+	double indexBuildMs = SyntheticGamelist::elapsedMs(start);
+
+	std::cout << count << " games, " << requests << " requests (ms)" << std::endl;
+	std::cout << std::left << std::setw(12) << "" << std::right << std::setw(12) << "lookup" << std::setw(12) << "request" << std::setw(12) << "max" << std::endl;
+
+	report("tree walk", timeRequests(system, ids, findByTreeWalk));
+	report("id index", timeRequests(system, ids, HttpApi::findFileData));
+
+	std::cout << "id index built by the first request in " << std::fixed << std::setprecision(2) << indexBuildMs << " ms" << std::endl;
+
+	delete system;
+	return 0;
+}
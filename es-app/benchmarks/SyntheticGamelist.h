@@ -0,0 +1,126 @@
+#pragma once
+#ifndef ES_APP_BENCHMARKS_SYNTHETIC_GAMELIST_H
+#define ES_APP_BENCHMARKS_SYNTHETIC_GAMELIST_H
+
+// Synthetic scraped gamelists shared by the es-app benchmarks.
+
+#include "FileData.h"
+#include "MetaData.h"
+#include "SystemData.h"
+#include "utils/StringUtil.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SyntheticGamelist
+{
+	// Values of one gamelist.xml entry : a rom, its image/thumbnail/video/marquee medias and the sortable fields
+	struct Game
+	{
+		std::string path;
+		std::vector<std::pair<MetaDataId, std::string>> values;
+	};
+
+	// The FileData layout before the interned paths & typed slots : a full path and a map of strings, parsed by each getter
+	struct LegacyGame
+	{
+		std::string path;
+		std::map<MetaDataId, std::string> values;
+
+		std::string get(MetaDataId id) const
+		{
+			auto it = values.find(id);
+			return it == values.cend() ? std::string() : it->second;
+		}
+
+		int getInt(MetaDataId id) const { return atoi(get(id).c_str()); }
+		float getFloat(MetaDataId id) const { return Utils::String::toFloat(get(id)); }
+	};
+
+	inline Game generate(const std::string& system, int index, std::mt19937& random)
+	{
+		std::string romFolder = "/userdata/roms/" + system + "/";
+		std::string name = "Synthetic Game " + std::to_string(index) + " (Europe) (Rev " + std::to_string(index % 3) + ")";
+
+		char date[32];
+		snprintf(date, sizeof(date), "%04d%02d%02dT000000", 1980 + (int)(random() % 40), 1 + (int)(random() % 12), 1 + (int)(random() % 28));
+
+		Game game;
+		game.path = romFolder + name + ".zip";
+		game.values.push_back(std::make_pair(MetaDataId::Name, name));
+		game.values.push_back(std::make_pair(MetaDataId::Image, romFolder + "images/" + name + "-image.png"));
+		game.values.push_back(std::make_pair(MetaDataId::Thumbnail, romFolder + "images/" + name + "-thumb.png"));
+		game.values.push_back(std::make_pair(MetaDataId::Video, romFolder + "videos/" + name + "-video.mp4"));
+		game.values.push_back(std::make_pair(MetaDataId::Marquee, romFolder + "images/" + name + "-marquee.png"));
+		game.values.push_back(std::make_pair(MetaDataId::Rating, std::to_string((random() % 21) / 20.0f).substr(0, 4)));
+		game.values.push_back(std::make_pair(MetaDataId::ReleaseDate, std::string(date)));
+		game.values.push_back(std::make_pair(MetaDataId::Developer, "Developer " + std::to_string(random() % 200)));
+		game.values.push_back(std::make_pair(MetaDataId::Genre, "Genre " + std::to_string(random() % 30)));
+		game.values.push_back(std::make_pair(MetaDataId::Players, std::to_string(1 + random() % 4)));
+		game.values.push_back(std::make_pair(MetaDataId::PlayCount, std::to_string(random() % 50)));
+
+		if (random() % 10 == 0)
+			game.values.push_back(std::make_pair(MetaDataId::Favorite, std::string("true")));
+
+		return game;
+	}
+
+	inline std::vector<Game> generateGames(const std::string& system, int count, unsigned int seed = 42)
+	{
+		std::mt19937 random(seed);
+
+		std::vector<Game> games;
+		games.reserve(count);
+		for (int i = 0; i < count; i++)
+			games.push_back(generate(system, i, random));
+
+		return games;
+	}
+
+	// A system that is only a data structure (like the collections) : no rom folder, gamelist or theme is read
+	inline SystemData* createSystem(const std::string& name, const std::vector<Game>& games)
+	{
+		SystemMetadata md;
+		md.name = name;
+		md.fullName = name;
+		md.themeFolder = name;
+		md.releaseYear = 0;
+
+		SystemData* system = new SystemData(md, nullptr, nullptr, true, false, false);
+
+		FolderData* root = system->getRootFolder();
+		for (auto& game : games)
+		{
+			FileData* file = new FileData(GAME, game.path, system);
+			for (auto& value : game.values)
+				file->getMetadata().set(value.first, value.second);
+
+			file->getMetadata().resetChangedFlag();
+			root->addChild(file);
+		}
+
+		return system;
+	}
+
+	inline LegacyGame* createLegacyGame(const Game& game)
+	{
+		LegacyGame* legacy = new LegacyGame();
+		legacy->path = game.path;
+		for (auto& value : game.values)
+			legacy->values[value.first] = value.second;
+
+		return legacy;
+	}
+
+	inline double elapsedMs(const std::chrono::steady_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+#endif // ES_APP_BENCHMARKS_SYNTHETIC_GAMELIST_H
@@ -1181,14 +1181,14 @@ void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<s
 		{
 			getAllGamesCollection();
 
-			Utils::ThreadPool pool;
+			Utils::TaskGroup pool;
 
 			for (auto collection : collectionsToPopulate)
 			{
 				if (collection->decl.isCustom)
-					pool.queueWorkItem([this, collection, pMap] { populateCustomCollection(collection, pMap); });
+					pool.queue([this, collection, pMap] { populateCustomCollection(collection, pMap); });
 				else
-					pool.queueWorkItem([this, collection, pMap] { populateAutoCollection(collection); });
+					pool.queue([this, collection, pMap] { populateAutoCollection(collection); });
 			}
 
 			pool.wait();
@@ -48,7 +48,7 @@ const std::string FileData::getPath() const
 	if (mPath.empty())
 		return getSystemEnvData()->mStartPath;
 
-	return mPath;
+	return mPath.toString();
 }
 
 const std::string FileData::getBreadCrumbPath()
@@ -103,12 +103,13 @@ std::string FileData::getSystemName() const
 
 FileData::~FileData()
 {
-	if (mDisplayName)
-		delete mDisplayName;
-
+	// First : leaving the parent removes the game from the id index, the HTTP API may be reading it until then
 	if(mParent)
 		mParent->removeChild(this);
 
+	if (mDisplayName)
+		delete mDisplayName;
+
 	if(mType == GAME)
 		mSystem->removeFromIndex(this);	
 }
@@ -201,12 +202,12 @@ const std::string FileData::getThumbnailPath()
 
 const bool FileData::getFavorite()
 {
-	return getMetadata(MetaDataId::Favorite) == "true";
+	return getMetadata().getBool(MetaDataId::Favorite);
 }
 
 const bool FileData::getHidden()
 {
-	return getMetadata(MetaDataId::Hidden) == "true";
+	return getMetadata().getBool(MetaDataId::Hidden);
 }
 
 const bool FileData::getKidGame()
@@ -696,7 +697,7 @@ bool FileData::hasContentFiles()
 	if (mPath.empty())
 		return false;
 
-	std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(mPath));
+	std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(mPath.toString()));
 	if (ext == ".m3u" || ext == ".cue" || ext == ".ccd" || ext == ".gdi")
 		return getSourceFileData()->getSystemEnvData()->isValidExtension(ext) && getSourceFileData()->getSystemEnvData()->mSearchExtensions.size() > 1;
 
@@ -753,21 +754,23 @@ std::set<std::string> FileData::getContentFiles()
 	if (mPath.empty())
 		return files;
 
-	if (Utils::FileSystem::isDirectory(mPath))
+	std::string filePath = mPath.toString();
+
+	if (Utils::FileSystem::isDirectory(filePath))
 	{
-		for (auto file : Utils::FileSystem::getDirContent(mPath, true, true))
+		for (auto file : Utils::FileSystem::getDirContent(filePath, true, true))
 			files.insert(file);
 	}
 	else if (hasContentFiles())
 	{
-		auto path = Utils::FileSystem::getParent(mPath);
-		auto ext = Utils::String::toLower(Utils::FileSystem::getExtension(mPath));
+		auto path = Utils::FileSystem::getParent(filePath);
+		auto ext = Utils::String::toLower(Utils::FileSystem::getExtension(filePath));
 
 		if (ext == ".cue")
 		{
 			std::string start = "FILE";
 
-			std::ifstream cue(WINSTRINGW(mPath));
+			std::ifstream cue(WINSTRINGW(filePath));
 			if (cue && cue.is_open())
 			{
 				std::string line;
@@ -786,7 +789,7 @@ std::set<std::string> FileData::getContentFiles()
 		}
 		else if (ext == ".ccd")
 		{
-			std::string stem = Utils::FileSystem::getStem(mPath);
+			std::string stem = Utils::FileSystem::getStem(filePath);
 			files.insert(path + "/" + stem + ".cue");
 			files.insert(path + "/" + stem + ".img");
 			files.insert(path + "/" + stem + ".bin");
@@ -794,7 +797,7 @@ std::set<std::string> FileData::getContentFiles()
 		}
 		else if (ext == ".m3u")
 		{
-			std::ifstream m3u(WINSTRINGW(mPath));
+			std::ifstream m3u(WINSTRINGW(filePath));
 			if (m3u && m3u.is_open())
 			{
 				std::string line;
@@ -812,7 +815,7 @@ std::set<std::string> FileData::getContentFiles()
 		}
 		else if (ext == ".gdi")
 		{
-			std::ifstream gdi(WINSTRINGW(mPath));
+			std::ifstream gdi(WINSTRINGW(filePath));
 			if (gdi && gdi.is_open())
 			{
 				std::string line;
@@ -1187,6 +1190,9 @@ void FolderData::addChild(FileData* file, bool assignParent)
 
 	if (assignParent)
 		file->setParent(this);	
+
+	if (file->getType() == GAME && mSystem != nullptr)
+		mSystem->addToGameIdIndex(file);
 }
 
 void FolderData::removeChild(FileData* file)
@@ -1202,6 +1208,10 @@ void FolderData::removeChild(FileData* file)
 		{
 			file->setParent(NULL);
 			mChildren.erase(it);
+
+			if (file->getType() == GAME && mSystem != nullptr)
+				mSystem->removeFromGameIdIndex(file);
+
 			return;
 		}
 	}
@@ -1623,6 +1633,10 @@ void FolderData::clear()
 	}
 
 	mChildren.clear();
+
+	// Deleted children left the index one by one. Rebuilt on the next lookup : children not owned are dropped without removeChild
+	if (mSystem != nullptr)
+		mSystem->resetGameIdIndex();
 }
 
 void FolderData::removeFromVirtualFolders(FileData* game)
@@ -1638,6 +1652,10 @@ void FolderData::removeFromVirtualFolders(FileData* game)
 		if ((*it) == game)
 		{
 			mChildren.erase(it);
+
+			if (mSystem != nullptr)
+				mSystem->removeFromGameIdIndex(game);
+
 			return;
 		}
 	}
@@ -3,6 +3,7 @@
 #define ES_APP_FILE_DATA_H
 
 #include "utils/FileSystemUtil.h"
+#include "utils/InternedPath.h"
 #include "MetaData.h"
 #include <unordered_map>
 #include <memory>
@@ -161,7 +162,7 @@ private:
 
 protected:	
 	FolderData* mParent;
-	std::string mPath;
+	Utils::InternedPath mPath;
 	FileType mType;
 	SystemData* mSystem;
 	std::string* mDisplayName;
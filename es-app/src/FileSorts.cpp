@@ -138,9 +138,8 @@ namespace FileSorts
 
 	bool compareLastPlayed(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->getMetadata().get(MetaDataId::LastPlayed) < (file2)->getMetadata().get(MetaDataId::LastPlayed);
+		// dates are stored as sortable integers (YYYYMMDDhhmmss), ordered like their ISO strings
+		return (file1)->getMetadata().getDate(MetaDataId::LastPlayed) < (file2)->getMetadata().getDate(MetaDataId::LastPlayed);
 	}
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
@@ -148,6 +147,15 @@ namespace FileSorts
 		return (file1)->getMetadata().getInt(MetaDataId::Players) < (file2)->getMetadata().getInt(MetaDataId::Players);
 	}
 
+	static long long getReleaseYear(const FileData* file)
+	{
+		long long date = file->getMetadata().getDate(MetaDataId::ReleaseDate);
+		if (date < 0)
+			return -1;
+
+		return date / 10000000000LL;
+	}
+
 	bool compareSystemReleaseYear(const FileData* file1, const FileData* file2)
 	{
 		std::string system1 = ((FileData*)file1)->getSourceFileData()->getSystemName();
@@ -155,8 +163,8 @@ namespace FileSorts
 
 		if (system1 == system2)
 		{
-			std::string year1 = file1->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4);
-			std::string year2 = file2->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4);
+			long long year1 = getReleaseYear(file1);
+			long long year2 = getReleaseYear(file2);
 
 			if (year1 == year2)
 				return Utils::String::compareIgnoreCase(((FileData*)file1)->getName(), ((FileData*)file2)->getName()) < 0;
@@ -168,8 +176,8 @@ namespace FileSorts
 
 	bool compareReleaseYearSystem(const FileData* file1, const FileData* file2)
 	{
-		std::string year1 = file1->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4);
-		std::string year2 = file2->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4);
+		long long year1 = getReleaseYear(file1);
+		long long year2 = getReleaseYear(file2);
 
 		if (year1 == year2)
 		{
@@ -187,9 +195,8 @@ namespace FileSorts
 
 	bool compareReleaseDate(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->getMetadata().get(MetaDataId::ReleaseDate) < (file2)->getMetadata().get(MetaDataId::ReleaseDate);
+		// dates are stored as sortable integers (YYYYMMDDhhmmss), ordered like their ISO strings
+		return (file1)->getMetadata().getDate(MetaDataId::ReleaseDate) < (file2)->getMetadata().getDate(MetaDataId::ReleaseDate);
 	}
 
 	bool compareFileCreationDate(const FileData* file1, const FileData* file2)
@@ -0,0 +1,87 @@
+#include "FolderScanner.h"
+
+#include "FileData.h"
+#include "SystemData.h"
+#include "Log.h"
+#include "utils/ThreadPool.h"
+
+FolderScanner::FolderScanner(SystemData* system) : mSystem(system), mTasks(nullptr)
+{
+}
+
+void FolderScanner::scan(FolderData* root, std::unordered_map<std::string, FileData*>& fileMap)
+{
+	ScanNode rootNode(root);
+
+	Utils::TaskGroup tasks(Utils::TaskPriority::High);
+	mTasks = &tasks;
+
+	// The root folder is scanned by the calling thread, which then helps with the subfolders while waiting
+	process(&rootNode);
+	tasks.wait();
+
+	mTasks = nullptr;
+
+	merge(&rootNode, fileMap);
+}
+
+void FolderScanner::process(ScanNode* node)
+{
+	try
+	{
+		node->scanned = mSystem->scanFolder(node->folder, node->entries, node->folderDate);
+	}
+	catch (...)
+	{
+		LOG(LogError) << "FolderScanner : error scanning " << node->folder->getPath();
+	}
+
+	for (auto entry : node->entries)
+		if (entry->getType() == FOLDER)
+			node->subFolders.push_back(std::unique_ptr<ScanNode>(new ScanNode((FolderData*)entry)));
+
+	for (auto& subFolder : node->subFolders)
+	{
+		ScanNode* subNode = subFolder.get();
+		mTasks->queue([this, subNode] { process(subNode); });
+	}
+}
+
+void FolderScanner::merge(ScanNode* node, std::unordered_map<std::string, FileData*>& fileMap)
+{
+	if (!node->scanned)
+		return;
+
+	FolderData* folder = node->folder;
+
+	if (mSystem->mScannedFolders != nullptr)
+		mSystem->mScannedFolders->push_back(std::pair<std::string, time_t>(folder->getPath(), node->folderDate));
+
+	auto subFolder = node->subFolders.begin();
+
+	for (auto entry : node->entries)
+	{
+		if (entry->getType() == GAME)
+		{
+			folder->addChild(entry);
+			fileMap[entry->getPath()] = entry;
+			continue;
+		}
+
+		FolderData* newFolder = (FolderData*)entry;
+		merge((subFolder++)->get(), fileMap);
+
+		//ignore folders that do not contain games
+		if (newFolder->getChildren().size() == 0)
+			delete newFolder;
+		else
+		{
+			const std::string& key = newFolder->getPath();
+			if (fileMap.find(key) == fileMap.end())
+			{
+				folder->addChild(newFolder);
+				fileMap[key] = newFolder;
+			}
+		}
+	}
+}
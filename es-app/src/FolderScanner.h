@@ -0,0 +1,50 @@
+#pragma once
+#ifndef ES_APP_FOLDER_SCANNER_H
+#define ES_APP_FOLDER_SCANNER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <time.h>
+
+class SystemData;
+class FileData;
+class FolderData;
+
+namespace Utils
+{
+	class TaskGroup;
+}
+
+// Scans the folder tree of a system using one task per folder on the shared executor : subfolders are queued on the
+// worker that found them, idle workers steal them. Results are kept per folder, then merged into the FolderData tree
+// in the same order as the sequential scan.
+class FolderScanner
+{
+public:
+	FolderScanner(SystemData* system);
+
+	void scan(FolderData* root, std::unordered_map<std::string, FileData*>& fileMap);
+
+private:
+	struct ScanNode
+	{
+		ScanNode(FolderData* f) : folder(f), folderDate(0), scanned(false) { }
+
+		FolderData* folder;
+		time_t folderDate;
+		bool scanned;
+
+		std::vector<FileData*> entries;
+		std::vector<std::unique_ptr<ScanNode>> subFolders; // same order as the FOLDER entries
+	};
+
+	void process(ScanNode* node);
+	void merge(ScanNode* node, std::unordered_map<std::string, FileData*>& fileMap);
+
+	SystemData* mSystem;
+	Utils::TaskGroup* mTasks;
+};
+
+#endif // ES_APP_FOLDER_SCANNER_H
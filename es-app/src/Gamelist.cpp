@@ -10,6 +10,11 @@
 #include <pugixml/src/pugixml.hpp>
 #include "Genres.h"
 #include "Paths.h"
+#include "GamelistCache.h"
+#include "GamelistJournal.h"
+#include "GamelistStreamReader.h"
+#include <algorithm>
+#include <sstream>
 
 #ifdef WIN32
 #include <Windows.h>
@@ -106,33 +111,43 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 	return NULL;
 }
 
-std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize, bool fromFile)
+std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize, bool fromFile, size_t* peakMemory)
 {	
 	std::vector<FileData*> ret;
 
 	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+	if (fromFile)
+		LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result result = fromFile ? doc.load_file(xmlpath.c_str()) : doc.load_string(xmlpath.c_str());
+	std::string xmlName = fromFile ? xmlpath : "gamelist data";
 
-	if (!result)
+	// Entries are parsed one by one while reading, the whole document is never loaded
+	GamelistStreamReader reader;
+	if (fromFile)
 	{
-		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return ret;
+		if (!reader.openFile(xmlpath))
+		{
+			LOG(LogError) << "Error parsing XML file \"" << xmlName << "\"!\n	" << reader.getError();
+			return ret;
+		}
 	}
+	else
+		reader.openString(xmlpath);
 
-	pugi::xml_node root = doc.child("gameList");
-	if (!root)
+	if (!reader.readRoot())
 	{
-		LOG(LogError) << "Could not find <gameList> node in gamelist \"" << xmlpath << "\"!";
+		if (!reader.getError().empty())
+			LOG(LogError) << "Error parsing XML file \"" << xmlName << "\"!\n	" << reader.getError();
+		else
+			LOG(LogError) << "Could not find <gameList> node in gamelist \"" << xmlName << "\"!";
+
 		return ret;
 	}
 
 	if (checkSize != SIZE_MAX)
 	{
-		auto parentSize = root.attribute("parentHash").as_uint();
+		auto parentSize = reader.getRootAttribute("parentHash").as_uint();
 		if (parentSize != checkSize)
 		{
 			LOG(LogWarning) << "gamelist size don't match !";
@@ -142,7 +157,8 @@ std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* s
 
 	std::string relativeTo = system->getStartPath();
 
-	for (pugi::xml_node fileNode : root.children())
+	pugi::xml_node fileNode;
+	while (reader.next(fileNode))
 	{
 		FileType type = GAME;
 
@@ -191,6 +207,12 @@ std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* s
 		}
 	}
 
+	if (!reader.getError().empty())
+		LOG(LogError) << "Error parsing XML file \"" << xmlName << "\"!\n	" << reader.getError();
+
+	if (peakMemory != nullptr)
+		*peakMemory = std::max(*peakMemory, reader.getPeakMemory());
+
 	return ret;
 }
 
@@ -200,22 +222,34 @@ void clearTemporaryGamelistRecovery(SystemData* system)
 	Utils::FileSystem::deleteDirectoryFiles(path, true);
 }
 
-void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap)
+void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t* peakMemory)
 {
 	std::string xmlpath = system->getGamelistPath(false);
 
 	auto size = Utils::FileSystem::getFileSize(xmlpath);
 	if (size != 0)
-		loadGamelistFile(xmlpath, system, fileMap, SIZE_MAX, true);
+		loadGamelistFile(xmlpath, system, fileMap, SIZE_MAX, true, peakMemory);
 
 	auto files = Utils::FileSystem::getDirContent(getGamelistRecoveryPath(system), true);
 	for (auto file : files)
-		loadGamelistFile(file, system, fileMap, size, true);
+		loadGamelistFile(file, system, fileMap, size, true, peakMemory);
+
+	GamelistJournal::replay(system, fileMap);
 
 	if (size != SIZE_MAX)
 		system->setGamelistHash(size);	
 }
 
+static std::string getGamelistEntryPath(FileData* file, SystemData* system)
+{
+	// try and make the path relative if we can so things still work if we change the rom folder location in the future
+	std::string path = Utils::FileSystem::createRelativePath(file->getPath(), system->getStartPath(), false);
+	if (path.empty() && file->getType() == FOLDER)
+		path = ".";
+
+	return path;
+}
+
 bool addFileDataNode(pugi::xml_node& parent, FileData* file, const char* tag, SystemData* system, bool fullPaths = false)
 {
 	//create game and add to parent node
@@ -234,19 +268,32 @@ bool addFileDataNode(pugi::xml_node& parent, FileData* file, const char* tag, Sy
 		return false;
 	}
 
+	// there's something useful in there so we'll keep the node, add the path
 	if (fullPaths)
 		newNode.prepend_child("path").text().set(file->getPath().c_str());
 	else
+		newNode.prepend_child("path").text().set(getGamelistEntryPath(file, system).c_str());
+
+	return true;	
+}
+
+// Journal record with the current state of the files. Files without any useful metadata get a node with only their path, which removes them from gamelist.xml
+static std::string createJournalRecord(const std::vector<FileData*>& files, SystemData* system, bool removed = false)
+{
+	pugi::xml_document doc;
+	pugi::xml_node root = doc.append_child("gameList");
+
+	for (auto file : files)
 	{
-		// there's something useful in there so we'll keep the node, add the path
-		// try and make the path relative if we can so things still work if we change the rom folder location in the future
-		std::string path = Utils::FileSystem::createRelativePath(file->getPath(), system->getStartPath(), false).c_str();
-		if (path.empty() && file->getType() == FOLDER)
-			path = ".";
+		const char* tag = file->getType() == GAME ? "game" : "folder";
 
-		newNode.prepend_child("path").text().set(path.c_str());
+		if (removed || !addFileDataNode(root, file, tag, system))
+			root.append_child(tag).append_child("path").text().set(getGamelistEntryPath(file, system).c_str());
 	}
-	return true;	
+
+	std::ostringstream stream;
+	doc.save(stream, "", pugi::format_raw);
+	return stream.str();
 }
 
 bool saveToXml(FileData* file, const std::string& fileName, bool fullPaths)
@@ -283,21 +330,21 @@ bool saveToXml(FileData* file, const std::string& fileName, bool fullPaths)
 
 bool saveToGamelistRecovery(FileData* file)
 {
+	SystemData* system = file->getSourceFileData()->getSystem();
+	system->incrementChangeCounter();
+
 	if (!Settings::getInstance()->getBool("SaveGamelistsOnExit"))
 		return false;
 
-	SystemData* system = file->getSourceFileData()->getSystem();
 	if (!Settings::HiddenSystemsShowGames() && !system->isVisible())
 		return false;
 
-	std::string fp = file->getFullPath();
-	fp = Utils::FileSystem::createRelativePath(file->getFullPath(), system->getRootFolder()->getFullPath(), true);
-	fp = Utils::FileSystem::getParent(fp) + "/" + Utils::FileSystem::getStem(fp) + ".xml";
-
-	std::string path = Utils::FileSystem::getAbsolutePath(fp, getGamelistRecoveryPath(system));
-	path = Utils::FileSystem::getCanonicalPath(path);
+	FileData* sourceFile = file->getSourceFileData();
+	if (!GamelistJournal::append(system, createJournalRecord({ sourceFile }, system)))
+		return false;
 
-	return saveToXml(file, path);
+	sourceFile->getMetadata().resetChangedFlag();
+	return true;
 }
 
 bool removeFromGamelistRecovery(FileData* file)
@@ -313,10 +360,15 @@ bool removeFromGamelistRecovery(FileData* file)
 	std::string path = Utils::FileSystem::getAbsolutePath(fp, getGamelistRecoveryPath(system));
 	path = Utils::FileSystem::getCanonicalPath(path);
 
+	// Same rules as saveToGamelistRecovery : nothing is journaled when the gamelists are not saved
+	bool ret = false;
+	if (Settings::getInstance()->getBool("SaveGamelistsOnExit") && (Settings::HiddenSystemsShowGames() || system->isVisible()))
+		ret = GamelistJournal::append(system, createJournalRecord({ file->getSourceFileData() }, system, true));
+
 	if (Utils::FileSystem::exists(path))
 		return Utils::FileSystem::removeFile(path);
 
-	return false;
+	return ret;
 }
 
 bool hasDirtyFile(SystemData* system)
@@ -335,12 +387,11 @@ bool hasDirtyFile(SystemData* system)
 	return false;
 }
 
-void updateGamelist(SystemData* system)
+void updateGamelist(SystemData* system, bool forceCompaction)
 {
-	// We do this by reading the XML again, adding changes and then writing it back,
-	// because there might be information missing in our systemdata which would then miss in the new XML.
-	// We have the complete information for every game though, so we can simply remove a game
-	// we already have in the system from the XML, and then add it back from its GameData information...
+	// Changed files are appended to the system's journal, gamelist.xml is only rewritten when the journal is merged into it :
+	// the merge reads the XML again & replaces the nodes of the journaled files, because there might be information missing 
+	// in our systemdata which would then miss in the new XML.
 
 	if (system == nullptr || Settings::IgnoreGamelist())
 		return;
@@ -362,89 +413,29 @@ void updateGamelist(SystemData* system)
 		if (file->getSystem() == system && file->getMetadata().wasChanged())
 			dirtyFiles.push_back(file);
 
-	if (dirtyFiles.size() == 0)
-	{
-		clearTemporaryGamelistRecovery(system);
-		return;
-	}
-
-	int numUpdated = 0;
-
-	pugi::xml_document doc;
-	pugi::xml_node root;
-	std::string xmlReadPath = system->getGamelistPath(false);
-
-	if(Utils::FileSystem::exists(xmlReadPath))
+	if (dirtyFiles.size() > 0)
 	{
-		//parse an existing file first
-		pugi::xml_parse_result result = doc.load_file(xmlReadPath.c_str());
-		if(!result)
-			LOG(LogError) << "Error parsing XML file \"" << xmlReadPath << "\"!\n	" << result.description();
-
-		root = doc.child("gameList");
-		if(!root)
-		{
-			LOG(LogError) << "Could not find <gameList> node in gamelist \"" << xmlReadPath << "\"!";
-			root = doc.append_child("gameList");
-		}
-	}
-	else //set up an empty gamelist to append to		
-		root = doc.append_child("gameList");
+		system->incrementChangeCounter();
 
-	std::map<std::string, pugi::xml_node> xmlMap;
-
-	for (pugi::xml_node fileNode : root.children())
-	{
-		pugi::xml_node path = fileNode.child("path");
-		if (path)
-		{
-			std::string nodePath = Utils::FileSystem::getCanonicalPath(Utils::FileSystem::resolveRelativePath(path.text().get(), system->getStartPath(), true));
-			xmlMap[nodePath] = fileNode;
-		}
-	}
-	
-	// iterate through all files, checking if they're already in the XML
-	for(auto file : dirtyFiles)
-	{
-		bool removed = false;
+		if (!GamelistJournal::append(system, createJournalRecord(dirtyFiles, system)))
+			return;
 
-		// check if the file already exists in the XML
-		// if it does, remove it before adding
-		auto xmf = xmlMap.find(Utils::FileSystem::getCanonicalPath(file->getPath()));
-		if (xmf != xmlMap.cend())
-		{
-			removed = true;
-			root.remove_child(xmf->second);
-		}
-		
-		const char* tag = (file->getType() == GAME) ? "game" : "folder";
+		for (auto file : dirtyFiles)
+			file->getMetadata().resetChangedFlag();
 
-		// it was either removed or never existed to begin with; either way, we can add it now
-		if (addFileDataNode(root, file, tag, system))
-			++numUpdated; // Only if really added
-		else if (removed)
-			++numUpdated; // Only if really removed
+		LOG(LogInfo) << "Added/Updated " << dirtyFiles.size() << " entities in the gamelist journal of " << system->getName();
 	}
 
-	// Now write the file
-	if (numUpdated > 0) 
-	{
-		//make sure the folders leading up to this path exist (or the write will fail)
-		std::string xmlWritePath(system->getGamelistPath(true));
-		Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(xmlWritePath));
+	// The files of the temporary recovery were loaded as changed, they are in the journal now
+	clearTemporaryGamelistRecovery(system);
 
-		LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << xmlReadPath << "'";
+	if (!forceCompaction && Settings::getInstance()->getBool("GamelistJournal") && !GamelistJournal::needsCompaction(system))
+		return;
 
-		if (!doc.save_file(xmlWritePath.c_str()))
-			LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
-		else
-			clearTemporaryGamelistRecovery(system);
-	}
-	else
-		clearTemporaryGamelistRecovery(system);
+	if (GamelistJournal::compact(system))
+		GamelistCache::updateSnapshot(system);
 }
 
-
 void cleanupGamelist(SystemData* system)
 {
 	if (!system->isGameSystem() || system->isCollection() || (!Settings::HiddenSystemsShowGames() && !system->isVisible())) //  || system->hasPlatformId(PlatformIds::IMAGEVIEWER)
@@ -457,6 +448,9 @@ void cleanupGamelist(SystemData* system)
 		return;
 	}
 
+	// Pending changes must be in gamelist.xml before it's rewritten
+	GamelistJournal::compact(system);
+
 	std::string xmlReadPath = system->getGamelistPath(false);
 	if (!Utils::FileSystem::exists(xmlReadPath))
 		return;
@@ -9,11 +9,14 @@
 class SystemData;
 class FileData;
 
-// Loads gamelist.xml data into a SystemData.
-void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap);
+std::string getGamelistRecoveryPath(SystemData* system);
 
-// Writes currently loaded metadata for a SystemData to gamelist.xml.
-void updateGamelist(SystemData* system);
+// Loads gamelist.xml data into a SystemData. peakMemory receives the largest memory used by the xml reader.
+void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t* peakMemory = nullptr);
+
+// Writes currently changed metadata for a SystemData to its gamelist journal. 
+// The journal is merged into gamelist.xml when it's big enough, when forced or when the journal is disabled.
+void updateGamelist(SystemData* system, bool forceCompaction = false);
 void cleanupGamelist(SystemData* system);
 
 bool saveToGamelistRecovery(FileData* file);
@@ -23,6 +26,6 @@ bool saveToXml(FileData* file, const std::string& fileName, bool fullPaths = fal
 
 bool hasDirtyFile(SystemData* system);
 
-std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize = SIZE_MAX, bool fromFile = true);
+std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize = SIZE_MAX, bool fromFile = true, size_t* peakMemory = nullptr);
 
 #endif // ES_APP_GAME_LIST_H
@@ -0,0 +1,656 @@
+#include "GamelistCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "FileData.h"
+#include "Gamelist.h"
+#include "Log.h"
+#include "MetaData.h"
+#include "Paths.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SNAPSHOT_MAGIC		0x43475345 // "ESGC"
+#define SNAPSHOT_VERSION	1
+
+#define NODE_ABSOLUTE_PATH	0x80
+#define MD_HAS_RELATIVE_TO	0x01
+
+typedef std::vector<std::pair<std::string, time_t>> FolderStamps;
+
+struct LazyValueLocation
+{
+	MetaDataList* mdl;
+	MetaDataId id;
+	MetaDataLazyValue location;
+};
+
+// Read-only view on a snapshot file : memory mapped when the platform allows it
+class SnapshotFile
+{
+public:
+	SnapshotFile(const std::string& path) : mData(nullptr), mSize(0), mPos(0), mError(false), mMapped(false)
+	{
+#ifdef WIN32
+		std::ifstream f(WINSTRINGW(path), std::ios::binary | std::ios::ate);
+		if (f.fail())
+			return;
+
+		mBuffer.resize((size_t) f.tellg());
+		f.seekg(0, std::ios::beg);
+		if (mBuffer.size() > 0 && f.read((char*) mBuffer.data(), mBuffer.size()))
+		{
+			mData = mBuffer.data();
+			mSize = mBuffer.size();
+		}
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return;
+
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0)
+		{
+			void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED)
+			{
+				mData = (const unsigned char*) data;
+				mSize = info.st_size;
+				mMapped = true;
+			}
+		}
+
+		close(fd);
+#endif
+	}
+
+	~SnapshotFile()
+	{
+#ifndef WIN32
+		if (mMapped)
+			munmap((void*) mData, mSize);
+#endif
+	}
+
+	bool isValid() { return mData != nullptr && !mError; }
+
+	template<typename T> T read()
+	{
+		T value = T();
+		if (mError || mPos + sizeof(T) > mSize)
+		{
+			mError = true;
+			return value;
+		}
+
+		memcpy(&value, mData + mPos, sizeof(T));
+		mPos += sizeof(T);
+		return value;
+	}
+
+	std::string readString()
+	{
+		unsigned int length = read<unsigned int>();
+		if (mError || mPos + length > mSize)
+		{
+			mError = true;
+			return "";
+		}
+
+		std::string value((const char*) mData + mPos, length);
+		mPos += length;
+		return value;
+	}
+
+	// Moves past a string, only keeping its location in the file
+	bool skipString(unsigned int& offset, unsigned int& length)
+	{
+		length = read<unsigned int>();
+		if (mError || mPos + length > mSize)
+		{
+			mError = true;
+			return false;
+		}
+
+		offset = (unsigned int) mPos;
+		mPos += length;
+		return true;
+	}
+
+private:
+	const unsigned char* mData;
+	size_t mSize;
+	size_t mPos;
+	bool mError;
+	bool mMapped;
+	std::vector<unsigned char> mBuffer;
+};
+
+class SnapshotWriter
+{
+public:
+	template<typename T> void write(T value)
+	{
+		mBuffer.append((const char*) &value, sizeof(T));
+	}
+
+	void writeString(const std::string& value)
+	{
+		write<unsigned int>((unsigned int) value.size());
+		mBuffer.append(value);
+	}
+
+	size_t tell() const { return mBuffer.size(); }
+
+	bool save(const std::string& path)
+	{
+		std::string tmpPath = path + ".tmp";
+
+		std::ofstream f(WINSTRINGW(tmpPath), std::ios::binary | std::ios::trunc);
+		if (f.fail())
+			return false;
+
+		f.write(mBuffer.data(), mBuffer.size());
+		f.close();
+
+		if (f.fail())
+		{
+			remove(tmpPath.c_str());
+			return false;
+		}
+
+		// Write to a temporary file first, so a crash never leaves a truncated snapshot behind
+		remove(path.c_str());
+		return rename(tmpPath.c_str(), path.c_str()) == 0;
+	}
+
+private:
+	std::string mBuffer;
+};
+
+static time_t getModificationTime(const std::string& path)
+{
+	return Utils::FileSystem::getFileModificationDate(path).getTime();
+}
+
+static std::string getStoredPath(const std::string& path, const std::string& startPath, bool& absolute)
+{
+	absolute = false;
+
+	if (path.size() > startPath.size() + 1 && path[startPath.size()] == '/' && Utils::String::startsWith(path, startPath))
+		return path.substr(startPath.size() + 1);
+
+	absolute = true;
+	return path;
+}
+
+static bool readHeader(SnapshotFile& file, const std::string& configKey, std::string& gamelistPath, unsigned long long& gamelistSize, time_t& gamelistTime, int& xmlLoadTime)
+{
+	if (file.read<unsigned int>() != SNAPSHOT_MAGIC || file.read<unsigned int>() != SNAPSHOT_VERSION)
+		return false;
+
+	if (file.readString() != configKey)
+		return false;
+
+	gamelistPath = file.readString();
+	gamelistSize = file.read<unsigned long long>();
+	gamelistTime = (time_t) file.read<long long>();
+	xmlLoadTime = file.read<int>();
+
+	return file.isValid();
+}
+
+static bool readFolderStamps(SnapshotFile& file, const std::string& startPath, FolderStamps& folders)
+{
+	unsigned int count = file.read<unsigned int>();
+	for (unsigned int i = 0; i < count && file.isValid(); i++)
+	{
+		std::string path = file.readString();
+		time_t time = (time_t) file.read<long long>();
+
+		folders.push_back(std::pair<std::string, time_t>(path.empty() ? startPath : startPath + "/" + path, time));
+	}
+
+	return file.isValid();
+}
+
+static bool checkFolderStamps(const FolderStamps& folders)
+{
+	for (auto folder : folders)
+	{
+		if (getModificationTime(folder.first) != folder.second)
+		{
+			LOG(LogDebug) << "GamelistCache : folder " << folder.first << " has changed";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool GamelistCache::isEnabled(SystemData* system)
+{
+	if (!Settings::getInstance()->getBool("GamelistCache") || Settings::IgnoreGamelist())
+		return false;
+
+	// Hidden systems don't load their gamelist
+	return !system->isHidden() || Settings::HiddenSystemsShowGames();
+}
+
+std::string GamelistCache::getSnapshotPath(SystemData* system)
+{
+	return Paths::getUserEmulationStationPath() + "/cache/gamelists/" + system->getName() + ".cache";
+}
+
+std::string GamelistCache::getConfigurationKey(SystemData* system)
+{
+	// Every setting changing the result of the folder scan or of the gamelist parsing must be part of the key
+	bool showHidden = Settings::ShowHiddenFiles();
+
+	auto shv = Settings::getInstance()->getString(system->getName() + ".ShowHiddenFiles");
+	if (shv == "1") showHidden = true;
+	else if (shv == "0") showHidden = false;
+
+	std::string key = system->getName() + "|" + system->getStartPath() + "|";
+
+	for (auto ext : system->getExtensions())
+		key += ext + " ";
+
+	key += "|";
+
+	for (auto platformId : system->getPlatformIds())
+		key += std::to_string((int) platformId) + " ";
+
+	key += "|";
+	key += showHidden ? "1" : "0";
+	key += Settings::ParseGamelistOnly() ? "1" : "0";
+	key += Settings::PreloadMedias() ? "1" : "0";
+	key += Settings::RemoveMultiDiskContent() ? "1" : "0";
+
+	return key;
+}
+
+static void materializeLazyValues(FolderData* folder)
+{
+	for (auto item : folder->getChildren())
+	{
+		if (item->getMetadata().hasLazyValues())
+			item->getMetadata().materializeLazyValues();
+
+		if (item->getType() == FOLDER)
+			materializeLazyValues((FolderData*)item);
+	}
+}
+
+void GamelistCache::removeSnapshot(SystemData* system)
+{
+	// Values still in the file must be loaded before it disappears
+	if (system->mLazyValueStore != nullptr && system->mLazyValueStore->isOpen())
+	{
+		if (system->getRootFolder() != nullptr)
+			materializeLazyValues(system->getRootFolder());
+
+		system->mLazyValueStore->close();
+	}
+
+	std::string path = getSnapshotPath(system);
+	remove(path.c_str());
+}
+
+LazyValueStore* GamelistCache::getLazyValueStore(SystemData* system)
+{
+	if (!Settings::getInstance()->getBool("LazyMetadata"))
+		return nullptr;
+
+	if (system->mLazyValueStore == nullptr)
+		system->mLazyValueStore = std::unique_ptr<LazyValueStore>(new LazyValueStore());
+
+	return system->mLazyValueStore.get();
+}
+
+bool GamelistCache::loadSnapshot(SystemData* system)
+{
+	if (Settings::getInstance()->getBool("RebuildGamelistCache"))
+	{
+		LOG(LogInfo) << "GamelistCache : rebuilding snapshot for " << system->getName();
+		return false;
+	}
+
+	StopWatch stopWatch("GamelistCache::loadSnapshot - " + system->getName() + " :", LogDebug);
+
+	std::string snapshotPath = getSnapshotPath(system);
+
+	SnapshotFile file(snapshotPath);
+	if (!file.isValid())
+		return false;
+
+	const std::string startPath = system->getStartPath();
+
+	std::string gamelistPath;
+	unsigned long long gamelistSize;
+	time_t gamelistTime;
+	int xmlLoadTime;
+
+	if (!readHeader(file, getConfigurationKey(system), gamelistPath, gamelistSize, gamelistTime, xmlLoadTime))
+	{
+		LOG(LogDebug) << "GamelistCache : snapshot of " << system->getName() << " is obsolete";
+		return false;
+	}
+
+	// gamelist.xml must be the same file, with the same size & date
+	std::string xmlPath = system->getGamelistPath(false);
+	if (xmlPath != gamelistPath)
+		return false;
+
+	auto xmlSize = Utils::FileSystem::getFileSize(xmlPath);
+	if (xmlSize != gamelistSize || (xmlSize != 0 && getModificationTime(xmlPath) != gamelistTime))
+	{
+		LOG(LogDebug) << "GamelistCache : gamelist of " << system->getName() << " has changed";
+		return false;
+	}
+
+	// Pending recovery files need to be merged by the xml path
+	if (Utils::FileSystem::getDirContent(getGamelistRecoveryPath(system), true).size() > 0)
+		return false;
+
+	FolderStamps folders;
+	if (!readFolderStamps(file, startPath, folders) || !checkFolderStamps(folders))
+		return false;
+
+	LazyValueStore* lazyStore = getLazyValueStore(system);
+	if (lazyStore != nullptr && !lazyStore->open(snapshotPath))
+		lazyStore = nullptr;
+
+	FolderData* root = system->getRootFolder();
+	const unsigned int maxId = MetaDataList::getMDD().size() + 1;
+	unsigned int lazyCount = 0;
+
+	unsigned int count = file.read<unsigned int>();
+
+	std::vector<FileData*> nodes;
+	nodes.reserve(count);
+
+	for (unsigned int i = 0; i < count && file.isValid(); i++)
+	{
+		unsigned char type = file.read<unsigned char>();
+		unsigned int parentIndex = file.read<unsigned int>();
+		std::string path = file.readString();
+
+		if (!file.isValid() || parentIndex > i)
+			break;
+
+		FileData* parent = parentIndex == 0 ? root : nodes[parentIndex - 1];
+		if (parent->getType() != FOLDER)
+			break;
+
+		if ((type & NODE_ABSOLUTE_PATH) == 0)
+			path = startPath + "/" + path;
+
+		FileData* item;
+		if ((type & ~NODE_ABSOLUTE_PATH) == FOLDER)
+			item = new FolderData(path, system);
+		else
+			item = new FileData(GAME, path, system);
+
+		((FolderData*)parent)->addChild(item);
+		nodes.push_back(item);
+
+		MetaDataList& mdl = item->getMetadata();
+
+		unsigned char flags = file.read<unsigned char>();
+		if (flags & MD_HAS_RELATIVE_TO)
+			mdl.mRelativeTo = system;
+
+		mdl.mName = file.readString();
+
+		unsigned short mdCount = file.read<unsigned short>();
+		for (unsigned short m = 0; m < mdCount && file.isValid(); m++)
+		{
+			unsigned char id = file.read<unsigned char>();
+
+			if (lazyStore != nullptr && id < maxId && MetaDataList::isLazy((MetaDataId)id))
+			{
+				unsigned int offset, length;
+				if (file.skipString(offset, length))
+				{
+					mdl.setLazyValue((MetaDataId)id, lazyStore, offset, length);
+					lazyCount++;
+				}
+
+				continue;
+			}
+
+			std::string value = file.readString();
+			if (id < maxId)
+				mdl.setRawValue((MetaDataId)id, value);
+		}
+
+		unsigned short unknownCount = file.read<unsigned short>();
+		for (unsigned short m = 0; m < unknownCount && file.isValid(); m++)
+		{
+			std::string name = file.readString();
+			std::string value = file.readString();
+			bool isElement = file.read<unsigned char>() != 0;
+
+			mdl.mUnKnownElements.push_back(std::tuple<std::string, std::string, bool>(name, value, isElement));
+		}
+
+		unsigned char scrapeCount = file.read<unsigned char>();
+		for (unsigned char m = 0; m < scrapeCount && file.isValid(); m++)
+		{
+			int scraperId = file.read<unsigned char>();
+			time_t time = (time_t) file.read<long long>();
+			mdl.mScrapeDates[scraperId] = Utils::Time::DateTime(time);
+		}
+
+		mdl.resetChangedFlag();
+	}
+
+	if (!file.isValid() || nodes.size() != count)
+	{
+		LOG(LogWarning) << "GamelistCache : snapshot of " << system->getName() << " is corrupted";
+		root->clear();
+
+		if (lazyStore != nullptr)
+			lazyStore->close();
+
+		return false;
+	}
+
+	system->setGamelistHash(xmlSize);
+
+	LOG(LogInfo) << "GamelistCache : " << system->getName() << " loaded from snapshot (" << count << " entries, " << lazyCount << " values left in file, xml path was " << xmlLoadTime << "ms)";
+	return true;
+}
+
+void GamelistCache::writeNodes(SnapshotWriter& writer, FolderData* folder, unsigned int parentIndex, unsigned int& index, SystemData* system, std::vector<LazyValueLocation>* lazyValues)
+{
+	for (auto item : folder->getChildren())
+	{
+		bool absolute;
+		std::string path = getStoredPath(item->getPath(), system->getStartPath(), absolute);
+
+		writer.write<unsigned char>((unsigned char)item->getType() | (absolute ? NODE_ABSOLUTE_PATH : 0));
+		writer.write<unsigned int>(parentIndex);
+		writer.writeString(path);
+
+		writeMetadata(writer, item->getMetadata(), system, lazyValues);
+
+		unsigned int itemIndex = ++index;
+
+		if (item->getType() == FOLDER)
+			writeNodes(writer, (FolderData*)item, itemIndex, index, system, lazyValues);
+	}
+}
+
+void GamelistCache::writeMetadata(SnapshotWriter& writer, MetaDataList& mdl, SystemData* system, std::vector<LazyValueLocation>* lazyValues)
+{
+	writer.write<unsigned char>(mdl.mRelativeTo == system ? MD_HAS_RELATIVE_TO : 0);
+	writer.writeString(mdl.mName);
+
+	auto values = mdl.getRawValues();
+
+	writer.write<unsigned short>((unsigned short)values.size());
+	for (auto& md : values)
+	{
+		writer.write<unsigned char>((unsigned char)md.first);
+
+		if (lazyValues != nullptr && MetaDataList::isLazy(md.first))
+		{
+			LazyValueLocation lazy;
+			lazy.mdl = &mdl;
+			lazy.id = md.first;
+			lazy.location.offset = (unsigned int)(writer.tell() + sizeof(unsigned int));
+			lazy.location.length = (unsigned int)md.second.size();
+			lazyValues->push_back(lazy);
+		}
+
+		writer.writeString(md.second);
+	}
+
+	writer.write<unsigned short>((unsigned short)mdl.mUnKnownElements.size());
+	for (auto& element : mdl.mUnKnownElements)
+	{
+		writer.writeString(std::get<0>(element));
+		writer.writeString(std::get<1>(element));
+		writer.write<unsigned char>(std::get<2>(element) ? 1 : 0);
+	}
+
+	writer.write<unsigned char>((unsigned char)mdl.mScrapeDates.size());
+	for (auto& scrapeDate : mdl.mScrapeDates)
+	{
+		writer.write<unsigned char>((unsigned char)scrapeDate.first);
+		writer.write<long long>((long long)scrapeDate.second.getTime());
+	}
+}
+
+static unsigned int countNodes(FolderData* folder)
+{
+	unsigned int count = 0;
+
+	for (auto item : folder->getChildren())
+	{
+		count++;
+
+		if (item->getType() == FOLDER)
+			count += countNodes((FolderData*)item);
+	}
+
+	return count;
+}
+
+bool GamelistCache::writeSnapshot(SystemData* system, const std::vector<std::pair<std::string, time_t>>& folders, int xmlLoadTime)
+{
+	FolderData* root = system->getRootFolder();
+	if (root == nullptr)
+		return false;
+
+	const std::string startPath = system->getStartPath();
+
+	std::string xmlPath = system->getGamelistPath(false);
+	auto xmlSize = Utils::FileSystem::getFileSize(xmlPath);
+
+	SnapshotWriter writer;
+	writer.write<unsigned int>(SNAPSHOT_MAGIC);
+	writer.write<unsigned int>(SNAPSHOT_VERSION);
+	writer.writeString(getConfigurationKey(system));
+	writer.writeString(xmlPath);
+	writer.write<unsigned long long>(xmlSize);
+	writer.write<long long>(xmlSize == 0 ? 0 : (long long)getModificationTime(xmlPath));
+	writer.write<int>(xmlLoadTime);
+
+	writer.write<unsigned int>((unsigned int)folders.size());
+	for (auto folder : folders)
+	{
+		bool absolute;
+		writer.writeString(folder.first == startPath ? "" : getStoredPath(folder.first, startPath, absolute));
+		writer.write<long long>((long long)folder.second);
+	}
+
+	LazyValueStore* lazyStore = getLazyValueStore(system);
+	std::vector<LazyValueLocation> lazyValues;
+
+	unsigned int index = 0;
+	writer.write<unsigned int>(countNodes(root));
+	writeNodes(writer, root, 0, index, system, lazyStore != nullptr ? &lazyValues : nullptr);
+
+	std::string path = getSnapshotPath(system);
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+
+	if (!writer.save(path))
+	{
+		LOG(LogError) << "GamelistCache : unable to write snapshot " << path;
+		return false;
+	}
+
+	// Values that were already lazy now live in the new file : point them to their new location.
+	// Other values stay in memory until the next load, as games can be read from other threads while this runs
+	if (lazyStore != nullptr)
+	{
+		lazyStore->reopen(path, [&lazyValues, lazyStore]
+		{
+			for (auto& lazy : lazyValues)
+				lazy.mdl->relocateLazyValue(lazy.id, lazyStore, lazy.location.offset, lazy.location.length);
+		});
+	}
+
+	return true;
+}
+
+bool GamelistCache::saveSnapshot(SystemData* system, int xmlLoadTime)
+{
+	FolderStamps folders;
+
+	if (system->mScannedFolders != nullptr)
+	{
+		for (auto folder : *system->mScannedFolders)
+			if (folder.first == system->getStartPath() || Utils::String::startsWith(folder.first, system->getStartPath() + "/"))
+				folders.push_back(folder);
+
+		system->mScannedFolders.reset();
+	}
+
+	return writeSnapshot(system, folders, xmlLoadTime);
+}
+
+bool GamelistCache::updateSnapshot(SystemData* system)
+{
+	if (!isEnabled(system))
+		return false;
+
+	std::string path = getSnapshotPath(system);
+
+	std::string gamelistPath;
+	unsigned long long gamelistSize;
+	time_t gamelistTime;
+	int xmlLoadTime;
+	FolderStamps folders;
+
+	{
+		SnapshotFile file(path);
+		if (!file.isValid())
+			return false;
+
+		if (!readHeader(file, getConfigurationKey(system), gamelistPath, gamelistSize, gamelistTime, xmlLoadTime) || !readFolderStamps(file, system->getStartPath(), folders))
+			return false;
+	}
+
+	// Files may have been added or removed since startup : the current tree is no more a faithful scan, let the next boot rebuild it
+	if (!checkFolderStamps(folders))
+	{
+		removeSnapshot(system);
+		return false;
+	}
+
+	return writeSnapshot(system, folders, xmlLoadTime);
+}
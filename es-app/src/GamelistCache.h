@@ -0,0 +1,45 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_CACHE_H
+#define ES_APP_GAMELIST_CACHE_H
+
+#include <string>
+#include <vector>
+#include <time.h>
+
+class SystemData;
+class FolderData;
+class MetaDataList;
+class SnapshotWriter;
+class LazyValueStore;
+struct LazyValueLocation;
+
+// Binary snapshot of a system's FolderData/FileData tree, taken after the rom folder scan & the gamelist.xml parsing.
+// On the next boot, the tree is rebuilt directly from the snapshot as long as gamelist.xml (size & mtime) and the scanned folders (mtime) did not change.
+class GamelistCache
+{
+public:
+	// Rebuilds the system's root folder from its snapshot. Returns false if the snapshot is missing or stale.
+	static bool loadSnapshot(SystemData* system);
+
+	// Writes the snapshot of the system's current tree. xmlLoadTime is the duration of the folder scan + xml parsing, kept for comparison logs.
+	static bool saveSnapshot(SystemData* system, int xmlLoadTime = -1);
+
+	// Refreshes the snapshot after gamelist.xml has been rewritten, only if the rom folders have not been touched since it was taken.
+	static bool updateSnapshot(SystemData* system);
+
+	static void removeSnapshot(SystemData* system);
+
+	static bool isEnabled(SystemData* system);
+
+private:
+	static std::string getSnapshotPath(SystemData* system);
+	static std::string getConfigurationKey(SystemData* system);
+
+	static bool writeSnapshot(SystemData* system, const std::vector<std::pair<std::string, time_t>>& folders, int xmlLoadTime);
+	static void writeNodes(SnapshotWriter& writer, FolderData* folder, unsigned int parentIndex, unsigned int& index, SystemData* system, std::vector<LazyValueLocation>* lazyValues);
+	static void writeMetadata(SnapshotWriter& writer, MetaDataList& mdl, SystemData* system, std::vector<LazyValueLocation>* lazyValues);
+
+	static LazyValueStore* getLazyValueStore(SystemData* system);
+};
+
+#endif // ES_APP_GAMELIST_CACHE_H
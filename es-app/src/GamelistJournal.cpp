@@ -0,0 +1,502 @@
+#include "GamelistJournal.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "utils/ThreadPool.h"
+#include "FileData.h"
+#include "Gamelist.h"
+#include "GamelistCache.h"
+#include "Log.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include <pugixml/src/pugixml.hpp>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define JOURNAL_SIGNATURE			"ESGJ2 "
+#define JOURNAL_SIGNATURE_V1		"ESGJ1 "		// base stamp was the size only
+#define JOURNAL_MIN_COMPACTION_SIZE	(64 * 1024)
+
+static std::mutex sJournalLock;		// appends, reads & journal file replacement
+static std::mutex sCompactLock;		// one compaction at a time
+static std::set<std::string> sCompacting;
+static std::vector<SystemData*> sCompacted;	// finished background compactions, applied by the main thread
+
+static Utils::TaskGroup* getCompactions()
+{
+	// Never destroyed, waitForCompactions is called before the systems are deleted
+	static Utils::TaskGroup* compactions = new Utils::TaskGroup(Utils::TaskPriority::Low);
+	return compactions;
+}
+
+static unsigned int hashRecord(const char* data, size_t size)
+{
+	unsigned int hash = 2166136261U;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static unsigned long long getBaseSize(const std::string& xmlPath)
+{
+	return Utils::FileSystem::exists(xmlPath) ? Utils::FileSystem::getFileSize(xmlPath) : 0;
+}
+
+// Identifies the gamelist.xml a journal was started on : size & modification time
+static std::string getBaseStamp(const std::string& xmlPath)
+{
+	unsigned long long size = 0;
+	time_t modificationTime = 0;
+
+	if (!Utils::FileSystem::getFileSizeAndModificationTime(xmlPath, &size, &modificationTime))
+		return "0 0";
+
+	return std::to_string(size) + " " + std::to_string((long long)modificationTime);
+}
+
+// Keeps a journal that can't be read for investigation, instead of losing the changes it holds
+static void setAside(const std::string& path)
+{
+	std::string asidePath = path + "." + std::to_string((long long)time(NULL)) + ".bad";
+
+	if (Utils::FileSystem::renameFile(path, asidePath, false))
+		LOG(LogError) << "GamelistJournal : \"" << path << "\" can't be read, moved to \"" << asidePath << "\"";
+	else
+		LOG(LogError) << "GamelistJournal : \"" << path << "\" can't be read";
+}
+
+static unsigned long long getCompactionThreshold(unsigned long long xmlSize)
+{
+	return std::max<unsigned long long>(JOURNAL_MIN_COMPACTION_SIZE, xmlSize / 8);
+}
+
+static bool readFile(const std::string& path, std::string& data)
+{
+	std::ifstream f(WINSTRINGW(path), std::ios::binary | std::ios::ate);
+	if (f.fail())
+		return false;
+
+	data.resize((size_t)f.tellg());
+	f.seekg(0, std::ios::beg);
+
+	return data.empty() || f.read(&data[0], data.size());
+}
+
+// Atomically replaces dst
+static bool replaceFile(const std::string& src, const std::string& dst)
+{
+#ifdef WIN32
+	return Utils::FileSystem::renameFile(src, dst, true);
+#else
+	return Utils::FileSystem::renameFile(src, dst, false);
+#endif
+}
+
+static bool writeFile(const std::string& path, const std::string& data)
+{
+	std::string tmpPath = path + ".tmp";
+
+	std::ofstream f(WINSTRINGW(tmpPath), std::ios::binary | std::ios::trunc);
+	if (f.fail())
+		return false;
+
+	f.write(data.data(), data.size());
+	f.close();
+
+	if (f.fail())
+	{
+		Utils::FileSystem::removeFile(tmpPath);
+		return false;
+	}
+
+	return replaceFile(tmpPath, path);
+}
+
+// Appends & syncs, a crash can only leave a truncated last record which is dropped on the next replay
+static bool appendFile(const std::string& path, const std::string& data)
+{
+#ifdef WIN32
+	FILE* file = _wfopen(Utils::String::convertToWideString(path).c_str(), L"ab");
+#else
+	FILE* file = fopen(path.c_str(), "ab");
+#endif
+	if (file == nullptr)
+		return false;
+
+	bool ret = fwrite(data.data(), 1, data.size(), file) == data.size() && fflush(file) == 0;
+
+#ifdef WIN32
+	ret = ret && _commit(_fileno(file)) == 0;
+#else
+	ret = ret && fsync(fileno(file)) == 0;
+#endif
+
+	fclose(file);
+	return ret;
+}
+
+std::string GamelistJournal::getJournalPath(SystemData* system)
+{
+	return getGamelistRecoveryPath(system) + ".journal";
+}
+
+std::string GamelistJournal::formatHeader(const std::string& baseStamp)
+{
+	return JOURNAL_SIGNATURE + baseStamp + "\n";
+}
+
+std::string GamelistJournal::formatRecord(const std::string& record)
+{
+	char header[64];
+	snprintf(header, sizeof(header), "%llu %08x\n", (unsigned long long)record.size(), hashRecord(record.data(), record.size()));
+	return header + record + "\n";
+}
+
+bool GamelistJournal::parse(const std::string& data, std::string& baseStamp, std::vector<std::string>& records, size_t& validLength)
+{
+	records.clear();
+	validLength = 0;
+
+	if (!Utils::String::startsWith(data, JOURNAL_SIGNATURE) && !Utils::String::startsWith(data, JOURNAL_SIGNATURE_V1))
+		return false;
+
+	size_t eol = data.find('\n');
+	if (eol == std::string::npos)
+		return false;
+
+	// Both signatures have the same length. A V1 stamp never matches : its records are replayed over the current gamelist.xml
+	baseStamp = data.substr(strlen(JOURNAL_SIGNATURE), eol - strlen(JOURNAL_SIGNATURE));
+	if (Utils::String::startsWith(data, JOURNAL_SIGNATURE_V1))
+		baseStamp = "v1 " + baseStamp;
+
+	size_t pos = eol + 1;
+	validLength = pos;
+
+	while (pos < data.size())
+	{
+		eol = data.find('\n', pos);
+		if (eol == std::string::npos)
+			break;
+
+		unsigned long long length = 0;
+		unsigned int hash = 0;
+		if (sscanf(data.c_str() + pos, "%llu %x", &length, &hash) != 2)
+			break;
+
+		size_t start = eol + 1;
+		if (length >= data.size() - start || data[start + length] != '\n')
+			break;
+
+		if (hashRecord(data.c_str() + start, (size_t)length) != hash)
+			break;
+
+		records.push_back(data.substr(start, (size_t)length));
+
+		pos = start + (size_t)length + 1;
+		validLength = pos;
+	}
+
+	return true;
+}
+
+bool GamelistJournal::exists(SystemData* system)
+{
+	return Utils::FileSystem::getFileSize(getJournalPath(system)) > 0;
+}
+
+bool GamelistJournal::needsCompaction(SystemData* system)
+{
+	unsigned long long size = Utils::FileSystem::getFileSize(getJournalPath(system));
+	return size > 0 && size >= getCompactionThreshold(getBaseSize(system->getGamelistPath(false)));
+}
+
+bool GamelistJournal::append(SystemData* system, const std::string& record)
+{
+	if (system == nullptr || record.empty())
+		return false;
+
+	std::string path = getJournalPath(system);
+	std::string xmlPath = system->getGamelistPath(false);
+
+	std::unique_lock<std::mutex> lock(sJournalLock);
+
+	std::string data;
+
+	// A new journal applies to the gamelist.xml as it is now
+	if (Utils::FileSystem::getFileSize(path) == 0)
+	{
+		Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+		data = formatHeader(getBaseStamp(xmlPath));
+	}
+
+	data += formatRecord(record);
+
+	if (!appendFile(path, data))
+	{
+		LOG(LogError) << "GamelistJournal : Error writing to \"" << path << "\"";
+		return false;
+	}
+
+	if (!Settings::getInstance()->getBool("GamelistJournal"))
+		return true;
+
+	if (Utils::FileSystem::getFileSize(path) < getCompactionThreshold(getBaseSize(xmlPath)) || !sCompacting.insert(path).second)
+		return true;
+
+	std::string xmlWritePath = system->getGamelistPath(true);
+	std::string startPath = system->getStartPath();
+
+	LOG(LogDebug) << "GamelistJournal : background compaction of " << system->getName();
+
+	getCompactions()->queue([system, path, xmlPath, xmlWritePath, startPath]
+	{
+		bool compacted = compactFiles(path, xmlPath, xmlWritePath, startPath);
+
+		std::unique_lock<std::mutex> lock(sJournalLock);
+		sCompacting.erase(path);
+
+		if (compacted)
+			sCompacted.push_back(system);
+	});
+
+	return true;
+}
+
+bool GamelistJournal::replay(SystemData* system)
+{
+	FolderData* root = system->getRootFolder();
+	if (root == nullptr || !exists(system))
+		return false;
+
+	std::unordered_map<std::string, FileData*> fileMap;
+	fileMap[root->getPath()] = root;
+
+	for (auto file : root->getFilesRecursive(GAME | FOLDER, false, nullptr, false))
+		fileMap[file->getPath()] = file;
+
+	return replay(system, fileMap);
+}
+
+bool GamelistJournal::replay(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap)
+{
+	std::string path = getJournalPath(system);
+
+	std::vector<std::string> records;
+
+	{
+		std::unique_lock<std::mutex> lock(sJournalLock);
+
+		std::string data;
+		if (!readFile(path, data) || data.empty())
+			return false;
+
+		std::string baseStamp;
+		size_t validLength = 0;
+
+		if (!parse(data, baseStamp, records, validLength))
+		{
+			setAside(path);
+			return false;
+		}
+
+		// Records hold the whole state of their games : they apply by <path> over any gamelist.xml, the last one wins
+		if (baseStamp != getBaseStamp(system->getGamelistPath(false)))
+			LOG(LogWarning) << "GamelistJournal : gamelist.xml of " << system->getName() << " was changed since its journal was started. Replaying the journal over it";
+
+		if (validLength < data.size())
+		{
+			LOG(LogWarning) << "GamelistJournal : dropping the incomplete last record of " << system->getName();
+			writeFile(path, data.substr(0, validLength));
+		}
+	}
+
+	for (auto& record : records)
+		loadGamelistFile(record, system, fileMap, SIZE_MAX, false);
+
+	LOG(LogInfo) << "GamelistJournal : " << records.size() << " change(s) replayed for " << system->getName();
+	return records.size() > 0;
+}
+
+bool GamelistJournal::compact(SystemData* system)
+{
+	std::string path = getJournalPath(system);
+	if (!Utils::FileSystem::exists(path))
+		return false;
+
+	if (!compactFiles(path, system->getGamelistPath(false), system->getGamelistPath(true), system->getStartPath()))
+		return false;
+
+	system->setGamelistHash(getBaseSize(system->getGamelistPath(false)));
+	return true;
+}
+
+void GamelistJournal::waitForCompactions()
+{
+	getCompactions()->wait();
+	processCompletedCompactions();
+}
+
+void GamelistJournal::processCompletedCompactions()
+{
+	std::vector<SystemData*> systems;
+
+	{
+		std::unique_lock<std::mutex> lock(sJournalLock);
+		if (sCompacted.empty())
+			return;
+
+		systems.swap(sCompacted);
+	}
+
+	std::sort(systems.begin(), systems.end());
+	systems.erase(std::unique(systems.begin(), systems.end()), systems.end());
+
+	// gamelist.xml was rewritten : the snapshot & the parentHash of the recovery files must follow its new size
+	for (auto system : systems)
+	{
+		system->setGamelistHash(getBaseSize(system->getGamelistPath(false)));
+		GamelistCache::updateSnapshot(system);
+	}
+}
+
+bool GamelistJournal::compactFiles(const std::string& journalPath, const std::string& xmlReadPath, const std::string& xmlWritePath, const std::string& startPath)
+{
+	std::unique_lock<std::mutex> compactLock(sCompactLock);
+
+	std::string data;
+	std::vector<std::string> records;
+	std::string baseStamp;
+	size_t validLength = 0;
+
+	{
+		std::unique_lock<std::mutex> lock(sJournalLock);
+
+		if (!readFile(journalPath, data) || data.empty())
+			return false;
+
+		if (!parse(data, baseStamp, records, validLength))
+		{
+			setAside(journalPath);
+			return false;
+		}
+
+		// Merged by <path> like any other record : external changes to other games are kept
+		if (baseStamp != getBaseStamp(xmlReadPath))
+			LOG(LogWarning) << "GamelistJournal : \"" << xmlReadPath << "\" was changed since its journal was started. Merging the journal into it";
+	}
+
+	pugi::xml_document doc;
+	pugi::xml_node root;
+
+	if (Utils::FileSystem::exists(xmlReadPath))
+	{
+		pugi::xml_parse_result result = doc.load_file(xmlReadPath.c_str());
+		if (!result)
+			LOG(LogError) << "Error parsing XML file \"" << xmlReadPath << "\"!\n	" << result.description();
+
+		root = doc.child("gameList");
+	}
+
+	if (!root)
+		root = doc.append_child("gameList");
+
+	std::map<std::string, pugi::xml_node> xmlMap;
+
+	for (pugi::xml_node fileNode : root.children())
+	{
+		pugi::xml_node path = fileNode.child("path");
+		if (path)
+			xmlMap[Utils::FileSystem::getCanonicalPath(Utils::FileSystem::resolveRelativePath(path.text().get(), startPath, true))] = fileNode;
+	}
+
+	int numUpdated = 0;
+
+	for (auto& record : records)
+	{
+		pugi::xml_document recordDoc;
+		if (!recordDoc.load_buffer(record.data(), record.size()))
+			continue;
+
+		for (pugi::xml_node fileNode : recordDoc.child("gameList").children())
+		{
+			pugi::xml_node path = fileNode.child("path");
+			if (!path)
+				continue;
+
+			std::string key = Utils::FileSystem::getCanonicalPath(Utils::FileSystem::resolveRelativePath(path.text().get(), startPath, true));
+
+			auto xmf = xmlMap.find(key);
+			if (xmf != xmlMap.cend())
+			{
+				root.remove_child(xmf->second);
+				xmlMap.erase(xmf);
+			}
+
+			// A node with nothing else than its path only removes the entry
+			if (path.next_sibling() || path.previous_sibling() || fileNode.first_attribute())
+				xmlMap[key] = root.append_copy(fileNode);
+
+			numUpdated++;
+		}
+	}
+
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(xmlWritePath));
+
+	std::string tmpPath = xmlWritePath + ".tmp";
+	if (!doc.save_file(tmpPath.c_str()))
+	{
+		LOG(LogError) << "Error saving gamelist.xml to \"" << tmpPath << "\"!";
+		Utils::FileSystem::removeFile(tmpPath);
+		return false;
+	}
+
+	std::unique_lock<std::mutex> lock(sJournalLock);
+
+	// Records appended while merging are kept for the next compaction
+	std::string current;
+	std::vector<std::string> tail;
+	if (readFile(journalPath, current) && current.size() > validLength)
+	{
+		std::string dummy;
+		size_t tailLength;
+		parse(formatHeader("0 0") + current.substr(validLength), dummy, tail, tailLength);
+	}
+
+	// gamelist.xml first : if we crash before the journal is replaced, the old records are replayed over the new gamelist.xml, which already holds them
+	if (!replaceFile(tmpPath, xmlWritePath))
+	{
+		LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\"!";
+		Utils::FileSystem::removeFile(tmpPath);
+		return false;
+	}
+
+	if (tail.size() == 0)
+		Utils::FileSystem::removeFile(journalPath);
+	else
+	{
+		std::string newJournal = formatHeader(getBaseStamp(xmlWritePath));
+		for (auto& record : tail)
+			newJournal += formatRecord(record);
+
+		writeFile(journalPath, newJournal);
+	}
+
+	LOG(LogInfo) << "GamelistJournal : merged " << numUpdated << " change(s) into \"" << xmlWritePath << "\"";
+	return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_JOURNAL_H
+#define ES_APP_GAMELIST_JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class SystemData;
+class FileData;
+
+// Append-only journal of the gamelist changes of a system, stored next to its recovery folder.
+// Each record is a small <gameList> document holding the last known state of the changed games ; a <game> with only a <path> removes the entry.
+// Records are appended & synced after each change, replayed over gamelist.xml on boot, and merged into gamelist.xml (compaction)
+// in the background once the journal grows, and at shutdown or when the gamelist is explicitly saved.
+class GamelistJournal
+{
+public:
+	static bool append(SystemData* system, const std::string& record);
+
+	// Applies the journal over the loaded tree. Returns false if there was nothing to apply.
+	static bool replay(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap);
+	static bool replay(SystemData* system);
+
+	// Merges the journal into gamelist.xml & removes it. Waits for a running background compaction.
+	static bool compact(SystemData* system);
+
+	static bool needsCompaction(SystemData* system);
+	static bool exists(SystemData* system);
+
+	// Waits for the background compactions & applies their results
+	static void waitForCompactions();
+
+	// Main thread. Updates the gamelist hash & snapshot of the systems compacted in the background
+	static void processCompletedCompactions();
+
+	static std::string getJournalPath(SystemData* system);
+
+private:
+	static bool compactFiles(const std::string& journalPath, const std::string& xmlReadPath, const std::string& xmlWritePath, const std::string& startPath);
+
+	static bool parse(const std::string& data, std::string& baseStamp, std::vector<std::string>& records, size_t& validLength);
+	static std::string formatHeader(const std::string& baseStamp);
+	static std::string formatRecord(const std::string& record);
+};
+
+#endif // ES_APP_GAMELIST_JOURNAL_H
@@ -0,0 +1,289 @@
+#include "GamelistStreamReader.h"
+
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include <algorithm>
+#include <string.h>
+
+#define READ_CHUNK_SIZE (64 * 1024)
+
+GamelistStreamReader::GamelistStreamReader() : mFile(nullptr), mData(nullptr), mSize(0), mPos(0), mDepth(0), mPeakMemory(0)
+{
+}
+
+GamelistStreamReader::~GamelistStreamReader()
+{
+	if (mFile != nullptr)
+		fclose(mFile);
+}
+
+bool GamelistStreamReader::openFile(const std::string& path)
+{
+#ifdef WIN32
+	mFile = _wfopen(Utils::String::convertToWideString(path).c_str(), L"rb");
+#else
+	mFile = fopen(path.c_str(), "rb");
+#endif
+
+	if (mFile == nullptr)
+	{
+		mError = "File was not found";
+		return false;
+	}
+
+	return true;
+}
+
+void GamelistStreamReader::openString(const std::string& xml)
+{
+	mData = xml.c_str();
+	mSize = xml.size();
+}
+
+bool GamelistStreamReader::fill()
+{
+	if (mFile == nullptr)
+		return false;
+
+	size_t size = mBuffer.size();
+	mBuffer.resize(size + READ_CHUNK_SIZE);
+
+	size_t read = fread(&mBuffer[size], 1, READ_CHUNK_SIZE, mFile);
+	mBuffer.resize(size + read);
+
+	mData = mBuffer.c_str();
+	mSize = mBuffer.size();
+
+	if (read == 0)
+	{
+		fclose(mFile);
+		mFile = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+// Drops what was read before the current position, the buffer only grows to hold one entry
+void GamelistStreamReader::discardConsumed()
+{
+	if (mFile == nullptr || mPos < READ_CHUNK_SIZE)
+		return;
+
+	mBuffer.erase(0, mPos);
+	mData = mBuffer.c_str();
+	mSize = mBuffer.size();
+	mPos = 0;
+}
+
+size_t GamelistStreamReader::find(size_t from, const char* pattern) const
+{
+	size_t len = strlen(pattern);
+	if (from >= mSize)
+		return std::string::npos;
+
+	const char* ret = std::search(mData + from, mData + mSize, pattern, pattern + len);
+	if (ret == mData + mSize)
+		return std::string::npos;
+
+	return (ret - mData) + len;
+}
+
+bool GamelistStreamReader::findTokenEnd(TokenType& type, size_t& end)
+{
+	// Enough characters to know what kind of token it is
+	if (mSize - mPos < 9 && mFile != nullptr)
+		return false;
+
+	const char* token = mData + mPos;
+	size_t available = mSize - mPos;
+
+	if (available >= 2 && token[1] == '?')
+	{
+		type = TOKEN_OTHER;
+		end = find(mPos + 2, "?>");
+	}
+	else if (available >= 4 && strncmp(token, "<!--", 4) == 0)
+	{
+		type = TOKEN_OTHER;
+		end = find(mPos + 4, "-->");
+	}
+	else if (available >= 9 && strncmp(token, "<![CDATA[", 9) == 0)
+	{
+		type = TOKEN_OTHER;
+		end = find(mPos + 9, "]]>");
+	}
+	else if (available >= 2 && token[1] == '!')
+	{
+		type = TOKEN_OTHER;
+		end = find(mPos + 2, ">");
+	}
+	else if (available >= 2 && token[1] == '/')
+	{
+		type = TOKEN_END;
+		end = find(mPos + 2, ">");
+	}
+	else
+	{
+		// Start tag, '>' can be found in the attribute values
+		type = TOKEN_START;
+		end = std::string::npos;
+
+		char quote = 0;
+		for (size_t i = mPos + 1; i < mSize; i++)
+		{
+			char c = mData[i];
+
+			if (quote != 0)
+			{
+				if (c == quote)
+					quote = 0;
+			}
+			else if (c == '"' || c == '\'')
+				quote = c;
+			else if (c == '>')
+			{
+				end = i + 1;
+				if (mData[i - 1] == '/')
+					type = TOKEN_EMPTY;
+
+				break;
+			}
+		}
+	}
+
+	return end != std::string::npos;
+}
+
+GamelistStreamReader::TokenType GamelistStreamReader::readToken(size_t& end)
+{
+	// Skip text
+	while (true)
+	{
+		const char* lt = mPos < mSize ? (const char*)memchr(mData + mPos, '<', mSize - mPos) : nullptr;
+		if (lt != nullptr)
+		{
+			mPos = lt - mData;
+			break;
+		}
+
+		mPos = mSize;
+		if (!fill())
+		{
+			// Still inside <gameList>
+			if (mDepth > 0)
+				mError = "Unexpected end of document";
+
+			return TOKEN_NONE;
+		}
+	}
+
+	TokenType type;
+	while (!findTokenEnd(type, end))
+	{
+		if (!fill() && !findTokenEnd(type, end))
+		{
+			mError = "Unexpected end of document";
+			return TOKEN_NONE;
+		}
+	}
+
+	return type;
+}
+
+bool GamelistStreamReader::readRoot()
+{
+	while (true)
+	{
+		size_t end;
+		TokenType type = readToken(end);
+		if (type == TOKEN_NONE)
+			return false;
+
+		if (type == TOKEN_OTHER)
+		{
+			mPos = end;
+			continue;
+		}
+
+		if (type != TOKEN_START && type != TOKEN_EMPTY)
+			return false;
+
+		std::string tag(mData + mPos, end - mPos);
+		mPos = end;
+
+		size_t nameEnd = tag.find_first_of(" \t\r\n/>", 1);
+		if (tag.substr(1, nameEnd - 1) != "gameList")
+			return false;
+
+		// Keep the root attributes : parse its start tag as an empty element
+		if (type == TOKEN_START)
+			tag.insert(tag.size() - 1, "/");
+
+		mRootDoc.load_buffer(tag.data(), tag.size());
+		mDepth = (type == TOKEN_START ? 1 : 0);
+		return true;
+	}
+}
+
+pugi::xml_attribute GamelistStreamReader::getRootAttribute(const char* name) const
+{
+	return mRootDoc.first_child().attribute(name);
+}
+
+bool GamelistStreamReader::next(pugi::xml_node& node)
+{
+	while (mDepth == 1)
+	{
+		discardConsumed();
+
+		size_t end;
+		TokenType type = readToken(end);
+		if (type == TOKEN_NONE)
+			return false;
+
+		if (type == TOKEN_END)
+		{
+			mDepth = 0;
+			return false;
+		}
+
+		size_t entryStart = mPos;
+		mPos = end;
+
+		if (type == TOKEN_OTHER)
+			continue;
+
+		// Find the end of the element. Only offsets are kept, the buffer can move while reading
+		for (int depth = (type == TOKEN_START ? 1 : 0); depth > 0; )
+		{
+			type = readToken(end);
+			if (type == TOKEN_NONE)
+				return false;
+
+			if (type == TOKEN_START)
+				depth++;
+			else if (type == TOKEN_END)
+				depth--;
+
+			mPos = end;
+		}
+
+		size_t entrySize = mPos - entryStart;
+		mPeakMemory = std::max(mPeakMemory, mBuffer.capacity() + entrySize * 2);
+
+		mEntryDoc.reset();
+
+		pugi::xml_parse_result result = mEntryDoc.load_buffer(mData + entryStart, entrySize);
+		if (!result)
+		{
+			LOG(LogWarning) << "GamelistStreamReader : skipping invalid entry : " << result.description();
+			continue;
+		}
+
+		node = mEntryDoc.first_child();
+		return true;
+	}
+
+	return false;
+}
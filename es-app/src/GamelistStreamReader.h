@@ -0,0 +1,64 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_STREAM_READER_H
+#define ES_APP_GAMELIST_STREAM_READER_H
+
+#include <string>
+#include <stdio.h>
+#include <pugixml/src/pugixml.hpp>
+
+// Reads a <gameList> document one entry at a time : files are read by chunks & only the current child element of the root
+// is parsed into a DOM, so memory stays bounded by the largest <game> instead of the whole gamelist.
+class GamelistStreamReader
+{
+public:
+	GamelistStreamReader();
+	~GamelistStreamReader();
+
+	bool openFile(const std::string& path);
+	void openString(const std::string& xml); // xml must outlive the reader
+
+	// Moves to the <gameList> root element. Returns false if the document has no such root
+	bool readRoot();
+	pugi::xml_attribute getRootAttribute(const char* name) const;
+
+	// Parses the next child of the root. The node stays valid until the next call
+	bool next(pugi::xml_node& node);
+
+	const std::string& getError() const { return mError; }
+
+	// Read buffer + parsed copy of the largest entry
+	size_t getPeakMemory() const { return mPeakMemory; }
+
+private:
+	enum TokenType
+	{
+		TOKEN_NONE,
+		TOKEN_START,	// <tag>
+		TOKEN_EMPTY,	// <tag/>
+		TOKEN_END,		// </tag>
+		TOKEN_OTHER		// declarations, comments, cdata
+	};
+
+	TokenType readToken(size_t& end);
+	bool findTokenEnd(TokenType& type, size_t& end);
+	size_t find(size_t from, const char* pattern) const;
+
+	bool fill();
+	void discardConsumed();
+
+	FILE* mFile;
+	std::string mBuffer;
+
+	const char* mData;
+	size_t mSize;
+	size_t mPos;
+	int mDepth;
+
+	pugi::xml_document mRootDoc;
+	pugi::xml_document mEntryDoc;
+
+	std::string mError;
+	size_t mPeakMemory;
+};
+
+#endif // ES_APP_GAMELIST_STREAM_READER_H
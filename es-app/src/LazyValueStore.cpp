@@ -0,0 +1,137 @@
+#include "LazyValueStore.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include <stdio.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LazyValueStore::LazyValueStore() : mData(nullptr), mSize(0)
+{
+}
+
+LazyValueStore::~LazyValueStore()
+{
+	closeFile();
+}
+
+bool LazyValueStore::open(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	closeFile();
+	return openFile(path);
+}
+
+void LazyValueStore::close()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	closeFile();
+}
+
+bool LazyValueStore::isOpen()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	return !mPath.empty();
+}
+
+bool LazyValueStore::reopen(const std::string& path, const std::function<void()>& updateLocations)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	closeFile();
+
+	updateLocations();
+
+	return openFile(path);
+}
+
+bool LazyValueStore::openFile(const std::string& path)
+{
+#ifndef WIN32
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED)
+		{
+			mData = (const char*) data;
+			mSize = info.st_size;
+		}
+	}
+
+	::close(fd);
+
+	if (mData == nullptr)
+		return false;
+#else
+	// The file is opened on each read : an open handle would prevent the snapshot from being replaced
+	if (!Utils::FileSystem::exists(path))
+		return false;
+#endif
+
+	mPath = path;
+	return true;
+}
+
+void LazyValueStore::closeFile()
+{
+#ifndef WIN32
+	if (mData != nullptr)
+		munmap((void*) mData, mSize);
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+	mPath.clear();
+}
+
+bool LazyValueStore::read(const MetaDataLazyValue& location, std::string& value)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	if (mPath.empty())
+	{
+		value.clear();
+		return false;
+	}
+
+#ifndef WIN32
+	if ((size_t) location.offset + location.length > mSize)
+	{
+		LOG(LogError) << "LazyValueStore : invalid value location in " << mPath;
+		value.clear();
+		return false;
+	}
+
+	value.assign(mData + location.offset, location.length);
+	return true;
+#else
+	value.clear();
+
+	FILE* file = _wfopen(Utils::String::convertToWideString(mPath).c_str(), L"rb");
+	if (file == nullptr)
+		return false;
+
+	bool ret = false;
+
+	if (fseek(file, location.offset, SEEK_SET) == 0)
+	{
+		value.resize(location.length);
+		ret = location.length == 0 || fread(&value[0], 1, location.length, file) == location.length;
+		if (!ret)
+			value.clear();
+	}
+
+	fclose(file);
+	return ret;
+#endif
+}
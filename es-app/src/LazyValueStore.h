@@ -0,0 +1,45 @@
+#pragma once
+#ifndef ES_APP_LAZY_VALUE_STORE_H
+#define ES_APP_LAZY_VALUE_STORE_H
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Location of a metadata value left in the gamelist snapshot file
+struct MetaDataLazyValue
+{
+	unsigned int offset;
+	unsigned int length;
+};
+
+// Read-only access to the metadata values a system leaves in its snapshot file instead of memory.
+// The file is memory mapped when the platform allows it, so the kernel can drop the pages of values that are no more read.
+class LazyValueStore
+{
+public:
+	LazyValueStore();
+	~LazyValueStore();
+
+	bool open(const std::string& path);
+	void close();
+	bool isOpen();
+
+	bool read(const MetaDataLazyValue& location, std::string& value);
+
+	// Switches to a rewritten file. updateLocations is run while no value can be read
+	bool reopen(const std::string& path, const std::function<void()>& updateLocations);
+
+private:
+	bool openFile(const std::string& path);
+	void closeFile();
+
+	std::mutex mLock;
+	std::string mPath;
+
+	const char* mData;
+	size_t mSize;
+};
+
+#endif // ES_APP_LAZY_VALUE_STORE_H
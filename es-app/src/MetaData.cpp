@@ -10,12 +10,18 @@
 #include "FileData.h"
 #include "ImageIO.h"
 
+#include <climits>
+
 std::vector<MetaDataDecl> MetaDataList::mMetaDataDecls;
 
 static std::map<MetaDataId, int> mMetaDataIndexes;
 static std::string* mDefaultGameMap = nullptr;
 static MetaDataType* mGameTypeMap = nullptr;
 static std::map<std::string, MetaDataId> mGameIdMap;
+static int* mNativeSlots = nullptr;
+
+static_assert(MetaDataId::Bezel < 64, "MetaDataList slot masks are limited to 64 ids");
+static std::vector<MetaDataNativeValue> mNativeDefaults;
 
 static std::map<std::string, int> KnowScrapersIds =
 {
@@ -123,6 +129,122 @@ void MetaDataList::initMetadata()
 		mGameTypeMap[iter->id] = iter->type;
 		mGameIdMap[iter->key] = iter->id;
 	}
+
+	if (mNativeSlots != nullptr)
+		delete[] mNativeSlots;
+
+	mNativeSlots = new int[maxID];
+	mNativeDefaults.clear();
+
+	for (int i = 0; i < maxID; i++)
+	{
+		mNativeSlots[i] = -1;
+
+		if (!isNativeType(mGameTypeMap[i]))
+			continue;
+
+		if (mNativeDefaults.size() >= MaxNativeValues)
+		{
+			LOG(LogWarning) << "MetaDataList : no native slot left for metadata " << i << ", stored as string";
+			continue;
+		}
+
+		mNativeSlots[i] = mNativeDefaults.size();
+		mNativeDefaults.push_back(parseNativeValue(mGameTypeMap[i], mDefaultGameMap[i]));
+	}
+}
+
+bool MetaDataList::isNativeType(MetaDataType type)
+{
+	return type == MD_INT || type == MD_FLOAT || type == MD_RATING || type == MD_BOOL || type == MD_DATE || type == MD_TIME;
+}
+
+// Dates are stored as the digits of the ISO string (YYYYMMDDTHHMMSS) so comparing them gives the same order as comparing the strings.
+// Empty goes first, "not-a-date-time" & other texts go last, partial dates are padded with zeroes.
+static long long parseDateValue(const std::string& value)
+{
+	if (value.empty())
+		return -1;
+
+	const char* str = value.c_str();
+	if (*str < '0' || *str > '9')
+		return LLONG_MAX;
+
+	long long ret = 0;
+	int digits = 0;
+
+	for (; *str != 0 && digits < 14; str++)
+	{
+		if (*str == 'T' && digits == 8)
+			continue;
+
+		if (*str < '0' || *str > '9')
+			break;
+
+		ret = ret * 10 + (*str - '0');
+		digits++;
+	}
+
+	for (; digits < 14; digits++)
+		ret *= 10;
+
+	return ret;
+}
+
+MetaDataNativeValue MetaDataList::parseNativeValue(MetaDataType type, const std::string& value)
+{
+	MetaDataNativeValue ret;
+	ret.dateValue = 0;
+
+	switch (type)
+	{
+	case MD_INT:
+		ret.intValue = atoi(value.c_str());
+		break;
+	case MD_FLOAT:
+	case MD_RATING:
+		ret.floatValue = Utils::String::toFloat(value);
+		break;
+	case MD_BOOL:
+		ret.boolValue = (value == "true");
+		break;
+	case MD_DATE:
+	case MD_TIME:
+		ret.dateValue = parseDateValue(value);
+		break;
+	default:
+		break;
+	}
+
+	return ret;
+}
+
+// Canonical text of a native value, only texts equal to it are dropped from the string slots
+std::string MetaDataList::formatNativeValue(MetaDataType type, const MetaDataNativeValue& value)
+{
+	switch (type)
+	{
+	case MD_INT:
+		return std::to_string(value.intValue);
+	case MD_FLOAT:
+	case MD_RATING:
+		return std::to_string(value.floatValue);
+	case MD_BOOL:
+		return value.boolValue ? "true" : "false";
+	case MD_DATE:
+	case MD_TIME:
+		if (value.dateValue >= 0 && value.dateValue < 100000000000000LL)
+		{
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), "%08lldT%06lld", value.dateValue / 1000000LL, value.dateValue % 1000000LL);
+			return buffer;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return "";
 }
 
 MetaDataType MetaDataList::getType(MetaDataId id) const
@@ -140,7 +262,7 @@ MetaDataId MetaDataList::getId(const std::string& key) const
 	return mGameIdMap[key];
 }
 
-MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr)
+MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mNativeMask(0), mStringMask(0), mPathMask(0), mLazyMask(0), mLazyStore(nullptr), mWasChanged(false), mRelativeTo(nullptr)
 {
 
 }
@@ -288,16 +410,15 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 		if (mddIter->id == MetaDataId::GenreIds)
 			continue;
 
-		auto mapIter = mMap.find(mddIter->id);
-		if(mapIter != mMap.cend())
+		std::string value;
+		if (getRawValue(mddIter->id, value))
 		{
 			// we have this value!
 			// if it's just the default (and we ignore defaults), don't write it
-			if (ignoreDefaults && mapIter->second == mddIter->defaultValue)
+			if (ignoreDefaults && value == mddIter->defaultValue)
 				continue;
 
 			// try and make paths relative if we can
-			std::string value = mapIter->second;
 			if (mddIter->type == MD_PATH)
 			{
 				if (fullPaths && mRelativeTo != nullptr)
@@ -362,34 +483,216 @@ void MetaDataList::set(MetaDataId id, const std::string& value)
 	// Players -> remove "1-"
 	if (mType == GAME_METADATA && id == 12 && Utils::String::startsWith(value, "1-")) // "players"
 	{
-		mMap[id] = Utils::String::replace(value, "1-", "");
+		setRawValue(id, Utils::String::replace(value, "1-", ""));
 		return;
 	}
 
-	auto prev = mMap.find(id);
-	if (prev != mMap.cend() && prev->second == value)
-		return;
+	if (mGameTypeMap[id] == MD_PATH)
+	{
+		if ((mPathMask & (1ULL << id)) && mPaths[slotIndex(mPathMask, id)] == value)
+			return;
+	}
+	else
+	{
+		std::string prev;
+		if (getRawValue(id, prev) && prev == value)
+			return;
+	}
 
 	if (mGameTypeMap[id] == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-		mMap[id] = Utils::FileSystem::createRelativePath(value, mRelativeTo->getStartPath(), true);
+		setRawValue(id, Utils::FileSystem::createRelativePath(value, mRelativeTo->getStartPath(), true));
 	else
-		mMap[id] = Utils::String::trim(value);
+		setRawValue(id, Utils::String::trim(value));
 
 	mWasChanged = true;
 }
 
+static inline int countBits(unsigned long long mask)
+{
+#ifdef _MSC_VER
+	int count = 0;
+	for (; mask != 0; mask &= mask - 1)
+		count++;
+	return count;
+#else
+	return __builtin_popcountll(mask);
+#endif
+}
+
+int MetaDataList::slotIndex(unsigned long long mask, MetaDataId id)
+{
+	return countBits(mask & ((1ULL << id) - 1));
+}
+
+template<typename T, typename V>
+static void setSlot(std::vector<T>& slots, unsigned long long& mask, int index, MetaDataId id, const V& value)
+{
+	if (mask & (1ULL << id))
+	{
+		slots[index] = value;
+		return;
+	}
+
+	slots.insert(slots.begin() + index, T(value));
+	mask |= 1ULL << id;
+}
+
+template<typename T>
+static void eraseSlot(std::vector<T>& slots, unsigned long long& mask, int index, MetaDataId id)
+{
+	if ((mask & (1ULL << id)) == 0)
+		return;
+
+	slots.erase(slots.begin() + index);
+	mask &= ~(1ULL << id);
+}
+
+bool MetaDataList::getRawValue(MetaDataId id, std::string& value) const
+{
+	unsigned long long bit = 1ULL << id;
+
+	if (mLazyMask & bit)
+	{
+		mLazyStore->read(mLazyValues[slotIndex(mLazyMask, id)], value);
+		return true;
+	}
+
+	if (mPathMask & bit)
+	{
+		value = mPaths[slotIndex(mPathMask, id)].toString();
+		return true;
+	}
+
+	if (mStringMask & bit)
+	{
+		value = mStrings[slotIndex(mStringMask, id)];
+		return true;
+	}
+
+	if (mNativeMask & bit)
+	{
+		value = formatNativeValue(mGameTypeMap[id], mNative[mNativeSlots[id]]);
+		return true;
+	}
+
+	return false;
+}
+
+void MetaDataList::setRawValue(MetaDataId id, const std::string& value)
+{
+	removeLazyValue(id);
+
+	MetaDataType type = mGameTypeMap[id];
+	if (type == MD_PATH)
+	{
+		setSlot(mPaths, mPathMask, slotIndex(mPathMask, id), id, value);
+		return;
+	}
+
+	int native = mNativeSlots[id];
+	if (native >= 0)
+	{
+		mNative[native] = parseNativeValue(type, value);
+		mNativeMask |= 1ULL << id;
+
+		// The text is only needed when it can't be rebuilt from the value
+		if (formatNativeValue(type, mNative[native]) == value)
+		{
+			eraseSlot(mStrings, mStringMask, slotIndex(mStringMask, id), id);
+			return;
+		}
+	}
+
+	setSlot(mStrings, mStringMask, slotIndex(mStringMask, id), id, value);
+}
+
+std::vector<std::pair<MetaDataId, std::string>> MetaDataList::getRawValues() const
+{
+	std::vector<std::pair<MetaDataId, std::string>> ret;
+
+	unsigned long long mask = mNativeMask | mStringMask | mPathMask | mLazyMask;
+	for (int id = 0; mask != 0; id++, mask >>= 1)
+	{
+		std::string value;
+		if ((mask & 1) && getRawValue((MetaDataId)id, value))
+			ret.push_back(std::pair<MetaDataId, std::string>((MetaDataId)id, value));
+	}
+
+	return ret;
+}
+
+bool MetaDataList::isLazy(MetaDataId id)
+{
+	return id == MetaDataId::Desc || id == MetaDataId::Manual || id == MetaDataId::Magazine || id == MetaDataId::Map || id == MetaDataId::BoxBack;
+}
+
+void MetaDataList::setLazyValue(MetaDataId id, LazyValueStore* store, unsigned int offset, unsigned int length)
+{
+	if (mLazyStore != store)
+	{
+		materializeLazyValues();
+		mLazyStore = store;
+	}
+
+	if (mGameTypeMap[id] == MD_PATH)
+		eraseSlot(mPaths, mPathMask, slotIndex(mPathMask, id), id);
+	else
+		eraseSlot(mStrings, mStringMask, slotIndex(mStringMask, id), id);
+
+	MetaDataLazyValue location;
+	location.offset = offset;
+	location.length = length;
+
+	setSlot(mLazyValues, mLazyMask, slotIndex(mLazyMask, id), id, location);
+}
+
+// Points a value that is already lazy to its new location in the snapshot file.
+// Updates the slot in place : masks & vectors don't change, so unlocked readers still find the same slot.
+// Must be called from LazyValueStore::reopen, where no value can be read.
+bool MetaDataList::relocateLazyValue(MetaDataId id, LazyValueStore* store, unsigned int offset, unsigned int length)
+{
+	if (mLazyStore != store || (mLazyMask & (1ULL << id)) == 0)
+		return false;
+
+	MetaDataLazyValue& location = mLazyValues[slotIndex(mLazyMask, id)];
+	location.offset = offset;
+	location.length = length;
+	return true;
+}
+
+void MetaDataList::removeLazyValue(MetaDataId id)
+{
+	eraseSlot(mLazyValues, mLazyMask, slotIndex(mLazyMask, id), id);
+
+	if (mLazyMask == 0)
+		mLazyStore = nullptr;
+}
+
+void MetaDataList::materializeLazyValues()
+{
+	for (int id = 0; mLazyMask != 0 && id < 64; id++)
+	{
+		if ((mLazyMask & (1ULL << id)) == 0)
+			continue;
+
+		std::string value;
+		getRawValue((MetaDataId) id, value);
+		setRawValue((MetaDataId) id, value);
+	}
+}
+
 const std::string MetaDataList::get(MetaDataId id, bool resolveRelativePaths) const
 {
 	if (id == MetaDataId::Name)
 		return mName;
 
-	auto it = mMap.find(id);
-	if (it != mMap.end())
+	std::string value;
+	if (getRawValue(id, value))
 	{
 		if (resolveRelativePaths && mGameTypeMap[id] == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-			return Utils::FileSystem::resolveRelativePath(it->second, mRelativeTo->getStartPath(), true);
+			return Utils::FileSystem::resolveRelativePath(value, mRelativeTo->getStartPath(), true);
 
-		return it->second;
+		return value;
 	}
 
 	return mDefaultGameMap[id];
@@ -413,12 +716,50 @@ const std::string MetaDataList::get(const std::string& key, bool resolveRelative
 
 int MetaDataList::getInt(MetaDataId id) const
 {
-	return atoi(get(id).c_str());
+	int native = mNativeSlots[id];
+	if (native < 0 || mGameTypeMap[id] != MD_INT)
+		return atoi(get(id).c_str());
+
+	if (mNativeMask & (1ULL << id))
+		return mNative[native].intValue;
+
+	return mNativeDefaults[native].intValue;
 }
 
 float MetaDataList::getFloat(MetaDataId id) const
 {
-	return Utils::String::toFloat(get(id));
+	int native = mNativeSlots[id];
+	if (native < 0 || (mGameTypeMap[id] != MD_FLOAT && mGameTypeMap[id] != MD_RATING))
+		return Utils::String::toFloat(get(id));
+
+	if (mNativeMask & (1ULL << id))
+		return mNative[native].floatValue;
+
+	return mNativeDefaults[native].floatValue;
+}
+
+bool MetaDataList::getBool(MetaDataId id) const
+{
+	int native = mNativeSlots[id];
+	if (native < 0 || mGameTypeMap[id] != MD_BOOL)
+		return get(id) == "true";
+
+	if (mNativeMask & (1ULL << id))
+		return mNative[native].boolValue;
+
+	return mNativeDefaults[native].boolValue;
+}
+
+long long MetaDataList::getDate(MetaDataId id) const
+{
+	int native = mNativeSlots[id];
+	if (native < 0 || (mGameTypeMap[id] != MD_DATE && mGameTypeMap[id] != MD_TIME))
+		return parseDateValue(get(id));
+
+	if (mNativeMask & (1ULL << id))
+		return mNative[native].dateValue;
+
+	return mNativeDefaults[native].dateValue;
 }
 
 bool MetaDataList::wasChanged() const
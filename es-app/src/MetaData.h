@@ -8,6 +8,8 @@
 #include <string>
 
 #include "utils/TimeUtil.h"
+#include "utils/InternedPath.h"
+#include "LazyValueStore.h"
 
 class SystemData;
 class FileData;
@@ -123,6 +125,15 @@ struct MetaDataDecl
 	}
 };
 
+// Native storage of MD_INT, MD_FLOAT, MD_RATING, MD_BOOL, MD_DATE & MD_TIME values
+union MetaDataNativeValue
+{
+	int			intValue;
+	float		floatValue;
+	bool		boolValue;
+	long long	dateValue; // YYYYMMDDhhmmss
+};
+
 enum MetaDataListType
 {
 	GAME_METADATA,
@@ -131,6 +142,8 @@ enum MetaDataListType
 
 class MetaDataList
 {
+	friend class GamelistCache;
+
 public:
 	static void initMetadata();
 
@@ -148,8 +161,11 @@ public:
 	void set(const std::string& key, const std::string& value);
 	const std::string get(const std::string& key, bool resolveRelativePaths = true) const;
 
+	// Typed accessors : numeric, bool & date fields are stored natively, no parsing involved
 	int getInt(MetaDataId id) const;
 	float getFloat(MetaDataId id) const;
+	bool getBool(MetaDataId id) const;
+	long long getDate(MetaDataId id) const; // YYYYMMDDhhmmss, orders like the ISO string
 
 	MetaDataType getType(MetaDataId id) const;
 	MetaDataType getType(const std::string name) const;
@@ -174,18 +190,54 @@ public:
 	void setScrapeDate(const std::string& scraper);
 	Utils::Time::DateTime* getScrapeDate(const std::string& scraper);
 
+	// Long & rarely displayed fields (desc, manual, magazine, map, boxback) can stay in the gamelist snapshot :
+	// they are read from the file by get() and become regular values once set.
+	static bool isLazy(MetaDataId id);
+	bool hasLazyValues() const { return mLazyMask != 0; }
+	void materializeLazyValues();
+
+	static const int MaxNativeValues = 12;
+
 private:
 	std::map<int, Utils::Time::DateTime> mScrapeDates;
 
 	std::string		mName;
 	MetaDataListType mType;
-	std::map<MetaDataId, std::string> mMap;
+
+	// Values are stored in fixed slots, one bit per MetaDataId tells which storage holds it.
+	// Strings & paths are packed in id order : the slot index is the number of lower bits set in the mask.
+	unsigned long long mNativeMask;
+	unsigned long long mStringMask;
+	unsigned long long mPathMask;
+
+	MetaDataNativeValue mNative[MaxNativeValues];		// numeric, bool & date fields. The text is also kept in mStrings if it doesn't round-trip
+	std::vector<std::string> mStrings;
+	std::vector<Utils::InternedPath> mPaths;	// MD_PATH values, kept apart so the media folders are shared between games
+
+	unsigned long long mLazyMask;
+	std::vector<MetaDataLazyValue> mLazyValues;	// values still in the snapshot file of mLazyStore
+	LazyValueStore* mLazyStore;
+
 	bool mWasChanged;
 	SystemData*		mRelativeTo;
 
 	static std::vector<MetaDataDecl> mMetaDataDecls;
 
 	std::vector<std::tuple<std::string, std::string, bool>> mUnKnownElements;
+
+	// Stored values, without default or relative path resolution
+	bool getRawValue(MetaDataId id, std::string& value) const;
+	void setRawValue(MetaDataId id, const std::string& value);
+	std::vector<std::pair<MetaDataId, std::string>> getRawValues() const;
+
+	void setLazyValue(MetaDataId id, LazyValueStore* store, unsigned int offset, unsigned int length);
+	void removeLazyValue(MetaDataId id);
+	bool relocateLazyValue(MetaDataId id, LazyValueStore* store, unsigned int offset, unsigned int length);
+
+	static bool isNativeType(MetaDataType type);
+	static MetaDataNativeValue parseNativeValue(MetaDataType type, const std::string& value);
+	static std::string formatNativeValue(MetaDataType type, const MetaDataNativeValue& value);
+	static int slotIndex(unsigned long long mask, MetaDataId id);
 };
 
 #endif // ES_APP_META_DATA_H
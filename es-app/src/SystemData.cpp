@@ -17,12 +17,16 @@
 #include "LocaleES.h"
 #include "utils/StringUtil.h"
 #include "utils/Randomizer.h"
+#include "utils/md5.h"
 #include "views/ViewController.h"
 #include "ThreadedHasher.h"
 #include <unordered_set>
 #include <algorithm>
 #include "SaveStateRepository.h"
 #include "Paths.h"
+#include "GamelistCache.h"
+#include "GamelistJournal.h"
+#include "FolderScanner.h"
 
 #if WIN32
 #include "Win32ApiSystem.h"
@@ -45,6 +49,8 @@ SystemData::SystemData(const SystemMetadata& meta, SystemEnvironmentData* envDat
 	mGridSizeOverride = Vector2f(0, 0);
 
 	mFilterIndex = nullptr;
+	mGameIdIndexBuilt = false;
+	mChangeCounter = 0;
 
 	if (pEmulators != nullptr)
 		mEmulators = *pEmulators;
@@ -60,24 +66,42 @@ SystemData::SystemData(const SystemMetadata& meta, SystemEnvironmentData* envDat
 		mRootFolder = new FolderData(mEnvData->mStartPath, this);
 		mRootFolder->getMetadata().set(MetaDataId::Name, mMetadata.fullName);
 
-		std::unordered_map<std::string, FileData*> fileMap;
-		fileMap[mEnvData->mStartPath] = mRootFolder;
-
-		if (!Settings::ParseGamelistOnly())
+		bool useSnapshot = GamelistCache::isEnabled(this);
+		if (!useSnapshot || !GamelistCache::loadSnapshot(this))
 		{
-			populateFolder(mRootFolder, fileMap);
-			if (mRootFolder->getChildren().size() == 0)
-				return;
+			StopWatch stopWatch("SystemData - " + getName() + " : xml gamelist loaded in", LogDebug);
 
-			if (mHidden && !Settings::HiddenSystemsShowGames())
-				return;
-		}
+			std::unordered_map<std::string, FileData*> fileMap;
+			fileMap[mEnvData->mStartPath] = mRootFolder;
 
-		if (!Settings::IgnoreGamelist())
-			parseGamelist(this, fileMap);		
-		
-		if (Settings::RemoveMultiDiskContent())
-			removeMultiDiskContent(fileMap);
+			if (useSnapshot)
+				mScannedFolders = std::unique_ptr<std::vector<std::pair<std::string, time_t>>>(new std::vector<std::pair<std::string, time_t>>());
+
+			if (!Settings::ParseGamelistOnly())
+			{
+				populateFolder(mRootFolder, fileMap);
+				if (mRootFolder->getChildren().size() == 0)
+					return;
+
+				if (mHidden && !Settings::HiddenSystemsShowGames())
+					return;
+			}
+
+			if (!Settings::IgnoreGamelist())
+			{
+				size_t peakMemory = 0;
+				parseGamelist(this, fileMap, &peakMemory);
+				stopWatch.setDetails("xml reader peak memory " + std::to_string(peakMemory / 1024) + "KB");
+			}
+
+			if (Settings::RemoveMultiDiskContent())
+				removeMultiDiskContent(fileMap);
+
+			if (useSnapshot)
+				GamelistCache::saveSnapshot(this, stopWatch.getElapsedMilliseconds());
+		}
+		else if (!Settings::IgnoreGamelist())
+			GamelistJournal::replay(this);
 	}
 	else
 	{
@@ -189,11 +213,57 @@ void SystemData::setIsGameSystemStatus()
 }
 
 void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap)
+{
+	// Spread the scan of large trees on all cores, merge is done in the same order as the sequential scan
+	if (std::thread::hardware_concurrency() > 1 && Settings::ThreadedLoading())
+	{
+		FolderScanner scanner(this);
+		scanner.scan(folder, fileMap);
+		return;
+	}
+
+	std::vector<FileData*> entries;
+	time_t folderDate;
+
+	if (!scanFolder(folder, entries, folderDate))
+		return;
+
+	if (mScannedFolders != nullptr)
+		mScannedFolders->push_back(std::pair<std::string, time_t>(folder->getPath(), folderDate));
+
+	for (auto entry : entries)
+	{
+		if (entry->getType() == GAME)
+		{
+			folder->addChild(entry);
+			fileMap[entry->getPath()] = entry;
+			continue;
+		}
+
+		FolderData* newFolder = (FolderData*)entry;
+		populateFolder(newFolder, fileMap);
+
+		//ignore folders that do not contain games
+		if (newFolder->getChildren().size() == 0)
+			delete newFolder;
+		else
+		{
+			const std::string& key = newFolder->getPath();
+			if (fileMap.find(key) == fileMap.end())
+			{
+				folder->addChild(newFolder);
+				fileMap[key] = newFolder;
+			}
+		}
+	}
+}
+
+bool SystemData::scanFolder(FolderData* folder, std::vector<FileData*>& entries, time_t& folderDate)
 {
 	const std::string& folderPath = folder->getPath();
 
 	if(!Utils::FileSystem::isDirectory(folderPath))
-		return;
+		return false;
 	/*
 	// [Obsolete] make sure that this isn't a symlink to a thing we already have
 	// Deactivated because it's slow & useless : users should to be carefull not to make recursive simlinks
@@ -217,6 +287,9 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 	if (shv == "1") showHidden = true;
 	else if (shv == "0") showHidden = false;
 
+	// Remember the folder date before listing it, so any change made during the scan invalidates the snapshot
+	folderDate = (mScannedFolders != nullptr ? Utils::FileSystem::getFileModificationDate(folderPath).getTime() : 0);
+
 	Utils::FileSystem::fileList dirContent = Utils::FileSystem::getDirectoryFiles(folderPath);
 	for (auto fileInfo : dirContent)
 	{
@@ -241,10 +314,11 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			// preventing new arcade assets to be added
 			if(!newGame->isArcadeAsset())
 			{
-				folder->addChild(newGame);
-				fileMap[filePath] = newGame;
+				entries.push_back(newGame);
 				isGame = true;
 			}
+			else
+				delete newGame;
 		}
 
 		//add directories that also do not match an extension as folders
@@ -281,23 +355,11 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			if (mMetadata.name == "wiiu" && (fn == "content" || fn == "meta"))
 				continue;
 
-			FolderData* newFolder = new FolderData(filePath, this);
-			populateFolder(newFolder, fileMap);
-
-			//ignore folders that do not contain games
-			if(newFolder->getChildren().size() == 0)
-				delete newFolder;
-			else 
-			{
-				const std::string& key = newFolder->getPath();
-				if (fileMap.find(key) == fileMap.end())
-				{
-					folder->addChild(newFolder);
-					fileMap[key] = newFolder;
-				}
-			}
+			entries.push_back(new FolderData(filePath, this));
 		}
 	}
+
+	return true;
 }
 
 FileFilterIndex* SystemData::getIndex(bool createIndex)
@@ -321,6 +383,107 @@ void SystemData::deleteIndex()
 	}
 }
 
+std::string SystemData::getGameId(FileData* game)
+{
+	MD5 md5;
+	md5.update(game->getPath().c_str(), game->getPath().size());
+	md5.finalize();
+	return md5.hexdigest();
+}
+
+// mGameIdIndexLock must be held
+void SystemData::buildGameIdIndex()
+{
+	if (mGameIdIndexBuilt)
+		return;
+
+	StopWatch stopWatch("SystemData - " + getName() + " : game id index built in", LogDebug);
+
+	mGameIdIndex.clear();
+
+	std::stack<FolderData*> stack;
+	stack.push(mRootFolder);
+
+	while (stack.size())
+	{
+		FolderData* current = stack.top();
+		stack.pop();
+
+		for (auto it : current->getChildren())
+		{
+			if (it->getType() == FOLDER)
+				stack.push((FolderData*)it);
+			else if (it->getType() == GAME)
+				mGameIdIndex[getGameId(it)] = it;
+		}
+	}
+
+	mGameIdIndexBuilt = true;
+}
+
+FileData* SystemData::findGameById(const std::string& id)
+{
+	std::unique_lock<std::mutex> lock(mGameIdIndexLock);
+
+	buildGameIdIndex();
+
+	auto it = mGameIdIndex.find(id);
+	if (it != mGameIdIndex.cend())
+		return it->second;
+
+	return nullptr;
+}
+
+void SystemData::visitGamesById(const std::vector<std::string>& ids, size_t from, size_t to, const std::function<void(FileData*)>& func)
+{
+	// Deleted games leave the index under this lock before they are freed
+	std::unique_lock<std::mutex> lock(mGameIdIndexLock);
+
+	buildGameIdIndex();
+
+	for (size_t i = from; i < to && i < ids.size(); i++)
+	{
+		auto it = mGameIdIndex.find(ids[i]);
+		if (it != mGameIdIndex.cend())
+			func(it->second);
+	}
+}
+
+void SystemData::addToGameIdIndex(FileData* game)
+{
+	incrementChangeCounter();
+
+	std::unique_lock<std::mutex> lock(mGameIdIndexLock);
+
+	// Not built yet : it will see the game
+	if (mGameIdIndexBuilt)
+		mGameIdIndex[getGameId(game)] = game;
+}
+
+void SystemData::removeFromGameIdIndex(FileData* game)
+{
+	incrementChangeCounter();
+
+	std::unique_lock<std::mutex> lock(mGameIdIndexLock);
+
+	if (!mGameIdIndexBuilt)
+		return;
+
+	auto it = mGameIdIndex.find(getGameId(game));
+	if (it != mGameIdIndex.cend() && it->second == game)
+		mGameIdIndex.erase(it);
+}
+
+void SystemData::resetGameIdIndex()
+{
+	incrementChangeCounter();
+
+	std::unique_lock<std::mutex> lock(mGameIdIndexLock);
+
+	mGameIdIndex.clear();
+	mGameIdIndexBuilt = false;
+}
+
 void SystemData::indexAllGameFilters(const FolderData* folder)
 {
 	const std::vector<FileData*>& children = folder->getChildren();
@@ -756,28 +919,28 @@ bool SystemData::loadConfig(Window* window)
 
 	typedef SystemData* SystemDataPtr;
 
-	ThreadPool* pThreadPool = NULL;
+	TaskGroup* pThreadPool = NULL;
 	SystemDataPtr* systems = NULL;
 
 	// Allow threaded loading only if processor threads > 1 so it does not apply on machines like Pi0.
 	if (std::thread::hardware_concurrency() > 1 && Settings::ThreadedLoading())
 	{
-		pThreadPool = new ThreadPool();
+		pThreadPool = new TaskGroup(TaskPriority::High);
 
 		systems = new SystemDataPtr[systemCount];
 		for (int i = 0; i < systemCount; i++)
 			systems[i] = nullptr;
 
-		pThreadPool->queueWorkItem([] { CollectionSystemManager::get()->loadCollectionSystems(); });
+		pThreadPool->queue([] { CollectionSystemManager::get()->loadCollectionSystems(); });
 	}
 
-	int processedSystem = 0;
+	std::atomic<int> processedSystem(0);
 
 	for (pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
 	{
 		if (pThreadPool != NULL)
 		{
-			pThreadPool->queueWorkItem([system, currentSystem, systems, &processedSystem]
+			pThreadPool->queue([system, currentSystem, systems, &processedSystem]
 			{
 				systems[currentSystem] = loadSystem(system);
 				processedSystem++;
@@ -855,6 +1018,8 @@ bool SystemData::loadConfig(Window* window)
 		}
 	}
 
+	Utils::InternedPath::logStats();
+
 	if (window != nullptr && !ThreadedHasher::isRunning())
 	{
 		int checkIndex = 0;
@@ -1113,13 +1278,16 @@ void SystemData::deleteSystems()
 {
 	bool saveOnExit = !Settings::IgnoreGamelist() && Settings::SaveGamelistsOnExit;
 
+	GamelistJournal::waitForCompactions();
+
 	for (unsigned int i = 0; i < sSystemVector.size(); i++)
 	{
 		SystemData* pData = sSystemVector.at(i);
 		pData->getRootFolder()->removeVirtualFolders();
 
+		// Pending journal records are merged so gamelist.xml is up to date for other readers
 		if (saveOnExit && !pData->mIsCollectionSystem)
-			updateGamelist(pData);
+			updateGamelist(pData, true);
 
 		delete pData;
 	}
@@ -4,7 +4,10 @@
 
 #include "PlatformId.h"
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <map>
@@ -16,6 +19,7 @@
 #include "KeyboardMapping.h"
 #include "math/Vector2f.h"
 #include "CustomFeatures.h"
+#include "LazyValueStore.h"
 #include "utils/VectorEx.h"
 
 class FileData;
@@ -62,6 +66,9 @@ struct SystemEnvironmentData
 
 class SystemData : public IKeyboardMapContainer
 {
+	friend class GamelistCache;
+	friend class FolderScanner;
+
 public:
     SystemData(const SystemMetadata& type, SystemEnvironmentData* envData, std::vector<EmulatorData>* pEmulators, bool CollectionSystem = false, bool groupedSystem = false, bool withTheme = true, bool loadThemeOnlyIfElements = false);
 	~SystemData();
@@ -137,6 +144,22 @@ public:
 		if (mFilterIndex != nullptr) mFilterIndex->resetFilters();
 	};
 
+	// Games by HTTP API id (md5 of the path). Built on the first lookup, then kept up to date as games are added & removed
+	FileData* findGameById(const std::string& id);
+
+	// Calls func with the games of ids[from..to[ still in the system, skipping the removed ones. They can't be deleted until it returns
+	void visitGamesById(const std::vector<std::string>& ids, size_t from, size_t to, const std::function<void(FileData*)>& func);
+
+	void addToGameIdIndex(FileData* game);
+	void removeFromGameIdIndex(FileData* game);
+	void resetGameIdIndex();
+
+	static std::string getGameId(FileData* game);
+
+	// Incremented whenever games are added, removed or saved : HTTP API responses are tagged with it
+	unsigned int getChangeCounter() { return mChangeCounter; }
+	void incrementChangeCounter() { mChangeCounter++; }
+
 	void resetIndex() {
 		if (mFilterIndex != nullptr) mFilterIndex->resetIndex();
 	};
@@ -226,6 +249,7 @@ private:
 	std::shared_ptr<ThemeData> mTheme;
 
 	void populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap);
+	bool scanFolder(FolderData* folder, std::vector<FileData*>& entries, time_t& folderDate);
 	void indexAllGameFilters(const FolderData* folder);
 	void setIsGameSystemStatus();
 	void removeMultiDiskContent(std::unordered_map<std::string, FileData*>& fileMap);
@@ -235,6 +259,14 @@ private:
 
 	FileFilterIndex* mFilterIndex;
 
+	std::unordered_map<std::string, FileData*> mGameIdIndex;
+	bool mGameIdIndexBuilt;
+	std::mutex mGameIdIndexLock; // lookups come from the HTTP server thread
+
+	void buildGameIdIndex();
+
+	std::atomic<unsigned int> mChangeCounter;
+
 	FolderData* mRootFolder;
 
 	std::vector<EmulatorData> mEmulators;
@@ -249,6 +281,12 @@ private:
 	SaveStateRepository* mSaveRepository;
 
 	bool mHidden;
+
+	// Folders scanned by populateFolder with their modification time, kept until the gamelist snapshot is written
+	std::unique_ptr<std::vector<std::pair<std::string, time_t>>> mScannedFolders;
+
+	// Snapshot file holding the metadata values that are not kept in memory
+	std::unique_ptr<LazyValueStore> mLazyValueStore;
 };
 
 #endif // ES_APP_SYSTEM_DATA_H
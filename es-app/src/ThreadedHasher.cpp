@@ -11,6 +11,7 @@
 #include "ApiSystem.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include "utils/ThreadPool.h"
 #include <unordered_set>
 #include <queue>
 
@@ -48,13 +49,31 @@ ThreadedHasher::ThreadedHasher(Window* window, HasherType type, std::queue<FileD
 	else 
 		mWndNotification->updateTitle(ICONINDEX + _("SEARCHING NETPLAY GAMES"));
 
-	int num_threads = std::thread::hardware_concurrency() / 2;
-	if (num_threads == 0)
-		num_threads = 1;
+	mMaxTasks = std::thread::hardware_concurrency() / 2;
+	if (mMaxTasks == 0)
+		mMaxTasks = 1;
 
-	mThreadCount = num_threads;
-	for (size_t i = 0; i < num_threads; i++)
-		mThreads.push_back(new std::thread(&ThreadedHasher::run, this));
+	mTaskCount = 0;
+}
+
+// mLoaderLock must be held
+void ThreadedHasher::startTasks()
+{
+	while (mTaskCount < mMaxTasks)
+	{
+		mTaskCount++;
+		Utils::Executor::getInstance()->submit([this] { run(); }, nullptr, Utils::TaskPriority::Low);
+	}
+}
+
+void ThreadedHasher::resume()
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	mPaused = false;
+
+	if (mInstance != nullptr && !mInstance->mExit)
+		mInstance->startTasks();
 }
 
 ThreadedHasher::~ThreadedHasher()
@@ -89,7 +108,7 @@ void ThreadedHasher::run()
 	bool cheevos = ((mType & HASH_CHEEVOS_MD5) == HASH_CHEEVOS_MD5);
 	bool netplay = ((mType & HASH_NETPLAY_CRC) == HASH_NETPLAY_CRC);
 
-	while (!mExit && !mSearchQueue.empty())
+	if (!mExit && !mPaused && !mSearchQueue.empty())
 	{
 		FileData* game = mSearchQueue.front();
 
@@ -102,15 +121,6 @@ void ThreadedHasher::run()
 
 		lock.unlock();
 
-		if (mPaused)
-		{
-			while (!mExit && mPaused)
-			{
-				std::this_thread::yield();
-				std::this_thread::sleep_for(std::chrono::milliseconds(500));
-			}
-		}		
-
 		if (netplay)
 		{
 			LOG(LogDebug) << "CheckCrc32 : " << label;
@@ -136,16 +146,22 @@ void ThreadedHasher::run()
 		}		
 
 		lock.lock();
+
+		if (!mExit && !mPaused && !mSearchQueue.empty())
+		{
+			Utils::Executor::getInstance()->submit([this] { run(); }, nullptr, Utils::TaskPriority::Low);
+			return;
+		}
 	}
 
-	mThreadCount--;
+	mTaskCount--;
 
-	if (mThreadCount == 0)
+	// When paused, the instance stays alive until resume() restarts the tasks
+	if (mTaskCount == 0 && (mExit || mSearchQueue.empty()))
 	{
+		ThreadedHasher::mInstance = nullptr;
 		lock.unlock();
 		delete this;
-		ThreadedHasher::mInstance = nullptr;
-
 	}
 }
 
@@ -217,19 +233,27 @@ void ThreadedHasher::start(Window* window, HasherType type, bool forceAllGames,
 		return;
 	}
 
+	std::unique_lock<std::mutex> lock(mLoaderLock);
 	ThreadedHasher::mInstance = new ThreadedHasher(window, type, searchQueue, forceAllGames);
+	ThreadedHasher::mInstance->startTasks();
 }
 
 void ThreadedHasher::stop()
 {
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
 	auto thread = ThreadedHasher::mInstance;
 	if (thread == nullptr)
 		return;
 
-	try
+	thread->mExit = true;
+
+	// Paused : no task left to release the instance
+	if (thread->mTaskCount == 0)
 	{
-		thread->mExit = true;
+		ThreadedHasher::mInstance = nullptr;
+		lock.unlock();
+		delete thread;
 	}
-	catch (...) {}
 }
 
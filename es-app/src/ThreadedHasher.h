@@ -23,7 +23,7 @@ public:
 	static bool checkCloseIfRunning(Window* window);
 
 	static void pause() { mPaused = true; }
-	static void resume() { mPaused = false; }
+	static void resume();
 
 private:
 	ThreadedHasher(Window* window, HasherType type, std::queue<FileData*> searchQueue, bool forceAllGames = false);
@@ -44,10 +44,11 @@ private:
 	HasherType mType;
 
 	void run();
+	void startTasks();
 
-	//std::thread* mHandle;
-	std::vector<std::thread*>	mThreads;
-	int							mThreadCount;
+	// Games are hashed one by one by low priority tasks on the shared executor, each task queues the next one
+	int							mMaxTasks;
+	int							mTaskCount;
 
 	int mTotal;
 	bool mExit;
@@ -46,6 +46,7 @@ CarouselComponent::~CarouselComponent()
 
 void CarouselComponent::clearEntries()
 {
+	mPrefetchedLogos.clear();
 	mEntries.clear();
 }
 
@@ -198,6 +199,8 @@ void CarouselComponent::onCursorChanged(const CursorState& state)
 	if (mLastCursor == mCursor)
 		return;
 
+	prefetchLogos();
+
 	if (!mScrollSound.empty())
 		Sound::get(mScrollSound)->play();
 
@@ -462,6 +465,53 @@ void CarouselComponent::renderCarousel(const Transform4x4f& trans)
 		renderLogo(activePos);
 }
 
+// Starts loading the logos just outside of the carousel, on the side it is scrolling to,
+// and drops the pending loads of the ones which are not coming anymore
+void CarouselComponent::prefetchLogos()
+{
+	int logoCount = Math::min(mMaxLogoCount, (int)mEntries.size());
+	if ((int)mEntries.size() <= logoCount)
+		return;
+
+	int bufferIndex = Math::max(0, Math::min(2, getScrollingVelocity() + 1));
+	int bufferLeft = logoBuffersLeft[bufferIndex];
+	int bufferRight = logoBuffersRight[bufferIndex];
+
+	std::vector<std::shared_ptr<GuiComponent>> prefetched;
+
+	for (int i = mCursor + bufferLeft - logoCount / 2; i <= mCursor + bufferRight + logoCount / 2; i++)
+	{
+		if (abs(i - mCursor) <= logoCount / 2)
+			continue;
+
+		int index = i % (int)mEntries.size();
+		if (index < 0)
+			index += (int)mEntries.size();
+
+		auto& entry = mEntries.at(index);
+		ensureLogo(entry);
+
+		ImageComponent* image = dynamic_cast<ImageComponent*>(entry.data.logo.get());
+		if (image == nullptr)
+			continue;
+
+		image->prefetch();
+		prefetched.push_back(entry.data.logo);
+	}
+
+	for (auto logo : mPrefetchedLogos)
+	{
+		if (std::find(prefetched.cbegin(), prefetched.cend(), logo) != prefetched.cend())
+			continue;
+
+		ImageComponent* image = dynamic_cast<ImageComponent*>(logo.get());
+		if (image != nullptr)
+			image->cancelPrefetch();
+	}
+
+	mPrefetchedLogos = prefetched;
+}
+
 void CarouselComponent::getCarouselFromTheme(const ThemeData::ThemeElement* elem)
 {
 	if (elem->has("type"))
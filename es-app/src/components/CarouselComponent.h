@@ -59,6 +59,7 @@ private:
 
 	void renderCarousel(const Transform4x4f& parentTrans);	
 	void ensureLogo(IList<CarouselComponentData, FileData*>::Entry& entry);
+	void prefetchLogos();
 
 	// unit is list index
 	float mCamOffset;
@@ -111,6 +112,8 @@ private:
 	bool			mAnyLogoHasScaleStoryboard;
 	bool			mAnyLogoHasOpacityStoryboard;
 
+	std::vector<std::shared_ptr<GuiComponent>> mPrefetchedLogos;
+
 public:
 	bool isHorizontalCarousel() { return mType == HORIZONTAL || mType == HORIZONTAL_WHEEL; }
 };
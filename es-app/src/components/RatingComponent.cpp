@@ -5,7 +5,8 @@
 #include "ThemeData.h"
 #include "Settings.h"
 
-RatingComponent::RatingComponent(Window* window) : GuiComponent(window), mColorShift(0xFFFFFFFF), mUnfilledColor(0xFFFFFFFF)
+RatingComponent::RatingComponent(Window* window) : GuiComponent(window), mColorShift(0xFFFFFFFF), mUnfilledColor(0xFFFFFFFF),
+	mFilledVertexCount(0), mFilledTextureRect(0, 0, 1, 1), mUnfilledTextureRect(0, 0, 1, 1)
 {
 	mHorizontalAlignment = ALIGN_LEFT;
 	mValue = 0.5f;
@@ -81,6 +82,22 @@ void RatingComponent::onSizeChanged()
 	updateVertices();
 }
 
+static void buildStar(Renderer::Vertex* vertices, float x, float size, float fill, unsigned int color)
+{
+	vertices[1] = { { x,               0.0f }, { 0.0f, 1.0f }, color };
+	vertices[2] = { { x,               size }, { 0.0f, 0.0f }, color };
+	vertices[3] = { { x + size * fill, 0.0f }, { fill, 1.0f }, color };
+	vertices[4] = { { x + size * fill, size }, { fill, 0.0f }, color };
+
+	// round vertices
+	for (int i = 1; i < 5; ++i)
+		vertices[i].pos.round();
+
+	// make duplicates of first and last vertex so the stars can be rendered as a single triangle strip
+	vertices[0] = vertices[1];
+	vertices[5] = vertices[4];
+}
+
 void RatingComponent::updateVertices()
 {
 	const float        numStars = NUM_RATING_STARS;
@@ -88,40 +105,33 @@ void RatingComponent::updateVertices()
 	const float        h = getSize().y(); // is the same as a single star's width
 	const float        w = getSize().y() * mValue * numStars;
 	const float        fw = getSize().y() * numStars;
+	const float        left = (mHorizontalAlignment == ALIGN_RIGHT ? sz - fw : 0.0f);
 
 	float opacity = mOpacity / 255.0;
 	const unsigned int color = Renderer::convertColor(mColorShift & 0xFFFFFF00 | (unsigned char)((mColorShift & 0xFF) * opacity));
 	const unsigned int unFilledColor = Renderer::convertColor(mUnfilledColor & 0xFFFFFF00 | (unsigned char)((mUnfilledColor & 0xFF) * opacity));
 
-	switch (mHorizontalAlignment)
+	// Stars are drawn one by one instead of repeating the texture, so the star pictures can be packed in the texture atlas
+	Renderer::Vertex* unfilled = &mVertices[NUM_RATING_STARS * 6];
+
+	mFilledVertexCount = 0;
+	for (int i = 0; i < NUM_RATING_STARS; i++)
 	{
-	case ALIGN_RIGHT:
-		mVertices[0] = { { sz - fw, 0.0f },{ 0.0f,              1.0f }, color };
-		mVertices[1] = { { sz - fw, h },{ 0.0f,              0.0f }, color };
-		mVertices[2] = { { sz - fw + w,    0.0f },{ mValue * numStars, 1.0f }, color };
-		mVertices[3] = { { sz - fw + w,    h },{ mValue * numStars, 0.0f }, color };
-
-		mVertices[4] = { { sz - fw, 0.0f },{ 0.0f,              1.0f }, unFilledColor };
-		mVertices[5] = { { sz - fw, h },{ 0.0f,              0.0f }, unFilledColor };
-		mVertices[6] = { { sz,   0.0f },{ numStars,          1.0f }, unFilledColor };
-		mVertices[7] = { { sz,   h },{ numStars,          0.0f }, unFilledColor };
-		break;
-
-	default:
-		mVertices[0] = { { 0.0f, 0.0f }, { 0.0f,              1.0f }, color };
-		mVertices[1] = { { 0.0f, h    }, { 0.0f,              0.0f }, color };
-		mVertices[2] = { { w,    0.0f }, { mValue * numStars, 1.0f }, color };
-		mVertices[3] = { { w,    h    }, { mValue * numStars, 0.0f }, color };
-
-		mVertices[4] = { { 0.0f, 0.0f }, { 0.0f,              1.0f }, unFilledColor };
-		mVertices[5] = { { 0.0f, h    }, { 0.0f,              0.0f }, unFilledColor };
-		mVertices[6] = { { fw,   0.0f }, { numStars,          1.0f }, unFilledColor };
-		mVertices[7] = { { fw,   h    }, { numStars,          0.0f }, unFilledColor };
-		break;
+		buildStar(&unfilled[i * 6], left + h * i, h, 1.0f, unFilledColor);
+
+		float fill = (h > 0 ? Math::clamp(0.0f, 1.0f, (w - h * i) / h) : 0.0f);
+		if (fill > 0)
+		{
+			buildStar(&mVertices[mFilledVertexCount], left + h * i, h, fill, color);
+			mFilledVertexCount += 6;
+		}
 	}
-	// round vertices
-	for (int i = 0; i < 8; ++i)
-		mVertices[i].pos.round();
+
+	mFilledTextureRect = (mFilledTexture != nullptr ? mFilledTexture->getTextureRect() : Vector4f(0, 0, 1, 1));
+	mUnfilledTextureRect = (mUnfilledTexture != nullptr ? mUnfilledTexture->getTextureRect() : Vector4f(0, 0, 1, 1));
+
+	TextureResource::mapTextureCoordinates(mVertices, mFilledVertexCount, mFilledTextureRect);
+	TextureResource::mapTextureCoordinates(unfilled, NUM_RATING_STARS * 6, mUnfilledTextureRect);
 }
 
 void RatingComponent::updateColors()
@@ -129,21 +139,21 @@ void RatingComponent::updateColors()
 	float opacity = mOpacity / 255.0;
 	
 	const unsigned int color = Renderer::convertColor(mColorShift & 0xFFFFFF00 | (unsigned char)((mColorShift & 0xFF) * opacity));
-	for (int i = 0; i < 4; i++)
+	for (int i = 0; i < NUM_RATING_STARS * 6; i++)
 		mVertices[i].col = color;
 
 	const unsigned int unFilledColor = Renderer::convertColor(mUnfilledColor & 0xFFFFFF00 | (unsigned char)((mUnfilledColor & 0xFF) * opacity));
-	for (int i = 4; i < 8; i++)
+	for (int i = NUM_RATING_STARS * 6; i < NUM_RATING_STARS * 6 * 2; i++)
 		mVertices[i].col = unFilledColor;
 }
 
 void RatingComponent::render(const Transform4x4f& parentTrans)
 {
 	if (mFilledTexture == nullptr)
-		mFilledTexture = TextureResource::get(":/star_filled.svg", true, true);
+		mFilledTexture = TextureResource::get(":/star_filled.svg", false, true);
 
 	if (mUnfilledTexture == nullptr)
-		mUnfilledTexture = TextureResource::get(":/star_unfilled.svg", true, true);
+		mUnfilledTexture = TextureResource::get(":/star_unfilled.svg", false, true);
 
 	if (!isVisible() || mFilledTexture == nullptr || mUnfilledTexture == nullptr)
 		return;
@@ -159,16 +169,23 @@ void RatingComponent::render(const Transform4x4f& parentTrans)
 
 	if (mUnfilledTexture->bind())
 	{
-		Renderer::drawTriangleStrips(&mVertices[4], 4);
-		Renderer::bindTexture(0);
+		if (mUnfilledTexture->getTextureRect() != mUnfilledTextureRect)
+			updateVertices();
+
+		Renderer::drawTriangleStrips(&mVertices[NUM_RATING_STARS * 6], NUM_RATING_STARS * 6);
 	}
 
-	if (mFilledTexture->bind())
+	if (mFilledVertexCount > 0 && mFilledTexture->bind())
 	{
-		Renderer::drawTriangleStrips(&mVertices[0], 4);
-		Renderer::bindTexture(0);
+		if (mFilledTexture->getTextureRect() != mFilledTextureRect)
+			updateVertices();
+
+		Renderer::drawTriangleStrips(&mVertices[0], mFilledVertexCount);
 	}
 
+	// Both textures are usually in the same atlas page : no texture switch between the two draws
+	Renderer::bindTexture(0);
+
 	renderChildren(trans);
 }
 
@@ -200,13 +217,15 @@ void RatingComponent::applyTheme(const std::shared_ptr<ThemeData>& theme, const
 
 	if (properties & PATH && elem->has("filledPath"))
 	{
-		mFilledTexture = TextureResource::get(elem->get<std::string>("filledPath"), true, true);
+		mFilledTexture = TextureResource::get(elem->get<std::string>("filledPath"), false, true);
+		mFilledTexture->setTextureClass(TEXTURE_CLASS_THEME);
 		imgChanged = true;
 	}
 
 	if (properties & PATH && elem->has("unfilledPath"))
 	{
-		mUnfilledTexture = TextureResource::get(elem->get<std::string>("unfilledPath"), true, true);
+		mUnfilledTexture = TextureResource::get(elem->get<std::string>("unfilledPath"), false, true);
+		mUnfilledTexture->setTextureClass(TEXTURE_CLASS_THEME);
 		imgChanged = true;
 	}
 
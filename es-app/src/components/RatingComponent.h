@@ -45,7 +45,12 @@ private:
 
 	float mValue;
 
-	Renderer::Vertex mVertices[8];
+	// One quad per star, 6 vertices each : the filled stars first, then the unfilled ones
+	Renderer::Vertex mVertices[NUM_RATING_STARS * 6 * 2];
+	int mFilledVertexCount;
+
+	Vector4f mFilledTextureRect;
+	Vector4f mUnfilledTextureRect;
 
 	unsigned int mColorShift;
 	unsigned int mUnfilledColor;
@@ -343,6 +343,9 @@ bool TextListComponent<T>::input(InputConfig* config, Input input)
 template <typename T>
 void TextListComponent<T>::update(int deltaTime)
 {
+	const int marqueeOffset = mMarqueeOffset;
+	const int marqueeOffset2 = mMarqueeOffset2;
+
 	mScrollbar.update(deltaTime);
 
 	listUpdate(deltaTime);
@@ -384,6 +387,9 @@ void TextListComponent<T>::update(int deltaTime)
 		}
 	}
 
+	if (mMarqueeOffset != marqueeOffset || mMarqueeOffset2 != marqueeOffset2)
+		GuiComponent::invalidate();
+
 	GuiComponent::update(deltaTime);
 }
 
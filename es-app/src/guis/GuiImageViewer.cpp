@@ -280,11 +280,11 @@ void GuiImageViewer::loadPdf(const std::string& imagePath)
 	
 	if (pages > INITIALPAGES)
 	{
-		mPdfThreads = new Utils::ThreadPool(1);
+		mPdfThreads = new Utils::TaskGroup(Utils::TaskPriority::Low);
 
 		for (int i = INITIALPAGES; i < pages; i += PAGESPERTHREAD)
 		{
-			mPdfThreads->queueWorkItem([this, imagePath, window, i]
+			mPdfThreads->queue([this, imagePath, window, i]
 			{
 				auto fl = ApiSystem::getInstance()->extractPdfImages(imagePath, i + 1, PAGESPERTHREAD);
 				if (fl.size() == 0 || !g_isGuiImageViewerRunning)
@@ -304,8 +304,6 @@ void GuiImageViewer::loadPdf(const std::string& imagePath)
 				});
 			});
 		}
-
-		mPdfThreads->start();
 	}
 	
 	window->pushGui(new GuiLoading<std::vector<std::string>>(window, _("Loading..."),
@@ -422,12 +420,12 @@ void GuiImageViewer::loadCbz(const std::string& imagePath)
 
 	if (pages > INITIALPAGES)
 	{
-		mPdfThreads = new Utils::ThreadPool(1);
+		mPdfThreads = new Utils::TaskGroup(Utils::TaskPriority::Low);
 
 		for (int i = INITIALPAGES; i < pages; i += PAGESPERTHREAD)
 		{
 			auto fileToExtract = files[i];
-			mPdfThreads->queueWorkItem([this, imagePath, fileToExtract, window, i]
+			mPdfThreads->queue([this, imagePath, fileToExtract, window, i]
 			{
 				auto localFile = _extractZipFile(imagePath, fileToExtract);
 				if (localFile.empty() || !g_isGuiImageViewerRunning)
@@ -443,8 +441,6 @@ void GuiImageViewer::loadCbz(const std::string& imagePath)
 				});
 			});
 		}
-
-		mPdfThreads->start();
 	}
 
 	window->pushGui(new GuiLoading<std::vector<std::string>>(window, _("Loading..."),
@@ -484,11 +480,9 @@ GuiImageViewer::~GuiImageViewer()
 {
 	g_isGuiImageViewerRunning = false;
 
+	// Pending pages are cancelled, the destructor waits for the ones being extracted
 	if (mPdfThreads != nullptr)
-	{
-		mPdfThreads->stop();
 		delete mPdfThreads;
-	}
 
 	auto pdfFolder = Utils::FileSystem::getPdfTempPath();
 	Utils::FileSystem::deleteDirectoryFiles(pdfFolder, true);
@@ -34,7 +34,7 @@ protected:
 	std::shared_ptr<ThemeData> mTheme;
 	std::string mPdf;
 
-	Utils::ThreadPool* mPdfThreads;
+	Utils::TaskGroup* mPdfThreads;
 };
 
 class GuiVideoViewer : public GuiComponent
@@ -12,24 +12,32 @@
 #include "Log.h"
 #include "MameNames.h"
 #include "Genres.h"
+#include "GamelistJournal.h"
 #include "platform.h"
 #include "PowerSaver.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "SystemScreenSaver.h"
 #include <SDL_events.h>
 #include <SDL_main.h>
 #include <SDL_timer.h>
+#include <atomic>
 #include <iostream>
+#include <thread>
 #include <time.h>
 #include "LocaleES.h"
 #include <SystemConf.h>
 #include "ApiSystem.h"
 #include "AudioManager.h"
 #include "NetworkThread.h"
+#include "scrapers/ScraperCache.h"
 #include "scrapers/ThreadedScraper.h"
 #include "ThreadedHasher.h"
 #include "ImageIO.h"
+#include "resources/Font.h"
+#include "resources/TextureCompressor.h"
+#include "resources/ThumbnailCache.h"
 #include "components/VideoVlcComponent.h"
 #include <csignal>
 #include <components/VideoGstreamerComponent.h>
@@ -150,6 +158,9 @@ bool parseArgs(int argc, char* argv[])
 		}else if(strcmp(argv[i], "--ignore-gamelist") == 0)
 		{
 			Settings::getInstance()->setBool("IgnoreGamelist", true);
+		}else if(strcmp(argv[i], "--rebuild-cache") == 0)
+		{
+			Settings::getInstance()->setBool("RebuildGamelistCache", true);
 		}else if(strcmp(argv[i], "--show-hidden-files") == 0)
 		{
 			Settings::setShowHiddenFiles(true);
@@ -234,6 +245,7 @@ bool parseArgs(int argc, char* argv[])
 				"--resolution [width] [height]	try and force a particular resolution\n"
 				"--gamelist-only			skip automatic game search, only read from gamelist.xml\n"
 				"--ignore-gamelist		ignore the gamelist (useful for troubleshooting)\n"
+				"--rebuild-cache			ignore the gamelist snapshots and rebuild them from gamelist.xml\n"
 				"--draw-framerate		display the framerate\n"
 				"--no-exit			don't show the exit option in the menu\n"
 				"--no-splash			don't show the splash screen\n"
@@ -606,6 +618,19 @@ int main(int argc, char* argv[])
 	// Create a flag in  temporary directory to signal READY state
 	ApiSystem::getInstance()->setReadyFlag();
 
+	// Rasterize the characters of the language in the background, before the screens need them
+	if (Settings::getInstance()->getBool("PrewarmGlyphs"))
+		Font::prewarm(EsLocale::getCommonCharacters());
+
+	// Trim the on-disk caches in the background, nothing waits for it
+	std::atomic<bool> cacheSweepCanceled(false);
+	std::thread cacheSweeper([&cacheSweepCanceled]
+	{
+		TextureCompressor::sweepCache(&cacheSweepCanceled);
+		ThumbnailCache::sweepCache(&cacheSweepCanceled);
+		ScraperCache::sweep(&cacheSweepCanceled);
+	});
+
 	// Play music
 	AudioManager::getInstance()->init();
 
@@ -639,6 +664,7 @@ int main(int argc, char* argv[])
 	delete stopWatch;
 
 	bool running = true;
+	bool idle = false;
 
 	while(running)
 	{
@@ -649,8 +675,20 @@ int main(int argc, char* argv[])
 		SDL_Event event;
 
 		bool ps_standby = PowerSaver::getState() && (int) SDL_GetTicks() - ps_time > PowerSaver::getMode();
-		if(ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : SDL_PollEvent(&event))
+
+		// When the last frame was skipped, wait for an event instead of spinning : about one frame at 60Hz
+		bool gotEvent;
+		if (ps_standby)
+			gotEvent = SDL_WaitEventTimeout(&event, PowerSaver::getTimeout());
+		else if (idle)
+			gotEvent = SDL_WaitEventTimeout(&event, 16);
+		else
+			gotEvent = SDL_PollEvent(&event);
+
+		if(gotEvent)
 		{
+			window.invalidate();
+
 			// PowerSaver can push events to exit SDL_WaitEventTimeout immediatly
 			// Reset this event's state
 			TRYCATCH("resetRefreshEvent", PowerSaver::resetRefreshEvent());
@@ -694,7 +732,20 @@ int main(int argc, char* argv[])
 		if(deltaTime < 0)
 			deltaTime = 1000;
 
+		PROFILE_FRAME_BEGIN();
+
 		TRYCATCH("Window.update" ,window.update(deltaTime))	
+		TRYCATCH("GamelistJournal::processCompletedCompactions", GamelistJournal::processCompletedCompactions())
+
+		// Nothing changed since the last frame : keep it on screen
+		idle = !window.isRenderNeeded();
+		if (idle)
+		{
+			window.skipFrame();
+			Log::flush();
+			continue;
+		}
+
 		TRYCATCH("Window.render", window.render())
 
 #ifdef WIN32		
@@ -707,11 +758,19 @@ int main(int argc, char* argv[])
 		}
 #endif
 
-		Renderer::swapBuffers();
+		{
+			PROFILE_SCOPE("Renderer::swapBuffers");
+			Renderer::swapBuffers();
+		}
+
+		PROFILE_FRAME_END();
 
 		Log::flush();
 	}
 
+	cacheSweepCanceled = true;
+	cacheSweeper.join();
+
 	if (isFastShutdown())
 		Settings::getInstance()->setBool("IgnoreGamelist", true);
 
@@ -727,6 +786,7 @@ int main(int argc, char* argv[])
 		window.renderSplashScreen(_("SAVING METADATAS. PLEASE WAIT..."));
 
 	ImageIO::saveImageCache();
+	ThumbnailCache::logStatistics();
 	MameNames::deinit();
 	ViewController::saveState();
 	CollectionSystemManager::deinit();
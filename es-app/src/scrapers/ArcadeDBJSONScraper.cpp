@@ -185,34 +185,34 @@ void processGame(const Value& game, std::vector<ScraperSearchResult>& results)
 }
 } // namespace
 
-  // Process should return false only when we reached a maximum scrap by minute, to retry
-bool ArcadeDBJSONRequest::process(HttpReq* request, std::vector<ScraperSearchResult>& results)
+// Process returns false when the content is not a game description (unknown game, wrong format...) : it is not cached
+bool ArcadeDBJSONRequest::process(const std::string& content, std::vector<ScraperSearchResult>& results)
 {
-	assert(request->status() == HttpReq::REQ_SUCCESS);
+	size_t resultCount = results.size();
 
 	Document doc;
-	doc.Parse(request->getContent().c_str());
+	doc.Parse(content.c_str());
 
 	if (doc.HasParseError())
 	{
 		std::string err = std::string("ArcadeDBJSONRequest - Error parsing JSON. \n\t") + GetParseError_En(doc.GetParseError());
 		setError(err);
 		LOG(LogError) << err;
-		return true;
+		return false;
 	}
 
     if (!doc.HasMember("release") || !doc["release"].IsInt() || doc["release"].GetInt() < ARCADE_DB_RELEASE_VERSION)
     {
         std::string warn = "ArcadeDBJSONRequest - Response had wrong format.\n";
         LOG(LogWarning) << warn;
-        return true;
+        return false;
     }
 
 	if (!doc.HasMember("result") || !doc["result"].IsArray())
 	{
 		std::string warn = "ArcadeDBJSONRequest - Response had no game data.\n";
 		LOG(LogWarning) << warn;
-		return true;
+		return false;
 	}
 
     const Value& games = doc["result"];
@@ -230,5 +230,5 @@ bool ArcadeDBJSONRequest::process(HttpReq* request, std::vector<ScraperSearchRes
 		}
 	}
 
-	return true;
+	return results.size() > resultCount;
 }
@@ -37,7 +37,7 @@ class ArcadeDBJSONRequest : public ScraperHttpRequest
 	}
 
   protected:
-	bool process(HttpReq* request, std::vector<ScraperSearchResult>& results) override;
+	bool process(const std::string& content, std::vector<ScraperSearchResult>& results) override;
 	bool isGameRequest() { return !mRequestQueue; }
 
 	std::queue<std::unique_ptr<ScraperRequest>>* mRequestQueue;
@@ -540,14 +540,13 @@ namespace
 	}
 } // namespace
 
-  // Process should return false only when we reached a maximum scrap by minute, to retry
-bool TheGamesDBJSONRequest::process(HttpReq* request, std::vector<ScraperSearchResult>& results)
+// Process returns false when the content is not a game description (unknown game, wrong format...) : it is not cached
+bool TheGamesDBJSONRequest::process(const std::string& content, std::vector<ScraperSearchResult>& results)
 {
-	if (request->status() != HttpReq::REQ_SUCCESS)
-		return false;
+	size_t resultCount = results.size();
 
 	Document doc;
-	doc.Parse(request->getContent().c_str());
+	doc.Parse(content.c_str());
 
 	if (doc.HasParseError())
 	{
@@ -555,14 +554,14 @@ bool TheGamesDBJSONRequest::process(HttpReq* request, std::vector<ScraperSearchR
 			std::string("TheGamesDBJSONRequest - Error parsing JSON. \n\t") + GetParseError_En(doc.GetParseError());
 		setError(err);
 		LOG(LogError) << err;
-		return true;
+		return false;
 	}
 
 	if (!doc.HasMember("data") || !doc["data"].HasMember("games") || !doc["data"]["games"].IsArray())
 	{
 		std::string warn = "TheGamesDBJSONRequest - Response had no game data.\n";
 		LOG(LogWarning) << warn;
-		return true;
+		return false;
 	}
 	const Value& games = doc["data"]["games"];
 
@@ -570,7 +569,7 @@ bool TheGamesDBJSONRequest::process(HttpReq* request, std::vector<ScraperSearchR
 	{
 		std::string warn = "TheGamesDBJSONRequest - Response had no include boxart data.\n";
 		LOG(LogWarning) << warn;
-		return true;
+		return false;
 	}
 
 	const Value& boxart = doc["include"]["boxart"];
@@ -579,7 +578,7 @@ bool TheGamesDBJSONRequest::process(HttpReq* request, std::vector<ScraperSearchR
 	{
 		std::string warn = "TheGamesDBJSONRequest - Response include had no usable boxart data.\n";
 		LOG(LogWarning) << warn;
-		return true;
+		return false;
 	}
 
 	resources.ensureResources();
@@ -598,7 +597,7 @@ bool TheGamesDBJSONRequest::process(HttpReq* request, std::vector<ScraperSearchR
 		}
 	}
 
-	return true;
+	return results.size() > resultCount;
 }
 
 #endif
\ No newline at end of file
@@ -511,34 +511,34 @@ static void processGame(const Value& game, std::vector<ScraperSearchResult>& res
 }
 } // namespace
 
-  // Process should return false only when we reached a maximum scrap by minute, to retry
-bool HfsDBRequest::process(HttpReq* request, std::vector<ScraperSearchResult>& results)
+// Process returns false when the content is not a game description (unknown game, wrong format...) : it is not cached
+bool HfsDBRequest::process(const std::string& content, std::vector<ScraperSearchResult>& results)
 {
-	assert(request->status() == HttpReq::REQ_SUCCESS);
+	size_t resultCount = results.size();
 
 	Document doc;
-	doc.Parse(request->getContent().c_str());
+	doc.Parse(content.c_str());
 
 	if (doc.HasParseError())
 	{
 		std::string err = std::string("HfsDBRequest - Error parsing JSON. \n\t") + GetParseError_En(doc.GetParseError());
 		setError(err);
 		LOG(LogError) << err;
-		return true;
+		return false;
 	}
 
     if (!doc.HasMember("count") || !doc["count"].IsInt() || doc["count"].GetInt() <= 0)
     {
         std::string warn = "HfsDBRequest - Response had no game data.\n";
         LOG(LogWarning) << warn;
-        return true;
+        return false;
     }
 
 	if (!doc.HasMember("results") || !doc["results"].IsArray())
 	{
 		std::string warn = "HfsDBRequest - Response results is not an array.\n";
 		LOG(LogWarning) << warn;
-		return true;
+		return false;
 	}
 
     const Value& games = doc["results"];
@@ -557,7 +557,7 @@ bool HfsDBRequest::process(HttpReq* request, std::vector<ScraperSearchResult>& r
 		}
 	}
 
-	return true;
+	return results.size() > resultCount;
 }
 
 #endif
\ No newline at end of file
@@ -47,7 +47,7 @@ class HfsDBRequest : public ScraperHttpRequest
 	}
 
   protected:
-	bool process(HttpReq* request, std::vector<ScraperSearchResult>& results) override;
+	bool process(const std::string& content, std::vector<ScraperSearchResult>& results) override;
 	bool isGameRequest() { return !mRequestQueue; }
 
 	bool mIsArcade;
@@ -14,6 +14,7 @@
 #include <thread>
 #include <SDL_timer.h>
 #include "HfsDBScraper.h"
+#include "ScraperCache.h"
 
 #define OVERQUOTA_RETRY_DELAY 15000
 #define OVERQUOTA_RETRY_COUNT 5
@@ -254,25 +255,75 @@ void ScraperSearchHandle::update()
 
 // ScraperHttpRequest
 ScraperHttpRequest::ScraperHttpRequest(std::vector<ScraperSearchResult>& resultsWrite, const std::string& url, HttpReqOptions* options)
-	: ScraperRequest(resultsWrite)
+	: ScraperRequest(resultsWrite), mRequest(nullptr), mUrl(url)
 {
 	setStatus(ASYNC_IN_PROGRESS);
 
 	if (options != nullptr)
 		mOptions = *options;
 
-	mRequest = new HttpReq(url, &mOptions);
 	mRetryCount = 0;
 	mOverQuotaPendingTime = 0;
+
+	// POST requests are not cached : the url doesn't identify them
+	ScraperCache::Entry entry;
+	if (mOptions.dataToPost.empty() && ScraperCache::get(url, entry))
+	{
+		if (entry.isFresh())
+		{
+			LOG(LogDebug) << "ScraperHttpRequest : served from cache " << url;
+			mCachedContent = entry.content;
+			return;
+		}
+
+		if (entry.canRevalidate())
+		{
+			mCachedContent = entry.content;
+			mCachedETag = entry.etag;
+			mCachedLastModified = entry.lastModified;
+
+			if (!entry.etag.empty())
+				mOptions.customHeaders.push_back("If-None-Match: " + entry.etag);
+
+			if (!entry.lastModified.empty())
+				mOptions.customHeaders.push_back("If-Modified-Since: " + entry.lastModified);
+		}
+	}
+
+	mRequest = new HttpReq(url, &mOptions);
 }
 
 ScraperHttpRequest::~ScraperHttpRequest()
 {
-	delete mRequest;	
+	if (mRequest != nullptr)
+		delete mRequest;	
+}
+
+void ScraperHttpRequest::processContent(const std::string& content, const std::string& etag, const std::string& lastModified)
+{
+	setStatus(ASYNC_DONE); // if process() has an error, status will be changed to ASYNC_ERROR
+
+	size_t resultCount = mResults.size();
+	bool isGame = process(content, mResults);
+
+	// A response without any result is never cached : the game could be added to the database later
+	if (isGame && mStatus == ASYNC_DONE && mResults.size() > resultCount && mOptions.dataToPost.empty())
+		ScraperCache::put(mUrl, content, etag, lastModified);
 }
 
 void ScraperHttpRequest::update()
 {
+	if (mStatus != ASYNC_IN_PROGRESS)
+		return;
+
+	// Fresh cache entry
+	if (mRequest == nullptr)
+	{
+		setStatus(ASYNC_DONE);
+		process(mCachedContent, mResults);
+		return;
+	}
+
 	if (mOverQuotaPendingTime > 0)
 	{
 		int lastTime = SDL_GetTicks();
@@ -298,8 +349,18 @@ void ScraperHttpRequest::update()
 
 	if(status == HttpReq::REQ_SUCCESS)
 	{
-		setStatus(ASYNC_DONE); // if process() has an error, status will be changed to ASYNC_ERROR
-		process(mRequest, mResults);
+		processContent(mRequest->getContent(), mRequest->getResponseHeader("etag"), mRequest->getResponseHeader("last-modified"));
+		return;
+	}
+
+	// The cached response is still valid : it is stored again to restart its lifetime
+	if (status == HttpReq::REQ_304_NOTMODIFIED && !mCachedContent.empty())
+	{
+		LOG(LogDebug) << "ScraperHttpRequest : revalidated " << mUrl;
+
+		std::string etag = mRequest->getResponseHeader("etag");
+		std::string lastModified = mRequest->getResponseHeader("last-modified");
+		processContent(mCachedContent, etag.empty() ? mCachedETag : etag, lastModified.empty() ? mCachedLastModified : lastModified);
 		return;
 	}
 
@@ -343,19 +404,18 @@ std::unique_ptr<MDResolveHandle> ScraperSearchResult::resolveMetaDataAssets(cons
 	return std::unique_ptr<MDResolveHandle>(new MDResolveHandle(*this, search));
 }
 
-// metadata resolving stuff
-MDResolveHandle::MDResolveHandle(const ScraperSearchResult& result, const ScraperSearchParams& search) : mResult(result)
+std::vector<ScraperMediaDownload> ScraperSearchResult::getMediaToDownload(const ScraperSearchParams& search)
 {
-	mPercent = -1;
+	std::vector<ScraperMediaDownload> medias;
 
-	for (auto& url : result.urls)
+	for (auto& url : urls)
 	{
 		if (url.second.url.empty())
 			continue;
 		
 		if (!search.overWriteMedias && Utils::FileSystem::exists(search.game->getMetadata(url.first)))
 		{
-			mResult.mdl.set(url.first, search.game->getMetadata(url.first));
+			mdl.set(url.first, search.game->getMetadata(url.first));
 			continue;
 		}
 
@@ -383,31 +443,67 @@ MDResolveHandle::MDResolveHandle(const ScraperSearchResult& result, const Scrape
 
 		std::string resourcePath = Scraper::getSaveAsPath(search.game, url.first, ext);
 
-		if (!search.overWriteMedias && Utils::FileSystem::exists(resourcePath))
+		// Already downloaded from the same url : even when overwriting, there's nothing new to get
+		std::string cachedPath = ScraperCache::findMedia(url.second.url, resourcePath);
+
+		if (!cachedPath.empty())
+		{
+			mdl.set(url.first, cachedPath);
+			url.second.url = "";
+		}
+		else if (!search.overWriteMedias && Utils::FileSystem::exists(resourcePath))
 		{
-			mResult.mdl.set(url.first, resourcePath);
-			if (mResult.urls.find(url.first) != mResult.urls.cend())
-				mResult.urls[url.first].url = "";
+			mdl.set(url.first, resourcePath);
+			url.second.url = "";
 		}
 		else
 		{
-			mFuncs.push_back(new ResolvePair(
-				[this, url, resourcePath, resize] 
-				{ 
-					return downloadImageAsync(url.second.url, resourcePath, resize); 
-				},
-				[this, url](ImageDownloadHandle* result)
-				{
-					auto finalFile = result->getImageFileName();
+			ScraperMediaDownload media;
+			media.id = url.first;
+			media.url = url.second.url;
+			media.path = resourcePath;
+			media.name = suffix;
+			media.resize = resize;
+			medias.push_back(media);
+		}
+	}
 
-					if (Utils::FileSystem::getFileSize(finalFile) > 0)
-						mResult.mdl.set(url.first, finalFile);
+	return medias;
+}
 
-					if (mResult.urls.find(url.first) != mResult.urls.cend())
-						mResult.urls[url.first].url = "";
-				},
-				suffix, result.mdl.getName()));
-		}
+void ScraperSearchResult::setDownloadedMedia(MetaDataId id, const std::string& file)
+{
+	auto url = urls.find(id);
+
+	if (Utils::FileSystem::getFileSize(file) > 0)
+	{
+		mdl.set(id, file);
+
+		if (url != urls.cend())
+			ScraperCache::addMedia(url->second.url, file);
+	}
+
+	if (url != urls.cend())
+		url->second.url = "";
+}
+
+// metadata resolving stuff
+MDResolveHandle::MDResolveHandle(const ScraperSearchResult& result, const ScraperSearchParams& search) : mResult(result)
+{
+	mPercent = -1;
+
+	for (auto& media : mResult.getMediaToDownload(search))
+	{
+		mFuncs.push_back(new ResolvePair(
+			[media] 
+			{ 
+				return downloadImageAsync(media.url, media.path, media.resize); 
+			},
+			[this, media](ImageDownloadHandle* result)
+			{
+				mResult.setDownloadedMedia(media.id, result->getImageFileName());
+			},
+			media.name, result.mdl.getName()));
 	}
 
 	auto it = mFuncs.cbegin();
@@ -465,17 +561,18 @@ void MDResolveHandle::update()
 		setStatus(ASYNC_DONE);
 }
 
-std::unique_ptr<ImageDownloadHandle> MDResolveHandle::downloadImageAsync(const std::string& url, const std::string& saveAs, bool resize)
+std::unique_ptr<ImageDownloadHandle> MDResolveHandle::downloadImageAsync(const std::string& url, const std::string& saveAs, bool resize, bool deferResize)
 {
 	LOG(LogDebug) << "downloadImageAsync : " << url << " -> " << saveAs;
 
 	return std::unique_ptr<ImageDownloadHandle>(new ImageDownloadHandle(url, saveAs, 
 		resize ? Settings::getInstance()->getInt("ScraperResizeWidth") : 0,
-		resize ? Settings::getInstance()->getInt("ScraperResizeHeight") : 0));
+		resize ? Settings::getInstance()->getInt("ScraperResizeHeight") : 0,
+		deferResize));
 }
 
-ImageDownloadHandle::ImageDownloadHandle(const std::string& url, const std::string& path, int maxWidth, int maxHeight) : 
-	mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight)
+ImageDownloadHandle::ImageDownloadHandle(const std::string& url, const std::string& path, int maxWidth, int maxHeight, bool deferResize) : 
+	mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight), mDeferResize(deferResize)
 {
 	mRetryCount = 0;
 	mOverQuotaPendingTime = 0;
@@ -599,17 +696,32 @@ void ImageDownloadHandle::update()
 			}
 		}
 
-		// It's an image ?
-		if (mSavePath.find("-fanart") == std::string::npos && mSavePath.find("-bezel") == std::string::npos && mSavePath.find("-map") == std::string::npos && (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" || ext == ".gif"))
-		{
-			try { bool result = ImageIO::resizeImage(mSavePath, mMaxWidth, mMaxHeight); }
-			catch(...) { }
-		}
+		if (!mDeferResize)
+			resize();
 	}
 
 	setStatus(ASYNC_DONE);
 }
 
+bool ImageDownloadHandle::needsResize()
+{
+	if (mMaxWidth <= 0 && mMaxHeight <= 0)
+		return false;
+
+	// It's an image ?
+	std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(mSavePath));
+	return mSavePath.find("-fanart") == std::string::npos && mSavePath.find("-bezel") == std::string::npos && mSavePath.find("-map") == std::string::npos && (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" || ext == ".gif");
+}
+
+void ImageDownloadHandle::resize()
+{
+	if (!needsResize())
+		return;
+
+	try { ImageIO::resizeImage(mSavePath, mMaxWidth, mMaxHeight); }
+	catch(...) { }
+}
+
 std::string Scraper::getSaveAsPath(FileData* game, const MetaDataId metadataId, const std::string& extension)
 {
 	std::string suffix = "image";
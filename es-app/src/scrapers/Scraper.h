@@ -46,6 +46,15 @@ struct ScraperSearchItem
 	std::string format;
 };
 
+struct ScraperMediaDownload
+{
+	MetaDataId	id;
+	std::string url;
+	std::string path;	// where the media is saved
+	std::string name;	// media type, for display
+	bool		resize;
+};
+
 struct ScraperSearchResult
 {
 	ScraperSearchResult() : mdl(GAME_METADATA) { };
@@ -67,6 +76,12 @@ struct ScraperSearchResult
 	}
 
 	std::unique_ptr<MDResolveHandle> resolveMetaDataAssets(const ScraperSearchParams& search);
+
+	// Media still to download for the game. The ones kept because overWriteMedias is off are set in mdl & removed from urls
+	std::vector<ScraperMediaDownload> getMediaToDownload(const ScraperSearchParams& search);
+
+	// Stores a downloaded file in mdl, an empty file means the download failed
+	void setDownloadedMedia(MetaDataId id, const std::string& file);
 };
 
 class ScraperRequest : public AsyncHandle
@@ -91,14 +106,22 @@ public:
 	virtual void update() override;
 
 protected:
-	virtual bool process(HttpReq* request, std::vector<ScraperSearchResult>& results) = 0;
+	// Returns false when the content can't be used (quota message...) : it is not cached
+	virtual bool process(const std::string& content, std::vector<ScraperSearchResult>& results) = 0;
 
 private:
+	void processContent(const std::string& content, const std::string& etag, const std::string& lastModified);
+
 	HttpReq* mRequest;
 	HttpReqOptions mOptions;
 	int	mRetryCount;
 
 	int mOverQuotaPendingTime;
+
+	std::string mUrl;
+	std::string mCachedContent;	// fresh response served without request, or stale one being revalidated
+	std::string mCachedETag;
+	std::string mCachedLastModified;
 };
 
 // a request to get a list of results
@@ -124,7 +147,7 @@ typedef void (*generate_scraper_requests_func)(const ScraperSearchParams& params
 class ImageDownloadHandle : public AsyncHandle
 {
 public:
-	ImageDownloadHandle(const std::string& url, const std::string& path, int maxWidth, int maxHeight);
+	ImageDownloadHandle(const std::string& url, const std::string& path, int maxWidth, int maxHeight, bool deferResize = false);
 	~ImageDownloadHandle();
 
 	void update() override;
@@ -132,6 +155,10 @@ public:
 	virtual int getPercent();
 	std::string getImageFileName() { return mSavePath; }
 
+	// With deferResize, update() leaves the downloaded image as is : resize() can then be run from any thread, once the handle is done
+	bool needsResize();
+	void resize();
+
 private:
 	HttpReq* mRequest;
 	int	mRetryCount;
@@ -140,6 +167,7 @@ private:
 	std::string mSavePath;
 	int mMaxWidth;
 	int mMaxHeight;
+	bool mDeferResize;
 };
 
 
@@ -164,7 +192,7 @@ public:
 		return mPercent;
 	}
 
-	std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url, const std::string& saveAs, bool resize = true);
+	static std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url, const std::string& saveAs, bool resize = true, bool deferResize = false);
 
 private:
 	ScraperSearchResult mResult;
@@ -0,0 +1,240 @@
+#include "scrapers/ScraperCache.h"
+
+#include "scrapers/Scraper.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "utils/md5.h"
+#include "Log.h"
+#include "Paths.h"
+#include "Settings.h"
+#include <fstream>
+#include <sstream>
+
+#define SCRAPER_CACHE_VERSION "ESSC1"
+#define REVALIDATION_AGE_FACTOR 4
+
+bool ScraperCache::Entry::isFresh()
+{
+	int days = Settings::getInstance()->getInt("ScraperCacheDays");
+	return time + (time_t)days * 86400 > ::time(NULL);
+}
+
+bool ScraperCache::isEnabled()
+{
+	return Settings::getInstance()->getInt("ScraperCacheDays") > 0;
+}
+
+std::string ScraperCache::getCacheKey(const std::string& url)
+{
+	// Credentials are not part of the key : changing the account keeps the cache
+	std::string key = url;
+
+	auto query = url.find('?');
+	if (query != std::string::npos)
+	{
+		key = url.substr(0, query + 1);
+
+		bool first = true;
+		for (auto param : Utils::String::split(url.substr(query + 1), '&'))
+		{
+			std::string name = Utils::String::toLower(param.substr(0, param.find('=')));
+			if (name == "ssid" || name == "sspassword" || name == "devid" || name == "devpassword" || name == "apikey")
+				continue;
+
+			if (!first)
+				key += "&";
+
+			key += param;
+			first = false;
+		}
+	}
+
+	MD5 md5;
+	md5.update(key.c_str(), key.size());
+	md5.finalize();
+	return md5.hexdigest();
+}
+
+std::string ScraperCache::getPath(const std::string& url, const std::string& folder)
+{
+	std::string scraper = Scraper::getScraperName(Scraper::getScraper());
+	return Paths::getUserEmulationStationPath() + "/cache/scraper/" + scraper + "/" + folder + "/" + getCacheKey(url);
+}
+
+bool ScraperCache::readHeader(std::istream& file, Entry& entry)
+{
+	std::string version, time;
+	if (!std::getline(file, version) || version != SCRAPER_CACHE_VERSION || !std::getline(file, time) ||
+		!std::getline(file, entry.etag) || !std::getline(file, entry.lastModified))
+		return false;
+
+	entry.time = (time_t)atoll(time.c_str());
+	return true;
+}
+
+bool ScraperCache::get(const std::string& url, Entry& entry)
+{
+	if (!isEnabled())
+		return false;
+
+	std::string path = getPath(url, "responses");
+
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	if (!readHeader(file, entry))
+	{
+		LOG(LogWarning) << "ScraperCache : invalid entry " << path;
+		return false;
+	}
+
+	// Expired, and the server gave nothing to revalidate it with : it will be fetched again
+	if (!entry.isFresh() && !entry.canRevalidate())
+	{
+		file.close();
+		Utils::FileSystem::removeFile(path);
+		return false;
+	}
+
+	std::stringstream content;
+	content << file.rdbuf();
+	entry.content = content.str();
+
+	return !entry.content.empty();
+}
+
+void ScraperCache::put(const std::string& url, const std::string& content, const std::string& etag, const std::string& lastModified)
+{
+	if (!isEnabled() || content.empty())
+		return;
+
+	std::string path = getPath(url, "responses");
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+
+	// Written aside then renamed : a scraper reading the entry meanwhile sees the old one or the new one
+	std::string tmpPath = path + ".tmp";
+
+	{
+		std::ofstream file(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOG(LogError) << "ScraperCache : unable to write " << tmpPath;
+			return;
+		}
+
+		file << SCRAPER_CACHE_VERSION << "\n" << (long long)time(NULL) << "\n" << etag << "\n" << lastModified << "\n";
+		file.write(content.c_str(), content.size());
+	}
+
+	if (!Utils::FileSystem::renameFile(tmpPath, path))
+		Utils::FileSystem::removeFile(tmpPath);
+}
+
+std::string ScraperCache::findMedia(const std::string& url, const std::string& expectedPath)
+{
+	if (!isEnabled())
+		return "";
+
+	std::string recordPath = getPath(url, "medias");
+
+	std::ifstream file(recordPath, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+		return "";
+
+	std::string time, size, path;
+	if (!std::getline(file, time) || !std::getline(file, size) || !std::getline(file, path))
+		return "";
+
+	Entry entry;
+	entry.time = (time_t)atoll(time.c_str());
+	if (!entry.isFresh())
+	{
+		file.close();
+		Utils::FileSystem::removeFile(recordPath);
+		return "";
+	}
+
+	// Several roms of a game share the same medias : only reuse a file saved for this rom
+	if (Utils::FileSystem::changeExtension(path, "") != Utils::FileSystem::changeExtension(expectedPath, ""))
+		return "";
+
+	// Replaced or removed since it was downloaded
+	if (!Utils::FileSystem::exists(path) || Utils::FileSystem::getFileSize(path) != (unsigned long long)atoll(size.c_str()))
+		return "";
+
+	return path;
+}
+
+void ScraperCache::addMedia(const std::string& url, const std::string& path)
+{
+	if (!isEnabled())
+		return;
+
+	auto size = Utils::FileSystem::getFileSize(path);
+	if (size == 0)
+		return;
+
+	std::string recordPath = getPath(url, "medias");
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(recordPath));
+
+	std::ofstream file(recordPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (file.is_open())
+		file << (long long)time(NULL) << "\n" << size << "\n" << path << "\n";
+}
+
+void ScraperCache::sweep(const std::atomic<bool>* cancel)
+{
+	std::string root = Paths::getUserEmulationStationPath() + "/cache/scraper";
+	if (!Utils::FileSystem::isDirectory(root))
+		return;
+
+	int days = Settings::getInstance()->getInt("ScraperCacheDays");
+	if (days <= 0)
+	{
+		// The cache is disabled : nothing reads it anymore
+		Utils::FileSystem::deleteDirectoryFiles(root, true);
+		LOG(LogInfo) << "ScraperCache : cache disabled, " << root << " removed";
+		return;
+	}
+
+	time_t expired = ::time(NULL) - (time_t)days * 86400;
+	unsigned long long freed = 0;
+
+	for (auto& scraper : Utils::FileSystem::getDirContent(root))
+	{
+		if (!Utils::FileSystem::isDirectory(scraper))
+			continue;
+
+		// Expired medias are never reused. Responses that can be revalidated are kept longer, a 304 costs less than a new search
+		freed += Utils::FileSystem::trimCacheFolder(scraper + "/medias", days, 0, cancel);
+		freed += Utils::FileSystem::trimCacheFolder(scraper + "/responses", days * REVALIDATION_AGE_FACTOR, 0, cancel);
+
+		for (auto& path : Utils::FileSystem::getDirContent(scraper + "/responses"))
+		{
+			if (cancel != nullptr && *cancel)
+				return;
+
+			unsigned long long size = 0;
+			time_t modified = 0;
+			if (!Utils::FileSystem::getFileSizeAndModificationTime(path, &size, &modified) || modified >= expired)
+				continue;
+
+			Entry entry;
+			bool valid;
+
+			{
+				std::ifstream file(path, std::ios::in | std::ios::binary);
+				valid = file.is_open() && readHeader(file, entry);
+			}
+
+			if ((!valid || (!entry.isFresh() && !entry.canRevalidate())) && Utils::FileSystem::removeFile(path))
+				freed += size;
+		}
+	}
+
+	if (freed > 0)
+	{
+		LOG(LogInfo) << "ScraperCache : " << (freed / 1024) << "KB of expired entries removed from the cache";
+	}
+}
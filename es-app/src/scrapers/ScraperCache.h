@@ -0,0 +1,48 @@
+#pragma once
+#ifndef ES_APP_SCRAPERS_SCRAPER_CACHE_H
+#define ES_APP_SCRAPERS_SCRAPER_CACHE_H
+
+#include <atomic>
+#include <istream>
+#include <string>
+#include <time.h>
+
+// On-disk cache of the scrapers' API responses & of the medias they downloaded, in ~/.emulationstation/cache/scraper/{scraper}.
+// Responses are keyed by their URL, which holds the system & the rom name / hash, without the credentials.
+// Entries older than "ScraperCacheDays" are revalidated with the ETag / Last-Modified the server gave, 0 days disables the cache.
+class ScraperCache
+{
+public:
+	struct Entry
+	{
+		Entry() : time(0) { }
+
+		std::string content;
+		std::string etag;
+		std::string lastModified;
+		time_t		time;
+
+		bool isFresh();
+		bool canRevalidate() { return !etag.empty() || !lastModified.empty(); }
+	};
+
+	static bool isEnabled();
+
+	static bool get(const std::string& url, Entry& entry);
+	static void put(const std::string& url, const std::string& content, const std::string& etag, const std::string& lastModified);
+
+	// Media downloaded from url, still on disk as it was saved. Returns the file, or an empty string.
+	// expectedPath is where the media would be saved : the extension may differ, the file name must not
+	static std::string findMedia(const std::string& url, const std::string& expectedPath);
+	static void addMedia(const std::string& url, const std::string& path);
+
+	// Removes the expired medias & the expired responses that can't be revalidated, or the whole cache once it is disabled. Meant for a background thread
+	static void sweep(const std::atomic<bool>* cancel = nullptr);
+
+private:
+	static std::string getPath(const std::string& url, const std::string& folder);
+	static std::string getCacheKey(const std::string& url);
+	static bool readHeader(std::istream& file, Entry& entry);
+};
+
+#endif // ES_APP_SCRAPERS_SCRAPER_CACHE_H
@@ -315,12 +315,9 @@ void ScreenScraperScraper::generateRequests(const ScraperSearchParams& params,
 	}
 }
 
-// Process should return false only when we reached a maximum scrap by minute, to retry
-bool ScreenScraperRequest::process(HttpReq* request, std::vector<ScraperSearchResult>& results)
+// Process returns false when the content is not a game description (quota message, unknown game...) : it is not cached
+bool ScreenScraperRequest::process(const std::string& content, std::vector<ScraperSearchResult>& results)
 {
-	assert(request->status() == HttpReq::REQ_SUCCESS);
-
-	auto content = request->getContent();
 	if (content.empty())
 		return false;
 
@@ -341,10 +338,7 @@ bool ScreenScraperRequest::process(HttpReq* request, std::vector<ScraperSearchRe
 		//setError(err); Don't consider it an error -> Request is a success. Simply : Game is not found		
 		LOG(LogWarning) << err;
 				
-		if (Utils::String::toLower(content).find("maximum threads per minute reached") != std::string::npos)
-			return false;
-		
-		return true;
+		return false;
 	}
 
 	processGame(doc, results);
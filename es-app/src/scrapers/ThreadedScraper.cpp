@@ -6,30 +6,34 @@
 #include "guis/GuiMsgBox.h"
 #include "Gamelist.h"
 #include "Log.h"
+#include <algorithm>
 
 #define GUIICON _U("\uF03E ")
 
+// Media downloads run in parallel with the lookups, but never less than this
+#define MIN_PARALLEL_DOWNLOADS	2
+// Lookups are paused when that many medias per download slot are waiting
+#define DOWNLOAD_QUEUE_FACTOR	4
+// Downloads are paused when that many images are waiting to be resized
+#define MAX_PENDING_RESIZES		8
+
 ThreadedScraper* ThreadedScraper::mInstance = nullptr;
 bool ThreadedScraper::mPaused = false;
 
 ThreadedScraper::ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches, int threadCount)
-	: mSearchQueue(searches), mWindow(window)
+	: mSearchQueue(searches), mWindow(window), mResizeTasks(Utils::TaskPriority::Low)
 {
 	mExitCode = ASYNC_IN_PROGRESS;
 	mTotal = (int) mSearchQueue.size();
+	mDone = 0;
+	mMaxDownloads = std::max(threadCount, MIN_PARALLEL_DOWNLOADS);
+	mLastRateUpdate = std::chrono::steady_clock::now();
 
-	mWndNotification = mWindow->createAsyncNotificationComponent();
+	mWndNotification = mWindow->createAsyncNotificationComponent(true);
 	mWndNotification->updateTitle(GUIICON + _("SCRAPING"));
 
 	for (int i = 0; i < threadCount; i++)
-	{
-		if (mSearchQueue.size() == 0)
-			break;
-
-		ScraperThread* thread = new ScraperThread(i);
-		mScraperThreads.push_back(thread);
-		ProcessNextGame(thread);
-	}	
+		mScraperThreads.push_back(new ScraperThread(i));
 
 	mHandle = new std::thread(&ThreadedScraper::run, this);	
 }
@@ -49,6 +53,15 @@ void ThreadedScraper::ProcessNextGame(ScraperThread* thread)
 
 ThreadedScraper::~ThreadedScraper()
 {
+	// Resizes still queued are dropped, the running ones are finished before their jobs are deleted
+	mResizeTasks.cancel();
+	mResizeTasks.wait();
+
+	for (auto job : mJobs)
+		delete job;
+
+	mJobs.clear();
+
 	mWndNotification->close();
 	mWndNotification = nullptr;
 
@@ -69,7 +82,7 @@ ScraperThread::ScraperThread(int threadId)
 {
 	mThreadId = threadId;
 	mErrorStatus = 0;
-	mStatus = ASYNC_IN_PROGRESS;
+	mStatus = ASYNC_DONE; // idle
 }
 
 void ScraperThread::run(const ScraperSearchParams& params)
@@ -79,7 +92,6 @@ void ScraperThread::run(const ScraperSearchParams& params)
 	mStatusString = "";
 	mStatus = ASYNC_IN_PROGRESS;
 	mSearch = params;
-	mMDResolveHandle.reset();
 
 	mSearchHandle = Scraper::getScraper()->search(params);
 }
@@ -100,12 +112,7 @@ int ScraperThread::updateState()
 		if (status == ASYNC_DONE)
 		{
 			if (results.size() > 0)
-			{
-				if (results[0].hasMedia())
-					mMDResolveHandle = results[0].resolveMetaDataAssets(mSearch);
-				else
-					acceptResult(results[0]);
-			}
+				acceptResult(results[0]);
 			else
 			{
 				mStatus = ASYNC_DONE;
@@ -116,23 +123,6 @@ int ScraperThread::updateState()
 			processError(httpCode, statusString);
 	}
 
-	if (mMDResolveHandle && mMDResolveHandle->status() != ASYNC_IN_PROGRESS)
-	{
-		auto status = mMDResolveHandle->status();
-		auto result = mMDResolveHandle->getResult();
-		auto statusString = mMDResolveHandle->getStatusString();
-		auto httpCode = mMDResolveHandle->getErrorCode();
-
-		LOG(LogInfo) << "[Thread " << mThreadId << "] ResolveResponse : " << statusString;
-
-		mMDResolveHandle.reset();
-
-		if (status == ASYNC_DONE)
-			acceptResult(result);
-		else if (status == ASYNC_ERROR)
-			processError(httpCode, statusString);
-	}
-
 	return mStatus;
 }
 
@@ -150,6 +140,171 @@ void ThreadedScraper::processError(int status, const std::string statusString)
 		mErrors.push_back(statusString);
 }
 
+bool ThreadedScraper::updateLookups()
+{
+	bool progress = false;
+
+	for (auto thread : mScraperThreads)
+	{
+		if (mExitCode != ASYNC_IN_PROGRESS)
+			break;
+
+		if (!thread->isIdle())
+		{
+			int state = thread->updateState();
+			if (state == ASYNC_IN_PROGRESS)
+				continue;
+
+			progress = true;
+			mLookups.count++;
+
+			if (state == ASYNC_ERROR)
+			{
+				processError(thread->getError(), thread->getErrorString());
+				mDone++;
+				updateUI();
+			}
+			else
+			{
+				ScrapeJob* job = new ScrapeJob();
+				job->search = thread->getSearchParams();
+				job->result = thread->getResult();
+
+				if (!job->result.mdl.getName().empty())
+				{
+					for (auto& media : job->result.getMediaToDownload(job->search))
+					{
+						MediaJob* mediaJob = new MediaJob();
+						mediaJob->job = job;
+						mediaJob->media = media;
+						job->medias.push_back(std::unique_ptr<MediaJob>(mediaJob));
+						mDownloadQueue.push_back(mediaJob);
+					}
+				}
+
+				job->pendingMedias = (int)job->medias.size();
+				mJobs.push_back(job);
+
+				if (job->pendingMedias == 0)
+					onJobDone(job);
+			}
+		}
+
+		// Back-pressure : no new lookup while the download stage is saturated
+		if (thread->isIdle() && !mSearchQueue.empty() && mExitCode == ASYNC_IN_PROGRESS && (int)mDownloadQueue.size() < mMaxDownloads * DOWNLOAD_QUEUE_FACTOR)
+		{
+			ProcessNextGame(thread);
+			progress = true;
+		}
+	}
+
+	return progress;
+}
+
+bool ThreadedScraper::updateDownloads()
+{
+	bool progress = false;
+
+	for (auto it = mDownloads.begin(); it != mDownloads.end(); )
+	{
+		MediaJob* media = *it;
+
+		auto status = media->handle->status();
+		if (status == ASYNC_IN_PROGRESS)
+		{
+			++it;
+			continue;
+		}
+
+		it = mDownloads.erase(it);
+		progress = true;
+		mDownloaded.count++;
+
+		if (status == ASYNC_ERROR)
+		{
+			LOG(LogInfo) << "ThreadedScraper::DownloadResponse : " << media->media.url << " " << media->handle->getStatusString();
+
+			processError(media->handle->getErrorCode(), media->handle->getStatusString());
+			onMediaDone(media, false);
+		}
+		else if (media->handle->needsResize())
+		{
+			mResizeTasks.queue([this, media]
+			{
+				media->handle->resize();
+
+				std::unique_lock<std::mutex> lock(mResizeLock);
+				mResized.push_back(media);
+			});
+		}
+		else
+			onMediaDone(media, true);
+	}
+
+	// Back-pressure : don't download faster than the images are resized
+	while (mExitCode == ASYNC_IN_PROGRESS && (int)mDownloads.size() < mMaxDownloads && !mDownloadQueue.empty() && mResizeTasks.pending() < MAX_PENDING_RESIZES)
+	{
+		MediaJob* media = mDownloadQueue.front();
+		mDownloadQueue.pop_front();
+
+		media->handle = MDResolveHandle::downloadImageAsync(media->media.url, media->media.path, media->media.resize, true);
+		mDownloads.push_back(media);
+		progress = true;
+	}
+
+	return progress;
+}
+
+bool ThreadedScraper::updateResizes()
+{
+	std::vector<MediaJob*> resized;
+
+	{
+		std::unique_lock<std::mutex> lock(mResizeLock);
+		resized.swap(mResized);
+	}
+
+	for (auto media : resized)
+	{
+		mResizedCount.count++;
+		onMediaDone(media, true);
+	}
+
+	return !resized.empty();
+}
+
+void ThreadedScraper::onMediaDone(MediaJob* media, bool success)
+{
+	ScrapeJob* job = media->job;
+
+	if (success)
+		job->result.setDownloadedMedia(media->media.id, media->handle->getImageFileName());
+	else
+		job->failed = true;
+
+	media->handle.reset();
+
+	job->pendingMedias--;
+	if (job->pendingMedias == 0)
+		onJobDone(job);
+}
+
+void ThreadedScraper::onJobDone(ScrapeJob* job)
+{
+	// Like a failed lookup, a game whose media failed to download is not updated
+	if (!job->failed)
+		acceptResult(*job);
+
+	auto it = std::find(mJobs.begin(), mJobs.end(), job);
+	if (it != mJobs.end())
+		mJobs.erase(it);
+
+	delete job;
+
+	mDone++;
+	updateUI();
+}
+
 void ThreadedScraper::run()
 {
 	while (mExitCode == ASYNC_IN_PROGRESS)
@@ -162,47 +317,29 @@ void ThreadedScraper::run()
 				std::this_thread::sleep_for(std::chrono::milliseconds(500));
 			}
 		}
-		
-		for (auto iter = mScraperThreads.cbegin(); iter != mScraperThreads.cend(); ++iter)
-		{
-			if (mExitCode != ASYNC_IN_PROGRESS)
-				break;
 
-			auto mScraperThread = *iter;
+		// Downstream first, so the lookups see the room freed in the download queue
+		bool progress = updateResizes();
+		progress |= updateDownloads();
+		progress |= updateLookups();
 
-			int state = mScraperThread->updateState();
-			switch (state)
-			{
-			case ASYNC_DONE:
-				acceptResult(*mScraperThread);
-				break;
-
-			case ASYNC_ERROR:
-				processError(mScraperThread->getError(), mScraperThread->getErrorString());
-				break;
-
-			default:
-				//std::this_thread::yield();
-				// std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				break;
-			}
+		if (mExitCode != ASYNC_IN_PROGRESS)
+			break;
 
-			if (mExitCode == ASYNC_IN_PROGRESS && state != ASYNC_IN_PROGRESS)
-			{
-				if (!mSearchQueue.empty())
-					ProcessNextGame(mScraperThread);
-				else
-				{					
-					mScraperThreads.erase(iter);
-					if (mScraperThreads.size() == 0)
-					{
-						mExitCode = ASYNC_DONE;
-						LOG(LogDebug) << "ThreadedScraper::finished";
-					}
-					break;
-				}
-			}
+		bool lookupsIdle = std::all_of(mScraperThreads.cbegin(), mScraperThreads.cend(), [](ScraperThread* thread) { return thread->isIdle(); });
+		if (lookupsIdle && mSearchQueue.empty() && mJobs.empty())
+		{
+			mExitCode = ASYNC_DONE;
+			LOG(LogDebug) << "ThreadedScraper::finished";
+			break;
 		}
+
+		if (std::chrono::steady_clock::now() - mLastRateUpdate >= std::chrono::seconds(1))
+			updateUI();
+
+		// Nothing finished : sleep until a download completes. Resizes are not HTTP requests, they are checked sooner
+		if (!progress)
+			HttpReq::waitForAnyCompletion(mResizeTasks.pending() > 0 ? 20 : 100);
 	}
 	
 	if (mExitCode == ASYNC_DONE)
@@ -214,31 +351,46 @@ void ThreadedScraper::run()
 
 void ThreadedScraper::updateUI()
 {
-	int remaining = mTotal + 1 - mSearchQueue.size() - mScraperThreads.size();
-	if (remaining < 0)
-		remaining = 0;
+	auto now = std::chrono::steady_clock::now();
+
+	float elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastRateUpdate).count() / 1000.0f;
+	if (elapsed >= 1.0f)
+	{
+		for (auto counter : { &mLookups, &mDownloaded, &mResizedCount })
+		{
+			counter->rate = (counter->count - counter->lastCount) / elapsed;
+			counter->lastCount = counter->count;
+		}
+
+		mLastRateUpdate = now;
+	}
+
+	int current = std::min(mDone + 1, mTotal);
+	std::string idx = std::to_string(current) + "/" + std::to_string(mTotal);	
+	int percentDone = mDone * 100 / std::max(1, mTotal);
 
-	std::string idx = std::to_string(remaining) + "/" + std::to_string(mTotal);	
-	int percentDone = remaining * 100 / (mTotal + 1);
+	char rates[128];
+	snprintf(rates, sizeof(rates), "%s %.1f/s  %s %.1f/s  %s %.1f/s",
+		_("LOOKUPS").c_str(), mLookups.rate, _("MEDIAS").c_str(), mDownloaded.rate, _("RESIZES").c_str(), mResizedCount.rate);
 
 	mWndNotification->updateTitle(GUIICON + _("SCRAPING") + " " + idx);
-	mWndNotification->updateText(mCurrentGame);
+	mWndNotification->updateText(mCurrentGame, rates);
 	mWndNotification->updatePercent(percentDone);
 }
 
-void ThreadedScraper::acceptResult(ScraperThread& thread)
+void ThreadedScraper::acceptResult(ScrapeJob& job)
 {
 	LOG(LogDebug) << "ThreadedScraper::acceptResult >>";
 
-	ScraperSearchResult& result = thread.getResult();
+	ScraperSearchResult& result = job.result;
 	if (result.mdl.getName().empty())
 	{		
 		auto scraperName = Scraper::getScraperName(Scraper::getScraper());
-		thread.getSearchParams().game->getMetadata().setScrapeDate(scraperName);
+		job.search.game->getMetadata().setScrapeDate(scraperName);
 		return;
 	}
 
-	ScraperSearchParams& search = thread.getSearchParams();
+	ScraperSearchParams& search = job.search;
 	auto game = search.game;
 
 	mWindow->postToUiThread([game, result]()
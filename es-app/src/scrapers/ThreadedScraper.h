@@ -1,9 +1,14 @@
 #pragma once
 
 #include <thread>
+#include <chrono>
+#include <deque>
+#include <mutex>
 #include "Scraper.h"
 #include "components/AsyncNotificationComponent.h"
+#include "utils/ThreadPool.h"
 
+// API lookup slot : searches one game at a time. Media downloads are done by the ThreadedScraper pipeline
 class ScraperThread
 {
 public:
@@ -17,10 +22,12 @@ public:
 	int getError() { return mErrorStatus; }
 	std::string getErrorString() { return mStatusString; }
 
+	bool isIdle() { return mStatus != ASYNC_IN_PROGRESS; }
+
 	int mThreadId;
 
 private:
-	void acceptResult(ScraperSearchResult& result)
+	void acceptResult(const ScraperSearchResult& result)
 	{
 		mResult = result;
 		mStatus = ASYNC_DONE;
@@ -34,7 +41,7 @@ private:
 		mStatusString = statusString;
 	}
 
-	
+
 	int mStatus;
 	int mErrorStatus;
 	std::string mStatusString;
@@ -42,17 +49,18 @@ private:
 	ScraperSearchResult mResult;
 	ScraperSearchParams mSearch;
 	std::unique_ptr<ScraperSearchHandle> mSearchHandle;
-	std::unique_ptr<MDResolveHandle> mMDResolveHandle;
 };
 
 
+// Scrapes games through three stages : API lookups (as many as the scraper allows), media downloads (bounded)
+// & image resizing (on the task executor). A stage stops feeding the next one when its queue is full.
 class ThreadedScraper
 {
 public:
 	static void start(Window* window, const std::queue<ScraperSearchParams>& searches);
 	static void stop();
 	static bool isRunning() { return mInstance != nullptr; }
-	
+
 	static void pause() { mPaused = true; }
 	static void resume() { mPaused = false; }
 
@@ -62,11 +70,49 @@ private:
 	ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches, int threadCount);
 	~ThreadedScraper();
 
+	struct ScrapeJob;
+
+	struct MediaJob
+	{
+		ScrapeJob* job;
+		ScraperMediaDownload media;
+		std::unique_ptr<ImageDownloadHandle> handle;
+	};
+
+	// A game whose metadata is known, waiting for its media. Only used by the pipeline thread, except the handles being resized
+	struct ScrapeJob
+	{
+		ScrapeJob() : pendingMedias(0), failed(false) { }
+
+		ScraperSearchParams search;
+		ScraperSearchResult result;
+		std::vector<std::unique_ptr<MediaJob>> medias;
+		int pendingMedias;
+		bool failed;
+	};
+
+	// Items processed by a stage, for the throughput displayed in the notification
+	struct StageCounter
+	{
+		StageCounter() : count(0), lastCount(0), rate(0) { }
+
+		int count;
+		int lastCount;
+		float rate; // per second
+	};
+
 	void ProcessNextGame(ScraperThread* thread);
 
+	bool updateLookups();
+	bool updateDownloads();
+	bool updateResizes();
+
+	void onMediaDone(MediaJob* media, bool success);
+	void onJobDone(ScrapeJob* job);
+
 	Window* mWindow;
 	AsyncNotificationComponent* mWndNotification;
-	
+
 	std::string		mCurrentGame;
 
 	std::vector<std::string> mErrors;
@@ -77,15 +123,30 @@ private:
 	std::queue<ScraperSearchParams> mSearchQueue;
 
 	std::vector<ScraperThread*> mScraperThreads;
-	
-	void acceptResult(ScraperThread& thread);
+
+	int							mMaxDownloads;
+	std::deque<MediaJob*>		mDownloadQueue;
+	std::vector<MediaJob*>		mDownloads;
+
+	Utils::TaskGroup			mResizeTasks;
+	std::mutex					mResizeLock;
+	std::vector<MediaJob*>		mResized;	// filled by the executor threads
+
+	std::vector<ScrapeJob*>		mJobs;
+
+	void acceptResult(ScrapeJob& job);
 	void processError(int status, const std::string statusString);
 	void updateUI();
 
+	StageCounter mLookups;
+	StageCounter mDownloaded;
+	StageCounter mResizedCount;
+	std::chrono::steady_clock::time_point mLastRateUpdate;
+
 	int mTotal;
+	int mDone;
 	int mExitCode;
 
 	static bool mPaused;
 	static ThreadedScraper* mInstance;
 };
-
@@ -12,9 +12,16 @@
 #include "CollectionSystemManager.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
-#include "utils/md5.h"
 #include "scrapers/Scraper.h"
+#include "Log.h"
 #include <unordered_map>
+#include <algorithm>
+#include <ctime>
+
+#define GAMES_PER_CHUNK 64
+
+// Change counters restart with ES : tags from a previous run must not match
+static const std::string sInstanceTag = std::to_string((long long)time(NULL));
 
 void HttpApi::getSystemDataJson(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, SystemData* sys)
 {
@@ -96,63 +103,58 @@ std::string HttpApi::getSystemList()
 
 std::string HttpApi::getFileDataId(FileData* game)
 {
-	MD5 md5;
-	md5.update(game->getPath().c_str(), game->getPath().size());
-	md5.finalize();
-	return md5.hexdigest();
+	return SystemData::getGameId(game);
 }
 
 FileData* HttpApi::findFileData(SystemData* system, const std::string& id)
 {
-	std::stack<FolderData*> stack;
-	stack.push(system->getRootFolder());
-
-	while (stack.size())
-	{
-		FolderData* current = stack.top();
-		stack.pop();
-
-		for (auto it : current->getChildren())
-		{			
-			if (it->getType() == FOLDER)
-				stack.push((FolderData*)it);
-			else if (getFileDataId(it) == id)
-				return it;
-		}
-	}
-
-	return nullptr;
+	return system->findGameById(id);
 }
 
-void HttpApi::getFileDataJson(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, FileData* game)
+template<typename Writer>
+void HttpApi::getFileDataJson(Writer& writer, FileData* game, const std::set<std::string>* fields)
 {
 	if (game->getType() != GAME)
 		return;
 
+	auto hasField = [fields](const std::string& key) { return fields == nullptr || fields->find(key) != fields->cend(); };
+
 	std::string id = getFileDataId(game);
 
 	writer.StartObject();
-	writer.Key("id"); writer.String(id.c_str());
-	writer.Key("path"); writer.String(game->getPath().c_str());
-	writer.Key("name"); writer.String(game->getName().c_str());
 
-	auto meta = game->getMetadata();
+	if (hasField("id"))
+	{
+		writer.Key("id"); writer.String(id.c_str());
+	}
+
+	if (hasField("path"))
+	{
+		writer.Key("path"); writer.String(game->getPath().c_str());
+	}
+
+	if (hasField("name"))
+	{
+		writer.Key("name"); writer.String(game->getName().c_str());
+	}
+
+	auto& meta = game->getMetadata();
 	for (auto mdd : MetaDataList::getMDD())
 	{
 		if (mdd.id == MetaDataId::Name)
 			continue;
 
+		std::string key = mdd.id == MetaDataId::ScraperId ? "scraperId" : mdd.key;
+		if (!hasField(key))
+			continue;
+
 		std::string value = game->getMetadata(mdd.id);
 		if (!value.empty())
 		{
 			if (meta.getType(mdd.id) == MD_PATH)
 				value = "/systems/" + game->getSourceFileData()->getSystemName() + "/games/" + id + "/media/" + mdd.key;
 
-			if (mdd.id == MetaDataId::ScraperId)
-				writer.Key("scraperId");
-			else 
-				writer.Key(mdd.key.c_str());
-
+			writer.Key(key.c_str());
 			writer.String(value.c_str());
 		}
 	}
@@ -273,14 +275,17 @@ std::string HttpApi::ToJson(SystemData* system)
 	return s.GetString();
 }
 
-std::string HttpApi::getSystemGames(SystemData* system)
+std::string HttpApi::getSystemGamesETag(SystemData* system)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(s);
+	return "\"" + sInstanceTag + "-" + system->getName() + "-" + std::to_string(system->getChangeCounter()) + "\"";
+}
 
-	writer.StartArray();
+HttpApi::GameListStream::GameListStream(SystemData* system, size_t offset, size_t limit, const std::string& fields, bool pretty)
+	: mSystem(system), mPretty(pretty), mComplete(false)
+{
+	mChangeCounter = system->getChangeCounter();
 
-	std::vector<FileData*> files;
+	std::vector<FileData*> games;
 
 	std::stack<FolderData*> stack;
 	stack.push(system->getRootFolder());
@@ -292,18 +297,91 @@ std::string HttpApi::getSystemGames(SystemData* system)
 
 		for (auto it : current->getChildren())
 		{
-			files.push_back(it);
 			if (it->getType() == FOLDER)
 				stack.push((FolderData*)it);
+			else if (it->getType() == GAME)
+				games.push_back(it);
 		}
 	}
 
-	for (auto game : files)
-		getFileDataJson(writer, game);
+	for (auto field : Utils::String::commaStringToVector(fields))
+	{
+		field = Utils::String::trim(field);
+		if (!field.empty())
+			mFields.insert(field);
+	}
 
-	writer.EndArray();
+	mTotalCount = games.size();
 
-	return s.GetString();
+	size_t start = std::min(offset, games.size());
+	size_t end = limit == 0 ? games.size() : std::min(start + limit, games.size());
+
+	// Only the ids of the page are kept : next() resolves them through the system's id index, under its lock
+	for (size_t i = start; i < end; i++)
+		mIds.push_back(SystemData::getGameId(games[i]));
+
+	mPosition = 0;
+	mWrittenCount = 0;
+}
+
+bool HttpApi::GameListStream::next(std::string& chunk)
+{
+	if (mComplete)
+		return false;
+
+	// The response would no longer match its ETag : cut it, the client will ask again
+	if (mSystem->getChangeCounter() != mChangeCounter)
+	{
+		LOG(LogWarning) << "HttpApi : games of " << mSystem->getName() << " changed while they were sent, response aborted";
+		return false;
+	}
+
+	const std::set<std::string>* fields = mFields.empty() ? nullptr : &mFields;
+	bool pretty = mPretty;
+
+	rapidjson::StringBuffer s;
+	if (mPosition == 0)
+		s.Put('[');
+
+	size_t written = mWrittenCount;
+	size_t end = std::min(mPosition + GAMES_PER_CHUNK, mIds.size());
+
+	// Games removed since the stream was created are skipped
+	mSystem->visitGamesById(mIds, mPosition, end, [&s, &written, fields, pretty](FileData* game)
+	{
+		if (written > 0)
+			s.Put(',');
+
+		written++;
+
+		if (pretty)
+		{
+			s.Put('\n');
+
+			rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(s);
+			getFileDataJson(writer, game, fields);
+		}
+		else
+		{
+			rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+			getFileDataJson(writer, game, fields);
+		}
+	});
+
+	mPosition = end;
+	mWrittenCount = written;
+
+	if (mPosition >= mIds.size())
+	{
+		if (pretty && mWrittenCount > 0)
+			s.Put('\n');
+
+		s.Put(']');
+		mComplete = true;
+	}
+
+	chunk.assign(s.GetString(), s.GetSize());
+	return true;
 }
 
 
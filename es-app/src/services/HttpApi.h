@@ -1,10 +1,13 @@
 #pragma once
 
 #include <string>
+#include <set>
+#include <vector>
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/pointer.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 
 class SystemData;
 class FileData;
@@ -12,8 +15,36 @@ class FileData;
 class HttpApi
 {
 public:
+	// Games of a system as a JSON array, serialized a few games at a time so large systems are streamed instead of built in memory.
+	// offset & limit (0 = no limit) select a page, fields is a comma separated list of the keys to output (empty = all).
+	class GameListStream
+	{
+	public:
+		GameListStream(SystemData* system, size_t offset, size_t limit, const std::string& fields, bool pretty);
+
+		// Number of games in the system, before paging
+		size_t getTotalCount() { return mTotalCount; }
+
+		// Next part of the array. Returns false when the array is closed, or if the games of the system changed since the stream was created
+		bool next(std::string& chunk);
+		bool isComplete() { return mComplete; }
+
+	private:
+		SystemData*				mSystem;
+		unsigned int			mChangeCounter;
+		std::vector<std::string> mIds;		// game ids of the page
+		std::set<std::string>	mFields;
+		size_t					mTotalCount;
+		size_t					mPosition;	// in mIds
+		size_t					mWrittenCount;
+		bool					mPretty;
+		bool					mComplete;
+	};
+
 	static std::string getSystemList();
-	static std::string getSystemGames(SystemData* system);
+
+	// Strong validator of the game list of a system, changes whenever games are added, removed or saved
+	static std::string getSystemGamesETag(SystemData* system);
 
 	static std::string ToJson(SystemData* system);
 	static std::string ToJson(FileData* file);
@@ -27,6 +58,6 @@ public:
 
 private:
 	static std::string getFileDataId(FileData* game);
-	static void getFileDataJson(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, FileData* game);
+	template<typename Writer> static void getFileDataJson(Writer& writer, FileData* game, const std::set<std::string>* fields = nullptr);
 	static void getSystemDataJson(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, SystemData* sys);
 };
\ No newline at end of file
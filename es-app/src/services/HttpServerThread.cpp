@@ -16,6 +16,7 @@
 #include "guis/GuiMenu.h"
 #include "guis/GuiMsgBox.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
 #include "HttpApi.h"
 #include "Settings.h"
 #include "ApiSystem.h"
@@ -37,6 +38,7 @@ System/Games APIS
 GET  /systems
 GET  /systems/{systemName}
 GET  /systems/{systemName}/logo
+GET  /systems/{systemName}/games								-> optional ?offset=&limit= paging, ?fields=id,name,... projection, ?pretty=1. Supports If-None-Match
 GET  /systems/{systemName}/games/{gameId}		
 POST /systems/{systemName}/games/{gameId}						-> body must contain the game metadatas to save as application/json
 GET  /systems/{systemName}/games/{gameId}/media/{mediaType}
@@ -273,7 +275,44 @@ void HttpServerThread::run()
 		SystemData* system = SystemData::getSystem(systemName);
 		if (system != nullptr)
 		{
-			res.set_content(HttpApi::getSystemGames(system), "application/json");
+			std::string etag = HttpApi::getSystemGamesETag(system);
+			res.set_header("ETag", etag);
+			res.set_header("Cache-Control", "no-cache");
+
+			if (req.has_header("If-None-Match"))
+			{
+				std::string ifNoneMatch = req.get_header_value("If-None-Match");
+				if (ifNoneMatch == "*" || ifNoneMatch.find(etag) != std::string::npos)
+				{
+					res.status = 304;
+					return;
+				}
+			}
+
+			size_t offset = req.has_param("offset") ? (size_t)std::max(0, Utils::String::toInteger(req.get_param_value("offset"))) : 0;
+			size_t limit = req.has_param("limit") ? (size_t)std::max(0, Utils::String::toInteger(req.get_param_value("limit"))) : 0;
+			bool pretty = req.has_param("pretty") && req.get_param_value("pretty") != "0";
+
+			auto stream = std::make_shared<HttpApi::GameListStream>(system, offset, limit, req.get_param_value("fields"), pretty);
+			res.set_header("X-Total-Count", std::to_string(stream->getTotalCount()));
+
+			res.set_chunked_content_provider([stream](size_t, httplib::DataSink& sink)
+			{
+				std::string chunk;
+				if (stream->next(chunk))
+				{
+					sink.write(chunk.data(), chunk.size());
+					return true;
+				}
+
+				if (!stream->isComplete())
+					return false;
+
+				sink.done();
+				return true;
+			});
+
+			res.set_header("Content-Type", "application/json");
 			return;
 		}
 		
@@ -569,7 +608,7 @@ void HttpServerThread::run()
 			if (fileMap.find(file->getPath()) != fileMap.cend())
 				file->getMetadata().setDirty();
 
-		updateGamelist(system);
+		updateGamelist(system, true);
 
 		if (deleteSystem)
 		{		
@@ -1120,16 +1120,16 @@ void ViewController::reloadAll(Window* window, bool reloadTheme)
 	
 	if (reloadTheme && cursorMap.size() > 0)
 	{
-		int processedSystem = 0;
+		std::atomic<int> processedSystem(0);
 		int systemCount = cursorMap.size();
 
-		Utils::ThreadPool pool;
+		Utils::TaskGroup pool(Utils::TaskPriority::High);
 
 		for (auto it = cursorMap.cbegin(); it != cursorMap.cend(); it++)
 		{
 			SystemData* pooledSystem = it->first;
 
-			pool.queueWorkItem([pooledSystem, &processedSystem]
+			pool.queue([pooledSystem, &processedSystem]
 			{ 
 				pooledSystem->loadTheme();
 				pooledSystem->resetFilters();
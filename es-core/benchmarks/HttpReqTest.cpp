@@ -0,0 +1,114 @@
+// Manual test of the HttpReq network thread against a local stand-in server.
+//
+//   python3 es-core/benchmarks/httpreq_server.py 8765 &
+//   ./httpreq-test http://127.0.0.1:8765
+//
+// Build with -DENABLE_BENCHMARKS=ON, and -DCMAKE_CXX_FLAGS=-fsanitize=thread to check the locking.
+// Returns 0 when every check passed.
+
+#include "HttpReq.h"
+#include "utils/FileSystemUtil.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+static int sFailures = 0;
+
+static void check(bool condition, const std::string& name)
+{
+	std::cout << (condition ? "[ OK ] " : "[FAIL] ") << name << std::endl;
+	if (!condition)
+		sFailures++;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string baseUrl = argc > 1 ? argv[1] : "http://127.0.0.1:8765";
+	int parallel = argc > 2 ? atoi(argv[2]) : 64;
+
+	// Parallel GETs, waited with waitForAnyCompletion like ThreadedScraper does
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::unique_ptr<HttpReq>> requests;
+		for (int i = 0; i < parallel; i++)
+			requests.push_back(std::unique_ptr<HttpReq>(new HttpReq(baseUrl + "/ok?i=" + std::to_string(i))));
+
+		while (true)
+		{
+			bool done = true;
+			for (auto& req : requests)
+				if (req->status() == HttpReq::REQ_IN_PROGRESS)
+					done = false;
+
+			if (done)
+				break;
+
+			HttpReq::waitForAnyCompletion(100);
+		}
+
+		bool ok = true;
+		for (auto& req : requests)
+			ok = ok && req->status() == HttpReq::REQ_SUCCESS && req->getContent() == "ok";
+
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		check(ok, std::to_string(parallel) + " parallel GETs (" + std::to_string(ms) + " ms)");
+	}
+
+	// Download to a file
+	{
+		std::string path = Utils::FileSystem::getGenericPath(Utils::FileSystem::getTempPath() + "/httpreq-test.bin");
+
+		HttpReq req(baseUrl + "/big?size=1048576", path);
+		req.wait();
+
+		check(req.status() == HttpReq::REQ_SUCCESS && Utils::FileSystem::getFileSize(path) == 1048576, "download to file");
+		Utils::FileSystem::removeFile(path);
+	}
+
+	// Error status : the message must be set once the status is visible
+	{
+		HttpReq req(baseUrl + "/status/404");
+		while (req.status() == HttpReq::REQ_IN_PROGRESS)
+			HttpReq::waitForAnyCompletion(100);
+
+		check(req.status() == HttpReq::REQ_404_NOTFOUND && req.getErrorMsg() == "status 404", "404 with error message");
+	}
+
+	// Revalidation
+	{
+		HttpReqOptions options;
+		options.customHeaders.push_back("If-None-Match: \"v1\"");
+
+		HttpReq req(baseUrl + "/etag", &options);
+		req.wait();
+
+		check(req.status() == HttpReq::REQ_304_NOTMODIFIED, "304 on matching If-None-Match");
+	}
+
+	// Refused connection
+	{
+		HttpReq req("http://127.0.0.1:1/ok");
+		req.wait();
+
+		check(req.status() == HttpReq::REQ_IO_ERROR && !req.getErrorMsg().empty(), "refused connection");
+	}
+
+	// Deletion while the transfer is running
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		HttpReq* req = new HttpReq(baseUrl + "/slow");
+		HttpReq::waitForAnyCompletion(300);
+		delete req;
+
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		check(ms < 2000, "deletion mid-transfer (" + std::to_string(ms) + " ms)");
+	}
+
+	std::cout << (sFailures == 0 ? "All checks passed" : std::to_string(sFailures) + " check(s) failed") << std::endl;
+	return sFailures == 0 ? 0 : 1;
+}
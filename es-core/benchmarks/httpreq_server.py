@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# Local stand-in server for httpreq-test.
+#
+#   python3 httpreq_server.py [port]        (default 8765)
+#
+#   /ok              200, "ok"
+#   /big?size=N      200, N bytes (default 4 MB)
+#   /slow            200, one byte every 100 ms for 30 s
+#   /status/<code>   <code>, "status <code>"
+#   /etag            200 with ETag "v1", 304 when If-None-Match matches
+
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse, parse_qs
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def reply(self, code, body, headers=None):
+        self.send_response(code)
+        self.send_header("Content-Length", str(len(body)))
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        url = urlparse(self.path)
+
+        if url.path == "/ok":
+            self.reply(200, b"ok")
+        elif url.path == "/big":
+            size = int(parse_qs(url.query).get("size", [4 * 1024 * 1024])[0])
+            self.reply(200, b"x" * size)
+        elif url.path == "/slow":
+            self.send_response(200)
+            self.send_header("Content-Length", "300")
+            self.end_headers()
+            try:
+                for _ in range(300):
+                    self.wfile.write(b"x")
+                    self.wfile.flush()
+                    time.sleep(0.1)
+            except (BrokenPipeError, ConnectionResetError):
+                pass
+        elif url.path.startswith("/status/"):
+            code = int(url.path[len("/status/"):])
+            self.reply(code, ("status %d" % code).encode())
+        elif url.path == "/etag":
+            if self.headers.get("If-None-Match") == '"v1"':
+                self.send_response(304)
+                self.send_header("ETag", '"v1"')
+                self.end_headers()
+            else:
+                self.reply(200, b"etag content", {"ETag": '"v1"'})
+        else:
+            self.reply(404, b"not found")
+
+    def log_message(self, format, *args):
+        pass
+
+
+if __name__ == "__main__":
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else 8765
+    print("httpreq_server listening on http://127.0.0.1:%d" % port)
+    ThreadingHTTPServer(("127.0.0.1", port), Handler).serve_forever()
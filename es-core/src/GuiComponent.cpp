@@ -4,6 +4,7 @@
 #include "animations/AnimationController.h"
 #include "renderers/Renderer.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "ThemeData.h"
 #include "Window.h"
 #include <algorithm>
@@ -56,6 +57,8 @@ void GuiComponent::updateSelf(int deltaTime)
 {
 	if (mAnimationMap.size())
 	{
+		invalidate();
+
 		for (auto it = mAnimationMap.cbegin(), next_it = it; it != mAnimationMap.cend(); it = next_it)
 		{
 			++next_it;
@@ -72,6 +75,8 @@ void GuiComponent::updateChildren(int deltaTime)
 	for (auto it = mChildren.cbegin(), next_it = it; it != mChildren.cend(); it = next_it)
 	{
 		++next_it;
+
+		PROFILE_COMPONENT(*it);
 		TRYCATCH("GuiComponent::updateChildren", (*it)->update(deltaTime))
 	}
 }
@@ -104,8 +109,13 @@ void GuiComponent::render(const Transform4x4f& parentTrans)
 void GuiComponent::renderChildren(const Transform4x4f& transform) const
 {
 	for (auto child : mChildren)
+	{
 		if (child->mVisible)
+		{
+			PROFILE_COMPONENT(child);
 			TRYCATCH("GuiComponent::renderChildren", child->render(transform));
+		}
+	}
 }
 
 Vector3f GuiComponent::getPosition() const
@@ -502,6 +512,11 @@ void GuiComponent::cancelAllAnimations()
 	}
 }
 
+void GuiComponent::invalidate()
+{
+	Window::invalidate();
+}
+
 bool GuiComponent::isAnimationPlaying(unsigned char slot) const
 {
 	return mAnimationMap.find(slot) != mAnimationMap.cend();
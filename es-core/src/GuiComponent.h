@@ -122,6 +122,9 @@ public:
 	unsigned int getChildCount() const;
 	GuiComponent* getChild(unsigned int i) const;
 
+	// Asks the window to draw the next frame, for changes made outside of input handling
+	void invalidate();
+
 	// animation will be automatically deleted when it completes or is stopped.
 	bool isAnimationPlaying(unsigned char slot) const;
 	bool isAnimationReversed(unsigned char slot) const;
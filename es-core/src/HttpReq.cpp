@@ -3,6 +3,7 @@
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include <algorithm>
 #include <assert.h>
 #include <thread>
 
@@ -14,12 +15,237 @@
 #include <unistd.h>
 #endif
 
+#include <condition_variable>
 #include <mutex>
-static std::mutex mMutex;
 
-CURLM* HttpReq::s_multi_handle = curl_multi_init();
+// Transfers of all requests are driven by one network thread, sleeping in curl_multi_poll until a socket is ready,
+// a timeout expires or a request is added / removed. The requests only read their status.
+class HttpReqReactor
+{
+public:
+	static HttpReqReactor& getInstance()
+	{
+		static HttpReqReactor instance;
+		return instance;
+	}
+
+	void add(HttpReq* req)
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		mPendingAdds.push_back(req);
+		wakeup();
+	}
+
+	// Once this returns, curl no longer uses the handle
+	void remove(HttpReq* req)
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+
+		auto it = std::find(mPendingAdds.begin(), mPendingAdds.end(), req);
+		if (it != mPendingAdds.end())
+		{
+			mPendingAdds.erase(it);
+			return;
+		}
+
+		// Already finished : the handle was detached when the transfer ended
+		if (mRequests.find(req->mHandle) == mRequests.cend())
+			return;
+
+		mPendingRemoves.push_back(req->mHandle);
+		wakeup();
+
+		mRemoved.wait(lock, [this, req] { return std::find(mPendingRemoves.cbegin(), mPendingRemoves.cend(), req->mHandle) == mPendingRemoves.cend(); });
+	}
+
+	void waitForRequest(HttpReq* req)
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		mCompleted.wait(lock, [req] { return req->mStatus != HttpReq::REQ_IN_PROGRESS; });
+	}
+
+	void waitForAnyCompletion(int timeoutMs)
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+
+		unsigned int completions = mCompletions;
+		mCompleted.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this, completions] { return mCompletions != completions; });
+	}
+
+private:
+	HttpReqReactor() : mRunning(true), mCompletions(0)
+	{
+		mMultiHandle = curl_multi_init();
+
+		// Connections are kept alive in the multi handle's cache & reused by the next request to the same host
+		curl_multi_setopt(mMultiHandle, CURLMOPT_MAX_HOST_CONNECTIONS, 6L);
+		curl_multi_setopt(mMultiHandle, CURLMOPT_MAXCONNECTS, 16L);
+		curl_multi_setopt(mMultiHandle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+		mThread = std::thread(&HttpReqReactor::run, this);
+	}
+
+	~HttpReqReactor()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+			mRunning = false;
+			wakeup();
+		}
+
+		mThread.join();
+
+		for (auto it : mRequests)
+			curl_multi_remove_handle(mMultiHandle, it.first);
+
+		curl_multi_cleanup(mMultiHandle);
+	}
+
+	void wakeup()
+	{
+#if LIBCURL_VERSION_NUM >= 0x074400 // 7.68.0
+		curl_multi_wakeup(mMultiHandle);
+#endif
+	}
+
+	void detach(CURL* handle)
+	{
+		if (mRequests.erase(handle) == 0)
+			return;
+
+		CURLMcode merr = curl_multi_remove_handle(mMultiHandle, handle);
+		if (merr != CURLM_OK)
+		{
+			LOG(LogError) << "Error removing curl_easy handle from curl_multi: " << curl_multi_strerror(merr);
+		}
+	}
+
+	// Adds & removals are only applied by the network thread : the multi handle is not used by any other thread
+	void processPendingChanges()
+	{
+		unsigned int completions = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+
+			completions = mCompletions;
+			applyPendingChanges();
+			completions = mCompletions - completions;
+		}
+
+		// Waiters are woken once mLock is released, so they never block again on the network thread
+		if (completions != 0)
+			mCompleted.notify_all();
+	}
+
+	// mLock must be held
+	void applyPendingChanges()
+	{
+		for (auto handle : mPendingRemoves)
+			detach(handle);
+
+		if (!mPendingRemoves.empty())
+		{
+			mPendingRemoves.clear();
+			mRemoved.notify_all();
+		}
+
+		for (auto req : mPendingAdds)
+		{
+			CURLMcode merr = curl_multi_add_handle(mMultiHandle, req->mHandle);
+			if (merr != CURLM_OK)
+			{
+				req->closeStream();
+				req->onError(HttpReq::REQ_IO_ERROR, curl_multi_strerror(merr));
+				mCompletions++;
+				continue;
+			}
+
+			mRequests[req->mHandle] = req;
+		}
+
+		mPendingAdds.clear();
+	}
+
+	void run()
+	{
+		while (true)
+		{
+			processPendingChanges();
+
+			{
+				std::unique_lock<std::mutex> lock(mLock);
+				if (!mRunning)
+					break;
+			}
+
+			int running = 0;
+			CURLMcode merr = curl_multi_perform(mMultiHandle, &running);
+			if (merr != CURLM_OK && merr != CURLM_CALL_MULTI_PERFORM)
+			{
+				LOG(LogError) << "HttpReqReactor : curl_multi_perform failed : " << curl_multi_strerror(merr);
+			}
+
+			std::vector<std::pair<CURL*, CURLcode>> done;
+
+			int msgs_left;
+			CURLMsg* msg;
+			while ((msg = curl_multi_info_read(mMultiHandle, &msgs_left)) != nullptr)
+				if (msg->msg == CURLMSG_DONE)
+					done.push_back(std::make_pair(msg->easy_handle, msg->data.result));
+
+			if (!done.empty())
+			{
+				unsigned int completions = 0;
+
+				{
+					std::unique_lock<std::mutex> lock(mLock);
+
+					for (auto& item : done)
+					{
+						auto it = mRequests.find(item.first);
+						if (it == mRequests.cend())
+						{
+							LOG(LogError) << "Cannot find easy handle!";
+							continue;
+						}
 
-std::map<CURL*, HttpReq*> HttpReq::s_requests;
+						HttpReq* req = it->second;
+						detach(item.first);
+
+						req->onTransferDone(item.second);
+						mCompletions++;
+						completions++;
+					}
+				}
+
+				if (completions != 0)
+					mCompleted.notify_all();
+			}
+
+#if LIBCURL_VERSION_NUM >= 0x074400 // 7.68.0
+			curl_multi_poll(mMultiHandle, nullptr, 0, 1000, nullptr);
+#else
+			// No wakeup before 7.68 : keep the timeout short so new requests are started quickly
+			curl_multi_wait(mMultiHandle, nullptr, 0, 20, nullptr);
+#endif
+		}
+	}
+
+	CURLM*						mMultiHandle;
+	std::thread					mThread;
+	std::mutex					mLock;
+	bool						mRunning;
+
+	// Guarded by mLock. curl_multi_perform runs unlocked but only the network thread changes these
+	std::map<CURL*, HttpReq*>	mRequests;
+	std::vector<HttpReq*>		mPendingAdds;
+	std::vector<CURL*>			mPendingRemoves;
+
+	std::condition_variable		mRemoved;
+	std::condition_variable		mCompleted;
+	unsigned int				mCompletions;
+};
 
 std::string HttpReq::urlEncode(const std::string &s)
 {
@@ -93,7 +319,7 @@ std::string _regGetString(HKEY hKey, const std::string &strPath, const std::stri
 #endif
 
 HttpReq::HttpReq(const std::string& url, const std::string& outputFilename) 
-	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mFile(NULL)
+	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mQueued(false), mStreamError(false), mFile(NULL)
 {
 	HttpReqOptions options;
 	options.outputFilename = outputFilename;	
@@ -101,7 +327,7 @@ HttpReq::HttpReq(const std::string& url, const std::string& outputFilename)
 }
 
 HttpReq::HttpReq(const std::string& url, HttpReqOptions* options)
-	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mFile(NULL)
+	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mQueued(false), mStreamError(false), mFile(NULL)
 {
 	performRequest(url, options);
 }
@@ -122,8 +348,7 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 
 	if(mHandle == NULL)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError("curl_easy_init failed");
+		onError(REQ_IO_ERROR, "curl_easy_init failed");
 		return;
 	}
 
@@ -131,8 +356,7 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 	CURLcode err = curl_easy_setopt(mHandle, CURLOPT_URL, url.c_str());
 	if(err != CURLE_OK)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
+		onError(REQ_IO_ERROR, curl_easy_strerror(err));
 		return;
 	}
 
@@ -166,20 +390,24 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 	err = curl_easy_setopt(mHandle, CURLOPT_FOLLOWLOCATION, 1L);
 	if(err != CURLE_OK)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
+		onError(REQ_IO_ERROR, curl_easy_strerror(err));
 		return;
 	}
 
 	// Ignore expired SSL certificates
 	curl_easy_setopt(mHandle, CURLOPT_SSL_VERIFYPEER, 0L);
 
+	// Idle connections stay in the pool of the network thread, probe them so dead ones are not reused
+	curl_easy_setopt(mHandle, CURLOPT_TCP_KEEPALIVE, 1L);
+
+	// Wait for a pooled connection to the same host rather than opening a new one
+	curl_easy_setopt(mHandle, CURLOPT_PIPEWAIT, 1L);
+
 	//set curl to handle redirects
 	err = curl_easy_setopt(mHandle, CURLOPT_CONNECTTIMEOUT, 10L);
 	if (err != CURLE_OK)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
+		onError(REQ_IO_ERROR, curl_easy_strerror(err));
 		return;
 	}
 		
@@ -187,8 +415,7 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 	err = curl_easy_setopt(mHandle, CURLOPT_MAXREDIRS, 2L);
 	if(err != CURLE_OK)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
+		onError(REQ_IO_ERROR, curl_easy_strerror(err));
 		return;
 	}
 
@@ -196,8 +423,7 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 	err = curl_easy_setopt(mHandle, CURLOPT_REDIR_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS); 
 	if(err != CURLE_OK)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
+		onError(REQ_IO_ERROR, curl_easy_strerror(err));
 		return;
 	}
 
@@ -205,8 +431,7 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 	err = curl_easy_setopt(mHandle, CURLOPT_WRITEFUNCTION, &HttpReq::write_content);
 	if(err != CURLE_OK)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
+		onError(REQ_IO_ERROR, curl_easy_strerror(err));
 		return;
 	}
 
@@ -214,8 +439,17 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 	err = curl_easy_setopt(mHandle, CURLOPT_WRITEDATA, this);
 	if(err != CURLE_OK)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
+		onError(REQ_IO_ERROR, curl_easy_strerror(err));
+		return;
+	}
+
+	err = curl_easy_setopt(mHandle, CURLOPT_HEADERFUNCTION, &HttpReq::write_header);
+	if (err == CURLE_OK)
+		err = curl_easy_setopt(mHandle, CURLOPT_HEADERDATA, this);
+
+	if (err != CURLE_OK)
+	{
+		onError(REQ_IO_ERROR, curl_easy_strerror(err));
 		return;
 	}
 
@@ -223,8 +457,7 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 	err = curl_easy_setopt(mHandle, CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT x.y; Win64; x64; rv:10.0) Gecko/20100101 Firefox/10.0");
 	if (err != CURLE_OK)
 	{
-		mStatus = REQ_IO_ERROR;
-		onError(curl_easy_strerror(err));
+		onError(REQ_IO_ERROR, curl_easy_strerror(err));
 		return;
 	}
 
@@ -257,8 +490,6 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 	}
 #endif
 	
-	std::unique_lock<std::mutex> lock(mMutex);
-
 	if (!mFilePath.empty())
 	{
 		mTempStreamPath = outputFilename + ".tmp";
@@ -273,8 +504,7 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 
 		if (mFile == nullptr)
 		{
-			mStatus = REQ_IO_ERROR;
-			onError("IO Error (disk is Readonly ?)");			
+			onError(REQ_IO_ERROR, "IO Error (disk is Readonly ?)");			
 			return;
 		}
 
@@ -282,18 +512,9 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 		Utils::FileSystem::removeFile(outputFilename);
 	}
 
-	//add the handle to our multi
-	CURLMcode merr = curl_multi_add_handle(s_multi_handle, mHandle);
-	if(merr != CURLM_OK)
-	{
-		closeStream();
-
-		mStatus = REQ_IO_ERROR;
-		onError(curl_multi_strerror(merr));
-		return;
-	}
-
-	s_requests[mHandle] = this;
+	// The network thread adds the handle to its multi & starts the transfer
+	mQueued = true;
+	HttpReqReactor::getInstance().add(this);
 }
 
 void HttpReq::closeStream()
@@ -308,126 +529,80 @@ void HttpReq::closeStream()
 
 HttpReq::~HttpReq()
 {
-	std::unique_lock<std::mutex> lock(mMutex);
+	if (mQueued)
+		HttpReqReactor::getInstance().remove(this);
 
 	closeStream();
 	
 	if (!mTempStreamPath.empty())
 		Utils::FileSystem::removeFile(mTempStreamPath);
 
-	if(mHandle)
-	{
-		s_requests.erase(mHandle);
-
-		CURLMcode merr = curl_multi_remove_handle(s_multi_handle, mHandle);
-
-		if(merr != CURLM_OK)
-			LOG(LogError) << "Error removing curl_easy handle from curl_multi: " << curl_multi_strerror(merr);
-
+	if (mHandle)
 		curl_easy_cleanup(mHandle);
-	}
 }
 
-HttpReq::Status HttpReq::status()
+void HttpReq::onTransferDone(CURLcode result)
 {
-	if (mStatus == REQ_IN_PROGRESS)
-	{
-		std::unique_lock<std::mutex> lock(mMutex);
+	closeStream();
 
-		int handle_count;
-		CURLMcode merr = curl_multi_perform(s_multi_handle, &handle_count);
-		if (merr != CURLM_OK && merr != CURLM_CALL_MULTI_PERFORM)
-		{
-			closeStream();
+	if (mStreamError)
+	{
+		std::string err = "File stream error (disk full ?)";
+		onError(REQ_FILESTREAM_ERROR, err.c_str());
+	}
+	else if (result == CURLE_OK)
+	{
+		long http_status_code = 0;
+		curl_easy_getinfo(mHandle, CURLINFO_RESPONSE_CODE, &http_status_code);
 
-			mStatus = REQ_IO_ERROR;
-			onError(curl_multi_strerror(merr));
-			return mStatus;
-		}
+		char *ct = NULL;
+		if (!curl_easy_getinfo(mHandle, CURLINFO_CONTENT_TYPE, &ct) && ct)
+			mResponseContentType = ct;
 
-		int msgs_left;
-		CURLMsg* msg;
-		while ((msg = curl_multi_info_read(s_multi_handle, &msgs_left)) != nullptr)
+		if (http_status_code == 304)
+			mStatus = REQ_304_NOTMODIFIED;
+		else if (http_status_code < 200 || http_status_code > 299)
 		{
-			if (msg->msg == CURLMSG_DONE)
+			std::string err;
+			Status status = REQ_IO_ERROR;
+
+			if (http_status_code >= 400 && http_status_code <= 500)
 			{
-				HttpReq* req = s_requests[msg->easy_handle];
-				if (req == NULL)
-				{
-					LOG(LogError) << "Cannot find easy handle!";
-					continue;
-				}
+				if (mFilePath.empty())
+					err = getContent();
 
-				req->closeStream();
+				status = (Status)http_status_code;
+			}
+
+			if (err.empty())
+				err = "HTTP status " + std::to_string(http_status_code);
 
-				if (req->mStatus == REQ_FILESTREAM_ERROR)
+			onError(status, err.c_str());
+		}
+		else
+		{
+			if (!mFilePath.empty())
+			{
+				bool renamed = Utils::FileSystem::renameFile(mTempStreamPath.c_str(), mFilePath.c_str());
+				if (!renamed)
 				{
-					std::string err = "File stream error (disk full ?)";
-					req->onError(err.c_str());
+					// Strange behaviour on Windows : sometimes std::rename fails if it's done too early after closing stream
+					// Copy file instead & try to delete it
+					if (Utils::FileSystem::copyFile(mTempStreamPath, mFilePath))
+						renamed = true;
 				}
-				else if (msg->data.result == CURLE_OK)
-				{
-					int http_status_code;
-					curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &http_status_code);
-
-					char *ct = NULL;
-					if (!curl_easy_getinfo(msg->easy_handle, CURLINFO_CONTENT_TYPE, &ct) && ct)
-						req->mResponseContentType = ct;
-
-					if (http_status_code < 200 || http_status_code > 299)
-					{
-						std::string err;
 
-						if (http_status_code >= 400 && http_status_code <= 500)
-						{
-							if (req->mFilePath.empty())
-								err = req->getContent();
-
-							req->mStatus = (Status)http_status_code;
-						}
-						else
-							req->mStatus = REQ_IO_ERROR;
-
-						if (err.empty())
-							err = "HTTP status " + std::to_string(http_status_code);
-
-						req->onError(err.c_str());
-					}
-					else
-					{
-						if (!req->mFilePath.empty())
-						{
-							bool renamed = Utils::FileSystem::renameFile(req->mTempStreamPath.c_str(), req->mFilePath.c_str());
-							if (!renamed)
-							{
-								// Strange behaviour on Windows : sometimes std::rename fails if it's done too early after closing stream
-								// Copy file instead & try to delete it
-								if (Utils::FileSystem::copyFile(req->mTempStreamPath, req->mFilePath))
-									renamed = true;
-							}
-
-							if (renamed)
-								req->mStatus = REQ_SUCCESS;
-							else
-							{
-								req->mStatus = REQ_IO_ERROR;
-								req->onError("file rename failed");
-							}
-						}
-						else
-							req->mStatus = REQ_SUCCESS;
-					}
-				}
+				if (renamed)
+					mStatus = REQ_SUCCESS;
 				else
-				{
-					req->mStatus = REQ_IO_ERROR;
-					req->onError(curl_easy_strerror(msg->data.result));
-				}
+					onError(REQ_IO_ERROR, "file rename failed");
 			}
+			else
+				mStatus = REQ_SUCCESS;
 		}
 	}
-
-	return mStatus;
+	else
+		onError(REQ_IO_ERROR, curl_easy_strerror(result));
 }
 
 std::string HttpReq::getContent() 
@@ -460,10 +635,12 @@ std::string HttpReq::getContent()
 	return "";
 }
 
-void HttpReq::onError(const char* msg)
+// The status is stored last : status() is read without lock, the message must be complete once it's visible
+void HttpReq::onError(Status status, const char* msg)
 {
 	mErrorMsg = msg;
-	LOG(LogError) << "HttpReq::onError (" + std::to_string(mStatus) << ") : " + mErrorMsg;
+	LOG(LogError) << "HttpReq::onError (" + std::to_string(status) << ") : " + mErrorMsg;
+	mStatus = status;
 }
 
 std::string HttpReq::getErrorMsg()
@@ -493,8 +670,7 @@ size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* req_p
 	if (ferror(file))
 	{
 		request->closeStream();			
-		request->mStatus = REQ_FILESTREAM_ERROR;
-		request->mErrorMsg = "IO ERROR (DISK FULL?)";		
+		request->mStreamError = true;
 
 		return 0;
 	}
@@ -502,7 +678,7 @@ size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* req_p
 	double cl;
 	if (!curl_easy_getinfo(request->mHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &cl))
 	{		
-		request->mPosition += rs;
+		request->mPosition = request->mPosition + rs;
 
 		if (cl <= 0)
 			request->mPercent = -1;
@@ -513,10 +689,46 @@ size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* req_p
 	return nmemb;
 }
 
+//used as a curl callback, once per header line of each response
+size_t HttpReq::write_header(char* buff, size_t size, size_t nmemb, void* req_ptr)
+{
+	HttpReq* request = ((HttpReq*)req_ptr);
+
+	size_t len = size * nmemb;
+	std::string line(buff, len);
+
+	// Status line : a new response starts (redirect or 100-continue)
+	if (Utils::String::startsWith(line, "HTTP/"))
+	{
+		request->mResponseHeaders.clear();
+		return len;
+	}
+
+	auto separator = line.find(':');
+	if (separator != std::string::npos)
+		request->mResponseHeaders[Utils::String::toLower(Utils::String::trim(line.substr(0, separator)))] = Utils::String::trim(line.substr(separator + 1));
+
+	return len;
+}
+
+std::string HttpReq::getResponseHeader(const std::string& name)
+{
+	auto it = mResponseHeaders.find(name);
+	if (it != mResponseHeaders.cend())
+		return it->second;
+
+	return "";
+}
+
 bool HttpReq::wait()
 {
-	while (status() == HttpReq::REQ_IN_PROGRESS)
-		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	if (mStatus == REQ_IN_PROGRESS)
+		HttpReqReactor::getInstance().waitForRequest(this);
 
-	return status() == HttpReq::REQ_SUCCESS;
+	return mStatus == REQ_SUCCESS;
+}
+
+void HttpReq::waitForAnyCompletion(int timeoutMs)
+{
+	HttpReqReactor::getInstance().waitForAnyCompletion(timeoutMs);
 }
@@ -3,6 +3,7 @@
 #define ES_CORE_HTTP_REQ_H
 
 #include <curl/curl.h>
+#include <atomic>
 #include <map>
 #include <sstream>
 #include <fstream>
@@ -12,8 +13,10 @@
 
 /* Usage:
  * HttpReq myRequest("www.google.com", "/index.html");
- * //for blocking behavior: while(myRequest.status() == HttpReq::REQ_IN_PROGRESS);
+ * //for blocking behavior: myRequest.wait();
  * //for non-blocking behavior: check if(myRequest.status() != HttpReq::REQ_IN_PROGRESS) in some sort of update method
+ *
+ * //transfers are driven by a network thread : status() is only a read
  * 
  * //once one of those completes, the request is ready
  * if(myRequest.status() != REQ_SUCCESS)
@@ -27,6 +30,8 @@
  * //process contents...
 */
 
+class HttpReq;
+
 class HttpReqOptions
 {
 public:
@@ -56,6 +61,7 @@ public:
 		REQ_FILESTREAM_ERROR = 4,		
 
 		REQ_SUCCESS = 200,
+		REQ_304_NOTMODIFIED = 304,		// only when the request has If-None-Match / If-Modified-Since headers
 		REQ_400_BADREQUEST = 400,
 		REQ_401_FORBIDDEN = 401,
 		REQ_403_BADLOGIN = 403,
@@ -70,7 +76,7 @@ public:
 		REQ_500_INTERNALSERVERERROR = 500
 	};
 
-	Status status(); //process any received data and return the status afterwards
+	Status status() { return mStatus; }
 
 	std::string getErrorMsg();
 
@@ -88,26 +94,33 @@ public:
 	std::string getFilePath() { return mFilePath; }
 	std::string getResponseContentType() { return mResponseContentType; }
 
+	// Header of the final response (after redirects), name in lower case
+	std::string getResponseHeader(const std::string& name);
+
+	// Blocks until the request is finished. Returns true on success
 	bool wait();
 
+	// Blocks until any request finishes, or the timeout expires. Lets pollers sleep instead of spinning
+	static void waitForAnyCompletion(int timeoutMs);
+
 private:
+	friend class HttpReqReactor;
+
 	void performRequest(const std::string& url, HttpReqOptions* options);
 	void closeStream();
+	void onTransferDone(CURLcode result); // network thread
 
 	static size_t write_content(void* buff, size_t size, size_t nmemb, void* req_ptr);
+	static size_t write_header(char* buff, size_t size, size_t nmemb, void* req_ptr);
 	//static int update_progress(void* req_ptr, double dlTotal, double dlNow, double ulTotal, double ulNow);
 
-	//god dammit libcurl why can't you have some way to check the status of an individual handle
-	//why do I have to handle ALL messages at once
-	static std::map<CURL*, HttpReq*> s_requests;
-
-	static CURLM* s_multi_handle;
-
-	void onError(const char* msg);
+	void onError(Status status, const char* msg);
 
 	CURL* mHandle;
+	bool  mQueued; // handed to the network thread
 
-	Status mStatus;
+	std::atomic<Status> mStatus;
+	bool mStreamError;
 
 	// string steam mode
 	std::stringstream mContent;
@@ -118,12 +131,13 @@ private:
 	FILE*		  mFile;
 
 	std::string   mResponseContentType;
+	std::map<std::string, std::string> mResponseHeaders;
 
 	std::string mErrorMsg;
 	std::string mUrl;
 
-	int mPercent;
-	double mPosition;
+	std::atomic<int> mPercent;
+	std::atomic<double> mPosition;
 };
 
 #endif // ES_CORE_HTTP_REQ_H
@@ -8,6 +8,8 @@
 #include <fstream>
 #include <map>
 #include <mutex>
+#include <unordered_map>
+#include <algorithm>
 #include "renderers/Renderer.h"
 #include "Paths.h"
 
@@ -135,37 +137,30 @@ unsigned char* ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const s
 		if (baseSize != nullptr)
 			*baseSize = Vector2i(width, height);
 
-		if (maxSize != nullptr && maxSize->x() > 0 && maxSize->y() > 0 && (width > maxSize->x() || height > maxSize->y()))
+		Vector2i sz = getScaledSize(Vector2i(width, height), maxSize);
+		if (sz.x() != width || sz.y() != height)
 		{
-			Vector2i sz = adjustPictureSize(Vector2i(width, height), Vector2i(maxSize->x(), maxSize->y()), maxSize->externalZoom());
+			LOG(LogError) << "ImageIO : rescaling image from " << std::string(std::to_string(width) + "x" + std::to_string(height)).c_str() << " to " << std::string(std::to_string(sz.x()) + "x" + std::to_string(sz.y())).c_str();
 
-			if (sz.x() > Renderer::getScreenWidth() || sz.y() > Renderer::getScreenHeight())
-				sz = adjustPictureSize(sz, Vector2i(Renderer::getScreenWidth(), Renderer::getScreenHeight()), false);
-			
-			if (sz.x() != width || sz.y() != height)
+			// Rescale through stb_image_resize (FreeImage was using FILTER_BOX)
+			unsigned char* stbiResizedBitmap = static_cast<unsigned char*>(aligned_alloc(32, sz.x() * sz.y() * 4));
+
+			if (ARGBScale(stbiBitmap, width*4, width, height, stbiResizedBitmap, sz.x() * 4, sz.x(), sz.y(), libyuv::FilterMode::kFilterBilinear))
 			{
-				LOG(LogError) << "ImageIO : rescaling image from " << std::string(std::to_string(width) + "x" + std::to_string(height)).c_str() << " to " << std::string(std::to_string(sz.x()) + "x" + std::to_string(sz.y())).c_str();
-
-				// Rescale through stb_image_resize (FreeImage was using FILTER_BOX)
-                unsigned char* stbiResizedBitmap = static_cast<unsigned char*>(aligned_alloc(32, sz.x() * sz.y() * 4));
-
-                if (ARGBScale(stbiBitmap, width*4, width, height, stbiResizedBitmap, sz.x() * 4, sz.x(), sz.y(), libyuv::FilterMode::kFilterBilinear))
-				{
-					LOG(LogError) << "Error - Failed to resize image from memory!";
-					delete[] stbiResizedBitmap;
-                    stbi_image_free(stbiBitmap);
-					return nullptr;
-				}
+				LOG(LogError) << "Error - Failed to resize image from memory!";
+				delete[] stbiResizedBitmap;
 				stbi_image_free(stbiBitmap);
-
-				width = sz.x();
-				height = sz.y();
-				
-				if (packedSize != nullptr)
-					*packedSize = Vector2i(width, height);
-				
-				stbiBitmap = stbiResizedBitmap;
+				return nullptr;
 			}
+			stbi_image_free(stbiBitmap);
+
+			width = sz.x();
+			height = sz.y();
+			
+			if (packedSize != nullptr)
+				*packedSize = Vector2i(width, height);
+			
+			stbiBitmap = stbiResizedBitmap;
 		}
 
 		LOG(LogDebug) << "ImageIO : returning decoded image ";
@@ -213,47 +208,40 @@ unsigned char* ImageIO::loadFromMemoryRGB24(const unsigned char * data, const si
         if (baseSize != nullptr)
             *baseSize = Vector2i(width, height);
 
-        if (maxSize != nullptr && maxSize->x() > 0 && maxSize->y() > 0 && (width > maxSize->x() || height > maxSize->y()))
+        Vector2i sz = getScaledSize(Vector2i(width, height), maxSize);
+        if (sz.x() != width || sz.y() != height)
         {
-            Vector2i sz = adjustPictureSize(Vector2i(width, height), Vector2i(maxSize->x(), maxSize->y()), maxSize->externalZoom());
+            LOG(LogError) << "ImageIO : rescaling image from " << std::string(std::to_string(width) + "x" + std::to_string(height)).c_str() << " to " << std::string(std::to_string(sz.x()) + "x" + std::to_string(sz.y())).c_str();
 
-            if (sz.x() > Renderer::getScreenWidth() || sz.y() > Renderer::getScreenHeight())
-                sz = adjustPictureSize(sz, Vector2i(Renderer::getScreenWidth(), Renderer::getScreenHeight()), false);
+            // Rescale through stb_image_resize (FreeImage was using FILTER_BOX)
+            unsigned char* stbiResizedBitmap = static_cast<unsigned char*>(aligned_alloc(32, sz.x() * sz.y() * 4));
 
-            if (sz.x() != width || sz.y() != height)
+            if (ARGBScale(stbiBitmap, width*4, width, height, stbiResizedBitmap, sz.x() * 4, sz.x(), sz.y(), libyuv::FilterMode::kFilterBilinear))
             {
-                LOG(LogError) << "ImageIO : rescaling image from " << std::string(std::to_string(width) + "x" + std::to_string(height)).c_str() << " to " << std::string(std::to_string(sz.x()) + "x" + std::to_string(sz.y())).c_str();
-
-                // Rescale through stb_image_resize (FreeImage was using FILTER_BOX)
-                unsigned char* stbiResizedBitmap = static_cast<unsigned char*>(aligned_alloc(32, sz.x() * sz.y() * 4));
-
-                if (ARGBScale(stbiBitmap, width*4, width, height, stbiResizedBitmap, sz.x() * 4, sz.x(), sz.y(), libyuv::FilterMode::kFilterBilinear))
-                {
-                    LOG(LogError) << "Error - Failed to resize image from memory!";
-                    free(stbiResizedBitmap);
-                    stbi_image_free(stbiBitmap);
-                    return nullptr;
-                }
-
+                LOG(LogError) << "Error - Failed to resize image from memory!";
+                free(stbiResizedBitmap);
                 stbi_image_free(stbiBitmap);
-                unsigned char* stbiResizedBitmap24 = static_cast<unsigned char*>(aligned_alloc(32, sz.x() * sz.y() * 3));
-                if (libyuv::ARGBToRGB24(stbiResizedBitmap, sz.x() * 4, stbiResizedBitmap24, sz.x() * 3, sz.x(), sz.y()))
-                {
-                    LOG(LogError) << "Error - Failed to resample image from RGBA32 to RGB24!";
-                    free(stbiResizedBitmap);
-                    free(stbiResizedBitmap24);
-                    return nullptr;
-                }
+                return nullptr;
+            }
 
+            stbi_image_free(stbiBitmap);
+            unsigned char* stbiResizedBitmap24 = static_cast<unsigned char*>(aligned_alloc(32, sz.x() * sz.y() * 3));
+            if (libyuv::ARGBToRGB24(stbiResizedBitmap, sz.x() * 4, stbiResizedBitmap24, sz.x() * 3, sz.x(), sz.y()))
+            {
+                LOG(LogError) << "Error - Failed to resample image from RGBA32 to RGB24!";
                 free(stbiResizedBitmap);
-                width = sz.x();
-                height = sz.y();
+                free(stbiResizedBitmap24);
+                return nullptr;
+            }
 
-                if (packedSize != nullptr)
-                    *packedSize = Vector2i(width, height);
+            free(stbiResizedBitmap);
+            width = sz.x();
+            height = sz.y();
 
-                stbiBitmap = stbiResizedBitmap24;
-            }
+            if (packedSize != nullptr)
+                *packedSize = Vector2i(width, height);
+
+            stbiBitmap = stbiResizedBitmap24;
         }
         else
         {
@@ -283,6 +271,19 @@ unsigned char* ImageIO::loadFromMemoryRGB24(const unsigned char * data, const si
     return nullptr;
 }
 
+Vector2i ImageIO::getScaledSize(Vector2i imageSize, MaxSizeInfo* maxSize)
+{
+	if (maxSize == nullptr || maxSize->x() <= 0 || maxSize->y() <= 0 || (imageSize.x() <= maxSize->x() && imageSize.y() <= maxSize->y()))
+		return imageSize;
+
+	Vector2i sz = adjustPictureSize(imageSize, Vector2i(maxSize->x(), maxSize->y()), maxSize->externalZoom());
+
+	if (sz.x() > Renderer::getScreenWidth() || sz.y() > Renderer::getScreenHeight())
+		sz = adjustPictureSize(sz, Vector2i(Renderer::getScreenWidth(), Renderer::getScreenHeight()), false);
+
+	return sz;
+}
+
 Vector2i ImageIO::adjustPictureSize(Vector2i imageSize, Vector2i maxSize, bool externSize)
 {
 	if (externSize)
@@ -345,192 +346,333 @@ Vector2f ImageIO::getPictureMinSize(Vector2f imageSize, Vector2f maxSize)
 	return Vector2f(cxDIB, cyDIB);
 }
 
-struct CachedFileInfo
+// imagecache.bin : header, then records sorted by path hash (binary searched in place), then records appended by the next sessions.
+// The appended records override the sorted ones & the file is compacted when they grow too many.
+
+#define IMAGECACHE_MAGIC	0x43495345 // "ESIC"
+#define IMAGECACHE_VERSION	1
+
+#define IMAGECACHE_REMOVED	1	// tombstone, persisted so it overrides the sorted record
+#define IMAGECACHE_INVALID	2	// image that can't be read, kept for the session only
+#define IMAGECACHE_VOLATILE	4	// not cachable path, kept for the session only
+
+#pragma pack(push, 1)
+struct ImageCacheHeader
 {
-	CachedFileInfo(int sz, int sx, int sy)
-	{
-		size = sz;
-		x = sx;
-		y = sy;		
-	};
+	unsigned int magic;
+	unsigned int version;
+	unsigned int sortedCount;
+	unsigned int reserved;
+};
 
-	CachedFileInfo()
-	{
-		size = 0;
-		x = 0;
-		y = 0;		
-	};
-
-	int size;
-	int x;
-	int y;	
+struct ImageCacheRecord
+{
+	unsigned long long pathHash;
+	long long modificationTime;
+	unsigned long long fileSize;
+	unsigned int width;
+	unsigned int height;
+	unsigned char channels;
+	unsigned char flags;
+	unsigned short reserved;
 };
+#pragma pack(pop)
+
+static std::vector<ImageCacheRecord> sizeCacheSorted;
+static std::unordered_map<unsigned long long, ImageCacheRecord> sizeCacheChanges;
+static std::vector<unsigned long long> sizeCachePendingWrites;
+static unsigned int sizeCacheAppendedCount = 0;
+static std::mutex sizeCacheLock;
+
+static std::string getImageCacheFilename()
+{
+	return Paths::getUserEmulationStationPath() + "/imagecache.bin";
+}
+
+// FNV-1a
+static unsigned long long getImageCacheHash(const std::string& path)
+{
+	unsigned long long hash = 14695981039346656037ULL;
 
-static std::map<std::string, CachedFileInfo> sizeCache;
-static bool sizeCacheDirty = false;
+	for (auto c : path)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+static bool _isCachablePath(const std::string& path)
+{
+	return 
+		path.find("/themes/") == std::string::npos && 
+		path.find("/tmp/") == std::string::npos &&
+		path.find("/emulationstation.tmp/") == std::string::npos &&
+		path.find("/pdftmp/") == std::string::npos && 
+		path.find("/saves/") == std::string::npos;
+}
 
-std::string getImageCacheFilename()
+// sizeCacheLock must be held
+static const ImageCacheRecord* findImageCacheRecord(unsigned long long hash)
 {
-	return Paths::getUserEmulationStationPath() + "/imagecache.db";
+	auto it = sizeCacheChanges.find(hash);
+	if (it != sizeCacheChanges.cend())
+		return (it->second.flags & IMAGECACHE_REMOVED) ? nullptr : &it->second;
+
+	auto sorted = std::lower_bound(sizeCacheSorted.cbegin(), sizeCacheSorted.cend(), hash, [](const ImageCacheRecord& rec, unsigned long long value) { return rec.pathHash < value; });
+	if (sorted != sizeCacheSorted.cend() && sorted->pathHash == hash)
+		return &(*sorted);
+
+	return nullptr;
 }
 
 void ImageIO::clearImageCache()
 {
+	std::unique_lock<std::mutex> lock(sizeCacheLock);
+
 	std::string fname = getImageCacheFilename();
 	Utils::FileSystem::removeFile(fname);
-	sizeCache.clear();
+
+	sizeCacheSorted.clear();
+	sizeCacheChanges.clear();
+	sizeCachePendingWrites.clear();
+	sizeCacheAppendedCount = 0;
 }
 
 void ImageIO::loadImageCache()
 {
+	std::unique_lock<std::mutex> lock(sizeCacheLock);
+
+	sizeCacheSorted.clear();
+	sizeCacheChanges.clear();
+	sizeCachePendingWrites.clear();
+	sizeCacheAppendedCount = 0;
+
+	// Obsolete text format
+	std::string oldName = Paths::getUserEmulationStationPath() + "/imagecache.db";
+	if (Utils::FileSystem::exists(oldName))
+		Utils::FileSystem::removeFile(oldName);
+
 	std::string fname = getImageCacheFilename();
 
-	std::ifstream f(fname.c_str());
+	std::ifstream f(WINSTRINGW(fname), std::ios::binary | std::ios::ate);
 	if (f.fail())
 		return;
 
-	sizeCache.clear();
+	size_t fileSize = (size_t)f.tellg();
+	f.seekg(0, std::ios::beg);
 
-	std::string relativeTo = Paths::getRootPath();
+	ImageCacheHeader header;
+	if (fileSize < sizeof(header) || !f.read((char*)&header, sizeof(header)) || header.magic != IMAGECACHE_MAGIC || header.version != IMAGECACHE_VERSION)
+	{
+		LOG(LogWarning) << "ImageIO::loadImageCache : invalid cache file, ignored";
+		return;
+	}
 
-	std::vector<std::string> splits;
+	size_t recordCount = (fileSize - sizeof(header)) / sizeof(ImageCacheRecord);
+	if (header.sortedCount > recordCount)
+	{
+		LOG(LogWarning) << "ImageIO::loadImageCache : truncated cache file, ignored";
+		return;
+	}
 
-	std::string line;
-	while (std::getline(f, line))
+	sizeCacheSorted.resize(header.sortedCount);
+	if (header.sortedCount > 0 && !f.read((char*)sizeCacheSorted.data(), header.sortedCount * sizeof(ImageCacheRecord)))
 	{
-		splits.clear();
+		sizeCacheSorted.clear();
+		return;
+	}
 
-		const char* src = line.c_str();
+	// Records appended after the sorted block, in write order : the last one wins
+	ImageCacheRecord rec;
+	for (size_t i = header.sortedCount; i < recordCount && f.read((char*)&rec, sizeof(rec)); i++)
+	{
+		sizeCacheChanges[rec.pathHash] = rec;
+		sizeCacheAppendedCount++;
+	}
+}
 
-		while (true)
-		{
-			const char* d = strchr(src, '|');
-			size_t len = (d) ? d - src : strlen(src);
+void ImageIO::saveImageCache()
+{
+	std::unique_lock<std::mutex> lock(sizeCacheLock);
 
-			if (len)
-				splits.push_back(std::string(src, len)); // capture token
+	if (sizeCachePendingWrites.size() == 0)
+		return;
 
-			if (d) src += len + 1; else break;
-		}
+	std::string fname = getImageCacheFilename();
 
-		if (splits.size() == 4)
+	// Append only the new records, unless there are too many appended records to keep the lookups fast
+	if (Utils::FileSystem::exists(fname) && sizeCacheAppendedCount + sizeCachePendingWrites.size() < 256 + sizeCacheSorted.size() / 4)
+	{
+		std::ofstream f(WINSTRINGW(fname), std::ios::binary | std::ios::app);
+		if (!f.fail())
 		{
-			std::string file = Utils::FileSystem::resolveRelativePath(splits[0], relativeTo, true);
+			for (auto hash : sizeCachePendingWrites)
+			{
+				auto it = sizeCacheChanges.find(hash);
+				if (it != sizeCacheChanges.cend())
+					f.write((const char*)&it->second, sizeof(ImageCacheRecord));
+			}
 
-			CachedFileInfo fi;
-			fi.size = Utils::String::toInteger(splits[1]);
-			fi.x = Utils::String::toInteger(splits[2]);
-			fi.y = Utils::String::toInteger(splits[3]);
+			f.close();
 
-			sizeCache[file] = fi;
+			sizeCacheAppendedCount += sizeCachePendingWrites.size();
+			sizeCachePendingWrites.clear();
+			return;
 		}
 	}
 
-	f.close();
-}
+	// Compaction : merge the changes into the sorted records & rewrite the file
+	std::vector<ImageCacheRecord> records;
+	records.reserve(sizeCacheSorted.size() + sizeCacheChanges.size());
 
-static bool _isCachablePath(const std::string& path)
-{
-	return 
-		path.find("/themes/") == std::string::npos && 
-		path.find("/tmp/") != std::string::npos &&
-		path.find("/emulationstation.tmp/") != std::string::npos &&
-		path.find("/pdftmp/") == std::string::npos && 
-		path.find("/saves/") != std::string::npos;
-}
+	for (auto& rec : sizeCacheSorted)
+		if (sizeCacheChanges.find(rec.pathHash) == sizeCacheChanges.cend())
+			records.push_back(rec);
 
-void ImageIO::saveImageCache()
-{
-	if (!sizeCacheDirty)
-		return;
+	for (auto& change : sizeCacheChanges)
+		if ((change.second.flags & (IMAGECACHE_REMOVED | IMAGECACHE_INVALID | IMAGECACHE_VOLATILE)) == 0)
+			records.push_back(change.second);
 
-	std::string fname = getImageCacheFilename();
-	std::ofstream f(fname.c_str(), std::ios::binary);
+	std::sort(records.begin(), records.end(), [](const ImageCacheRecord& a, const ImageCacheRecord& b) { return a.pathHash < b.pathHash; });
+
+	ImageCacheHeader header;
+	header.magic = IMAGECACHE_MAGIC;
+	header.version = IMAGECACHE_VERSION;
+	header.sortedCount = (unsigned int)records.size();
+	header.reserved = 0;
+
+	std::string tmpName = fname + ".tmp";
+
+	std::ofstream f(WINSTRINGW(tmpName), std::ios::binary | std::ios::trunc);
 	if (f.fail())
 		return;
 
-	std::string relativeTo = Paths::getRootPath();
+	f.write((const char*)&header, sizeof(header));
+	if (records.size() > 0)
+		f.write((const char*)records.data(), records.size() * sizeof(ImageCacheRecord));
+	f.close();
 
-	for (auto it : sizeCache)
+	if (f.fail())
 	{
-		if (it.second.size < 0)
-			continue;
-
-		if (!_isCachablePath(it.first))
-			continue;
-
-		std::string path = Utils::FileSystem::createRelativePath(it.first, relativeTo, true); 
-
-		f << path;
-		f << "|";
-		f << std::to_string(it.second.size);
-		f << "|";
-		f << std::to_string(it.second.x);
-		f << "|";
-		f << std::to_string(it.second.y);
-		f << "\n";
+		Utils::FileSystem::removeFile(tmpName);
+		return;
 	}
 
-	f.close();
-}
+	Utils::FileSystem::removeFile(fname);
+	Utils::FileSystem::renameFile(tmpName, fname);
 
-static std::mutex sizeCacheLock;
+	sizeCacheSorted = records;
+	sizeCachePendingWrites.clear();
+	sizeCacheAppendedCount = 0;
+
+	for (auto it = sizeCacheChanges.begin(); it != sizeCacheChanges.end(); )
+	{
+		if ((it->second.flags & (IMAGECACHE_INVALID | IMAGECACHE_VOLATILE)) == 0)
+			it = sizeCacheChanges.erase(it);
+		else
+			it++;
+	}
+}
 
 void ImageIO::removeImageCache(const std::string fn)
 {
 	std::unique_lock<std::mutex> lock(sizeCacheLock);
 
-	auto it = sizeCache.find(fn);
-	if (it != sizeCache.cend())
-		sizeCache.erase(fn);
+	unsigned long long hash = getImageCacheHash(fn);
+	if (findImageCacheRecord(hash) == nullptr)
+		return;
+
+	ImageCacheRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.pathHash = hash;
+	rec.flags = IMAGECACHE_REMOVED;
+
+	sizeCacheChanges[hash] = rec;
+
+	if (_isCachablePath(fn))
+		sizeCachePendingWrites.push_back(hash);
 }
 
-void ImageIO::updateImageCache(const std::string fn, int sz, int x, int y)
+void ImageIO::updateImageCache(const std::string fn, int sz, int x, int y, int channels)
 {
-	std::unique_lock<std::mutex> lock(sizeCacheLock);
+	unsigned long long hash = getImageCacheHash(fn);
 
-	auto it = sizeCache.find(fn);
-	if (it != sizeCache.cend())
-	{
-		if (x != it->second.x || y != it->second.y || sz != it->second.size)
-		{
-			auto& item = it->second;
+	ImageCacheRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.pathHash = hash;
 
-			item.x = x;
-			item.y = y;
-			item.size = sz;
-
-			if (sz > 0 && x > 0 && _isCachablePath(fn))
-				sizeCacheDirty = true;
-		}
-	}
+	if (sz < 0 || x <= 0 || y <= 0)
+		rec.flags = IMAGECACHE_INVALID;
 	else
 	{
-		sizeCache[fn] = CachedFileInfo(sz, x, y);
-
-		if (sz > 0 && x > 0 && _isCachablePath(fn))
-			sizeCacheDirty = true;
+		unsigned long long fileSize;
+		time_t modificationTime;
+		if (!Utils::FileSystem::getFileSizeAndModificationTime(fn, &fileSize, &modificationTime))
+			return;
+
+		rec.fileSize = fileSize;
+		rec.modificationTime = modificationTime;
+		rec.width = x;
+		rec.height = y;
+		rec.channels = channels;
+
+		if (!_isCachablePath(fn))
+			rec.flags = IMAGECACHE_VOLATILE;
 	}
-}
 
+	std::unique_lock<std::mutex> lock(sizeCacheLock);
+
+	auto existing = findImageCacheRecord(hash);
+	if (existing != nullptr && existing->flags == rec.flags && existing->fileSize == rec.fileSize && existing->modificationTime == rec.modificationTime &&
+		existing->width == rec.width && existing->height == rec.height && (rec.channels == 0 || existing->channels == rec.channels))
+		return;
+
+	if (existing != nullptr && rec.channels == 0 && existing->fileSize == rec.fileSize && existing->modificationTime == rec.modificationTime)
+		rec.channels = existing->channels;
+
+	sizeCacheChanges[hash] = rec;
+
+	if (rec.flags == 0)
+		sizeCachePendingWrites.push_back(hash);
+}
 
-bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
+bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y, unsigned int *channels)
 {
+	ImageCacheRecord cached;
+	bool found = false;
+
 	{
 		std::unique_lock<std::mutex> lock(sizeCacheLock);
 
-		auto it = sizeCache.find(fn);
-		if (it != sizeCache.cend())
+		auto rec = findImageCacheRecord(getImageCacheHash(fn));
+		if (rec != nullptr)
 		{
-			if (it->second.size < 0)
+			if (rec->flags & IMAGECACHE_INVALID)
 				return false;
 
-			*x = it->second.x;
-			*y = it->second.y;
-			return true;
+			cached = *rec;
+			found = true;
 		}
 	}
 
+	unsigned long long size = 0;
+	time_t modificationTime = 0;
+	bool fileExists = Utils::FileSystem::getFileSizeAndModificationTime(fn, &size, &modificationTime);
+
+	// The cached size is valid as long as the file has not been replaced
+	if (found && fileExists && cached.fileSize == size && cached.modificationTime == (long long)modificationTime)
+	{
+		*x = cached.width;
+		*y = cached.height;
+
+		if (channels != nullptr)
+			*channels = cached.channels;
+
+		return true;
+	}
+
 	LOG(LogDebug) << "ImageIO::loadImageSize " << fn;
 
 	auto ext = Utils::String::toLower(Utils::FileSystem::getExtension(fn));
@@ -540,8 +682,6 @@ bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 		return false;
 	}
 
-	auto size = Utils::FileSystem::getFileSize(fn);
-
 #if WIN32
 	FILE *f = _fsopen(fn, "rb", _SH_DENYNO);
 #else
@@ -560,9 +700,12 @@ bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 	// reading PNG dimensions requires the first 24 bytes of the file
 	// reading JPEG dimensions requires scanning through jpeg chunks
 	// In all formats, the file is at least 24 bytes big, so we'll read that always
-	unsigned char buf[24]; 
-	if (fread(buf, 1, 24, f) != 24)
+	// PNG color type is the 26th byte, it gives the channel count
+	unsigned char buf[26]; 
+	memset(buf, 0, sizeof(buf));
+	if (fread(buf, 1, 26, f) < 24)
 	{
+		fclose(f);
 		updateImageCache(fn, -1, -1, -1);
 		return false;
 	}
@@ -608,7 +751,12 @@ bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 			return false;
 		}
 
-		updateImageCache(fn, size, *x, *y);
+		// Number of components of the SOF frame
+		int ch = buf[11];
+		if (channels != nullptr)
+			*channels = ch;
+
+		updateImageCache(fn, size, *x, *y, ch);
 		return true;
 	}
 
@@ -620,6 +768,9 @@ bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 
 		LOG(LogDebug) << "ImageIO::loadImageSize\tGIF size " << std::string(std::to_string(*x) + "x" + std::to_string(*y)).c_str();
 
+		if (channels != nullptr)
+			*channels = 0;
+
 		updateImageCache(fn, size, *x, *y);
 		return true;
 	}
@@ -632,7 +783,20 @@ bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 
 		LOG(LogDebug) << "ImageIO::loadImageSize\tPNG size " << std::string(std::to_string(*x) + "x" + std::to_string(*y)).c_str();
 
-		updateImageCache(fn, size, *x, *y);
+		// Color type : 0 gray, 2 RGB, 3 palette, 4 gray + alpha, 6 RGBA
+		int ch = 0;
+		switch (buf[25])
+		{
+		case 0: ch = 1; break;
+		case 2: case 3: ch = 3; break;
+		case 4: ch = 2; break;
+		case 6: ch = 4; break;
+		}
+
+		if (channels != nullptr)
+			*channels = ch;
+
+		updateImageCache(fn, size, *x, *y, ch);
 		return true;
 	}
 
@@ -4,6 +4,7 @@
 
 #include <stdlib.h>
 #include <vector>
+#include <string>
 #include "math/Vector2f.h"
 #include "math/Vector2i.h"
 
@@ -50,10 +51,11 @@ public:
 	// batocera
 	static Vector2f getPictureMinSize(Vector2f imageSize, Vector2f maxSize);
 	static Vector2i adjustPictureSize(Vector2i imageSize, Vector2i maxSize, bool externSize = false);
-	static bool		loadImageSize(const char *fn, unsigned int *x, unsigned int *y);
+	static Vector2i getScaledSize(Vector2i imageSize, MaxSizeInfo* maxSize); // size of the decoded bitmap for a source image size
+	static bool		loadImageSize(const char *fn, unsigned int *x, unsigned int *y, unsigned int *channels = nullptr);
 
 	static void		removeImageCache(const std::string fn);
-	static void		updateImageCache(const std::string fn, int sz, int x, int y);
+	static void		updateImageCache(const std::string fn, int sz, int x, int y, int channels = 0);
 	static void		loadImageCache();
 	static void		saveImageCache();
 	static void		clearImageCache();
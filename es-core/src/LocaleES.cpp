@@ -1,4 +1,7 @@
 #include "LocaleES.h"
+#include "utils/StringUtil.h"
+#include "SystemConf.h"
+#include <fstream>
 #include <iostream>
 
 #define PACKAGE_LANG "emulationstation2"
@@ -21,6 +24,7 @@ char* pgettext(char* context, char* msgid); {
 #endif
 
 std::string EsLocale::default_LANGUAGE = "";
+std::string EsLocale::mCatalogPath = "";
 
 std::string EsLocale::changeLocale(const std::string& locale) {
 	char *clocale = NULL;
@@ -55,6 +59,7 @@ std::string EsLocale::init(std::string locale, std::string path) {
 		default_LANGUAGE = envv;
 	}
 
+	mCatalogPath = path;
 	nlocale = changeLocale(locale);
 
 	if (nlocale == "") {
@@ -85,6 +90,59 @@ const bool EsLocale::isRTL()
 	return language.find("ar") == 0 || language.find("he") == 0;
 }
 
+static unsigned int readCatalogInt(const std::string& data, size_t offset, bool swap)
+{
+	const unsigned char* p = (const unsigned char*)data.data() + offset;
+	if (swap)
+		return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+// Translated strings of a gettext .mo catalog
+static std::string readCatalogStrings(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return "";
+
+	std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (data.size() < 28)
+		return "";
+
+	unsigned int magic = readCatalogInt(data, 0, false);
+	bool swap = (magic == 0xde120495);
+	if (!swap && magic != 0x950412de)
+		return "";
+
+	unsigned int count = readCatalogInt(data, 8, swap);
+	unsigned int table = readCatalogInt(data, 16, swap);
+
+	std::string ret;
+
+	for (unsigned int i = 0; i < count && table + i * 8 + 8 <= data.size(); i++)
+	{
+		unsigned int length = readCatalogInt(data, table + i * 8, swap);
+		unsigned int offset = readCatalogInt(data, table + i * 8 + 4, swap);
+
+		if ((size_t)offset + length <= data.size())
+			ret += data.substr(offset, length);
+	}
+
+	return ret;
+}
+
+static std::string getCatalogText(const std::string& catalogPath, const std::string& language)
+{
+	std::string text = readCatalogStrings(catalogPath + "/" + language + "/LC_MESSAGES/" PACKAGE_LANG ".mo");
+
+	auto shortNameDivider = language.find("_");
+	if (text.empty() && shortNameDivider != std::string::npos)
+		text = readCatalogStrings(catalogPath + "/" + language.substr(0, shortNameDivider) + "/LC_MESSAGES/" PACKAGE_LANG ".mo");
+
+	return text;
+}
+
 #else
 
 // For WIN32 avoid using boost or libintl 
@@ -379,3 +437,61 @@ void EsLocale::checkLocalisationLoaded()
 }
 
 #endif
+
+struct ScriptRange
+{
+	const char*		language; // empty for all languages
+	unsigned int	first;
+	unsigned int	last;
+};
+
+// Scripts a language is written with. Han ideographs & Hangul syllables are too many to be listed, the UI strings bring the common ones
+static const ScriptRange scriptRanges[] =
+{
+	{ "",   0x00A0, 0x017F }, // latin-1 supplement & latin extended-a
+	{ "el", 0x0370, 0x03FF }, // greek
+	{ "ru", 0x0400, 0x045F }, // cyrillic
+	{ "uk", 0x0400, 0x045F },
+	{ "bg", 0x0400, 0x045F },
+	{ "he", 0x05D0, 0x05EA }, // hebrew
+	{ "ar", 0x0600, 0x06FF }, // arabic
+	{ "fa", 0x0600, 0x06FF },
+	{ "ja", 0x3000, 0x303F }, // cjk punctuation
+	{ "ja", 0x3041, 0x3096 }, // hiragana
+	{ "ja", 0x30A0, 0x30FF }, // katakana
+	{ "ja", 0xFF01, 0xFF5E }, // fullwidth forms
+	{ "zh", 0x3000, 0x303F },
+	{ "zh", 0xFF01, 0xFF5E },
+	{ "ko", 0x3000, 0x303F },
+	{ "ko", 0x3131, 0x318E }, // hangul compatibility jamo
+	{ "ko", 0xFF01, 0xFF5E }
+};
+
+std::string EsLocale::getCommonCharacters()
+{
+	std::string language = SystemConf::getInstance()->get("system.language");
+	if (language.empty())
+		language = "en_US";
+
+	std::string ret;
+
+	for (auto range : scriptRanges)
+	{
+		if (range.language[0] != 0 && language.find(range.language) != 0)
+			continue;
+
+		for (unsigned int c = range.first; c <= range.last; c++)
+			ret += Utils::String::unicode2Chars(c);
+	}
+
+#if !defined(WIN32)
+	ret += getCatalogText(mCatalogPath, language);
+#else
+	checkLocalisationLoaded();
+
+	for (auto item : mItems)
+		ret += item.second;
+#endif
+
+	return ret;
+}
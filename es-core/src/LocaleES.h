@@ -29,8 +29,13 @@ public:
 	static std::string changeLocale(const std::string& locale);
 
 	static const bool isRTL();
+
+	// UTF-8 text holding the characters the current language commonly needs : its script & the translated UI strings
+	static std::string getCommonCharacters();
+
 private:
 	static std::string default_LANGUAGE;
+	static std::string mCatalogPath;
 };
 
 #else // WIN32
@@ -62,6 +67,9 @@ public:
 
 	static const void reset() { mCurrentLanguageLoaded = false; }
 
+	// UTF-8 text holding the characters the current language commonly needs : its script & the translated UI strings
+	static std::string getCommonCharacters();
+
 private:
 	static void checkLocalisationLoaded();
 	static std::map<std::string, std::string> mItems;
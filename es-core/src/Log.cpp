@@ -159,6 +159,13 @@ StopWatch::StopWatch(const std::string& elapsedMillisecondsMessage, LogLevel lev
 
 StopWatch::~StopWatch()
 {
-	int elapsed = SDL_GetTicks() - mStartTicks;
-	LOG(mLevel) << mMessage << " " << elapsed << "ms";
+	if (mDetails.empty())
+		LOG(mLevel) << mMessage << " " << getElapsedMilliseconds() << "ms";
+	else
+		LOG(mLevel) << mMessage << " " << getElapsedMilliseconds() << "ms (" << mDetails << ")";
+}
+
+int StopWatch::getElapsedMilliseconds() const
+{
+	return SDL_GetTicks() - mStartTicks;
 }
\ No newline at end of file
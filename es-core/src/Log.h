@@ -49,8 +49,14 @@ public:
 	StopWatch(const std::string& elapsedMillisecondsMessage, LogLevel level = LogDebug);
 	~StopWatch();
 
+	int getElapsedMilliseconds() const;
+
+	// Extra information appended to the message
+	void setDetails(const std::string& details) { mDetails = details; }
+
 private:
 	std::string mMessage;
+	std::string mDetails;
 	LogLevel mLevel;
 	int mStartTicks;
 };
@@ -46,6 +46,9 @@ public:
 			setState(true); 
 	}
 
+	// Something is animating between pause() and resume()
+	static bool isPaused() { return mPauseCounter > 0; }
+
 	static void lock(bool state)
 	{
 		if (state)
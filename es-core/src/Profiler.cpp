@@ -0,0 +1,288 @@
+#include "Profiler.h"
+
+#ifdef _ENABLE_PROFILER_
+
+#include "renderers/Renderer.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/TimeUtil.h"
+#include "GuiComponent.h"
+#include "Log.h"
+#include "Paths.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <typeinfo>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#include <stdlib.h>
+#endif
+
+#define PROFILER_HISTORY_SIZE	240
+#define PROFILER_GRAPH_MAX_MS	50.0f
+#define PROFILER_SUMMARY_LINES	6
+
+bool Profiler::mEnabled = false;
+std::thread::id Profiler::mMainThreadId;
+
+std::vector<Profiler::Frame> Profiler::mStack;
+std::map<Profiler::Key, Profiler::Entry> Profiler::mEntries;
+std::map<std::type_index, std::string> Profiler::mTypeNames;
+
+Profiler::Clock::time_point Profiler::mFrameStart;
+std::vector<float> Profiler::mFrameTimes;
+int Profiler::mFrameTimesPos = 0;
+long long Profiler::mFrameCount = 0;
+int Profiler::mWindowFrameCount = 0;
+
+static const char* FRAME_NAME = "Frame";
+
+Profiler::ScopedTimer::ScopedTimer(const char* name)
+{
+	// Textures can be loaded by other threads : only the main loop is measured
+	mActive = name != nullptr && mEnabled && std::this_thread::get_id() == mMainThreadId;
+	if (mActive)
+		push(name);
+}
+
+Profiler::ScopedTimer::~ScopedTimer()
+{
+	if (mActive)
+		pop();
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	if (mEnabled == enabled)
+		return;
+
+	mEnabled = enabled;
+	mMainThreadId = std::this_thread::get_id();
+
+	mStack.clear();
+	mEntries.clear();
+	mFrameTimes.clear();
+	mFrameTimesPos = 0;
+	mFrameCount = 0;
+	mWindowFrameCount = 0;
+
+	LOG(LogInfo) << "Profiler " << (enabled ? "enabled" : "disabled");
+}
+
+void Profiler::beginFrame()
+{
+	if (!mEnabled)
+		return;
+
+	// A frame skipped after its update is not ended : its timers are kept, its duration is not
+	mStack.clear();
+	mFrameStart = Clock::now();
+}
+
+void Profiler::endFrame()
+{
+	if (!mEnabled)
+		return;
+
+	float ms = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - mFrameStart).count() / 1000.0f;
+
+	if (mFrameTimes.size() < PROFILER_HISTORY_SIZE)
+		mFrameTimes.push_back(ms);
+	else
+		mFrameTimes[mFrameTimesPos] = ms;
+
+	mFrameTimesPos = (mFrameTimesPos + 1) % PROFILER_HISTORY_SIZE;
+	mFrameCount++;
+	mWindowFrameCount++;
+}
+
+void Profiler::push(const char* name)
+{
+	mStack.push_back(Frame(name));
+}
+
+void Profiler::pop()
+{
+	if (mStack.empty())
+		return;
+
+	Frame frame = mStack.back();
+	mStack.pop_back();
+
+	long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - frame.start).count();
+	long long self = elapsed - frame.childTime;
+
+	const char* caller = FRAME_NAME;
+	if (!mStack.empty())
+	{
+		mStack.back().childTime += elapsed;
+		caller = mStack.back().name;
+	}
+
+	Entry& entry = mEntries[Key(caller, frame.name)];
+	entry.calls++;
+	entry.totalTime += elapsed;
+	entry.selfTime += self;
+	entry.windowCalls++;
+	entry.windowSelfTime += self;
+
+	if (elapsed > entry.maxTime)
+		entry.maxTime = elapsed;
+}
+
+const char* Profiler::getTypeName(const GuiComponent* component)
+{
+	if (component == nullptr)
+		return nullptr;
+
+	std::type_index type(typeid(*component));
+
+	auto it = mTypeNames.find(type);
+	if (it != mTypeNames.cend())
+		return it->second.c_str();
+
+	std::string name = type.name();
+
+#ifdef __GNUC__
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+	if (demangled != nullptr)
+	{
+		if (status == 0)
+			name = demangled;
+
+		free(demangled);
+	}
+#else
+	if (name.find("class ") == 0)
+		name = name.substr(6);
+#endif
+
+	return mTypeNames.insert(std::make_pair(type, name)).first->second.c_str();
+}
+
+float Profiler::getPercentile(std::vector<float>& sorted, float percent)
+{
+	if (sorted.empty())
+		return 0;
+
+	int idx = (int)(percent * (sorted.size() - 1) / 100.0f + 0.5f);
+	return sorted[std::max(0, std::min(idx, (int)sorted.size() - 1))];
+}
+
+std::string Profiler::getSummary()
+{
+	if (!mEnabled)
+		return "";
+
+	std::vector<float> sorted = mFrameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2);
+	ss << "Frame p50: " << getPercentile(sorted, 50) << "ms p95: " << getPercentile(sorted, 95) <<
+		"ms p99: " << getPercentile(sorted, 99) << "ms max: " << (sorted.empty() ? 0.0f : sorted.back()) << "ms";
+
+	std::vector<std::pair<Key, Entry>> top;
+	for (auto& it : mEntries)
+		if (it.second.windowCalls > 0)
+			top.push_back(std::make_pair(it.first, it.second));
+
+	std::sort(top.begin(), top.end(), [](const std::pair<Key, Entry>& a, const std::pair<Key, Entry>& b) { return a.second.windowSelfTime > b.second.windowSelfTime; });
+
+	int frames = std::max(1, mWindowFrameCount);
+	for (int i = 0; i < (int)top.size() && i < PROFILER_SUMMARY_LINES; i++)
+	{
+		const Entry& entry = top[i].second;
+		ss << "\n" << top[i].first.second << " < " << top[i].first.first << ": " <<
+			(entry.windowSelfTime / 1000.0f / frames) << "ms x" << (entry.windowCalls / frames);
+	}
+
+	for (auto& it : mEntries)
+	{
+		it.second.windowCalls = 0;
+		it.second.windowSelfTime = 0;
+	}
+
+	mWindowFrameCount = 0;
+	return ss.str();
+}
+
+void Profiler::renderGraph()
+{
+	if (!mEnabled || mFrameTimes.empty())
+		return;
+
+	const float height = Renderer::getScreenHeight() * 0.12f;
+	const float barWidth = std::max(1.0f, Renderer::getScreenWidth() * 0.3f / PROFILER_HISTORY_SIZE);
+	const float x = 50.0f;
+	const float y = Renderer::getScreenHeight() - height - 50.0f;
+
+	Renderer::setMatrix(Transform4x4f::Identity());
+	Renderer::drawRect(x, y, barWidth * PROFILER_HISTORY_SIZE, height, 0x00000080);
+
+	// Oldest frame on the left
+	int count = (int)mFrameTimes.size();
+	int first = count < PROFILER_HISTORY_SIZE ? 0 : mFrameTimesPos;
+
+	for (int i = 0; i < count; i++)
+	{
+		float ms = mFrameTimes[(first + i) % count];
+		float h = std::min(ms / PROFILER_GRAPH_MAX_MS, 1.0f) * height;
+
+		unsigned int color = 0x00FF00C0;
+		if (ms > 33.4f)
+			color = 0xFF0000C0;
+		else if (ms > 16.7f)
+			color = 0xFFFF00C0;
+
+		Renderer::drawRect(x + i * barWidth, y + height - h, barWidth, h, color);
+	}
+
+	// 60 & 30 fps budgets
+	Renderer::drawRect(x, y + height - (16.7f / PROFILER_GRAPH_MAX_MS) * height, barWidth * PROFILER_HISTORY_SIZE, 1.0f, 0xFFFFFF80);
+	Renderer::drawRect(x, y + height - (33.4f / PROFILER_GRAPH_MAX_MS) * height, barWidth * PROFILER_HISTORY_SIZE, 1.0f, 0xFFFFFF80);
+}
+
+std::string Profiler::dump()
+{
+	if (!mEnabled)
+		return "";
+
+	std::vector<float> sorted = mFrameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(3);
+	ss << "Frames: " << mFrameCount << " (percentiles of the last " << sorted.size() << ")\n";
+	ss << "p50: " << getPercentile(sorted, 50) << "ms p90: " << getPercentile(sorted, 90) << "ms p95: " << getPercentile(sorted, 95) <<
+		"ms p99: " << getPercentile(sorted, 99) << "ms max: " << (sorted.empty() ? 0.0f : sorted.back()) << "ms\n\n";
+
+	std::vector<std::pair<Key, Entry>> entries(mEntries.cbegin(), mEntries.cend());
+	std::sort(entries.begin(), entries.end(), [](const std::pair<Key, Entry>& a, const std::pair<Key, Entry>& b) { return a.second.selfTime > b.second.selfTime; });
+
+	long long frames = std::max(1LL, mFrameCount);
+
+	ss << std::setw(12) << "self ms" << std::setw(12) << "total ms" << std::setw(14) << "self ms/frm" << std::setw(12) << "calls/frm" << std::setw(10) << "max ms" << "  name < caller\n";
+	for (auto& it : entries)
+	{
+		const Entry& entry = it.second;
+		ss << std::setw(12) << (entry.selfTime / 1000.0) << std::setw(12) << (entry.totalTime / 1000.0) <<
+			std::setw(14) << (entry.selfTime / 1000.0 / frames) << std::setw(12) << ((double)entry.calls / frames) <<
+			std::setw(10) << (entry.maxTime / 1000.0) << "  " << it.first.second << " < " << it.first.first << "\n";
+	}
+
+	std::string path = Utils::FileSystem::combine(Paths::getUserEmulationStationPath(), "profiler-" + Utils::Time::timeToString(time(NULL), "%Y%m%d-%H%M%S") + ".txt");
+	Utils::FileSystem::writeAllText(path, ss.str());
+
+	if (!Utils::FileSystem::exists(path))
+	{
+		LOG(LogError) << "Profiler::dump() failed to write " << path;
+		return "";
+	}
+
+	LOG(LogInfo) << "Profiler statistics written to " << path;
+	return path;
+}
+
+#endif // _ENABLE_PROFILER_
@@ -0,0 +1,115 @@
+#pragma once
+#ifndef ES_CORE_PROFILER_H
+#define ES_CORE_PROFILER_H
+
+// Frame-time profiler, built with -DENABLE_PROFILER=ON.
+// Scoped timers measure the CPU time spent in components, texture uploads & main loop stages. Samples are aggregated
+// by (caller, callee) so the same component type is summed wherever it appears, and the time of nested timers is
+// subtracted to get the self time. Ctrl-P toggles the profiler & its overlay, Ctrl-D dumps the statistics to a file.
+// Without the build option, the macros below expand to nothing.
+
+#ifdef _ENABLE_PROFILER_
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <vector>
+
+class GuiComponent;
+
+class Profiler
+{
+public:
+	class ScopedTimer
+	{
+	public:
+		ScopedTimer(const char* name);
+		~ScopedTimer();
+
+	private:
+		bool mActive;
+	};
+
+	static bool isEnabled() { return mEnabled; }
+	static void setEnabled(bool enabled);
+
+	static void beginFrame();
+	static void endFrame();
+
+	// Readable class name of a component, demangled once per type
+	static const char* getTypeName(const GuiComponent* component);
+
+	// Frame times percentiles & most expensive timers since the last call, for the framerate overlay
+	static std::string getSummary();
+
+	// Rolling graph of the last frame times
+	static void renderGraph();
+
+	// Writes the statistics collected since the profiler was enabled. Returns the file path, or an empty string on failure
+	static std::string dump();
+
+private:
+	typedef std::chrono::steady_clock Clock;
+	typedef std::pair<const char*, const char*> Key; // caller, callee
+
+	struct Entry
+	{
+		Entry() : calls(0), totalTime(0), selfTime(0), maxTime(0), windowCalls(0), windowSelfTime(0) { }
+
+		long long calls;
+		long long totalTime;	// microseconds, including nested timers
+		long long selfTime;		// microseconds, excluding nested timers
+		long long maxTime;		// longest single call
+
+		long long windowCalls;
+		long long windowSelfTime;
+	};
+
+	struct Frame
+	{
+		Frame(const char* _name) : name(_name), start(Clock::now()), childTime(0) { }
+
+		const char*			name;
+		Clock::time_point	start;
+		long long			childTime;
+	};
+
+	static void push(const char* name);
+	static void pop();
+
+	static float getPercentile(std::vector<float>& sorted, float percent);
+
+	static bool								mEnabled;
+	static std::thread::id					mMainThreadId;
+
+	static std::vector<Frame>				mStack;
+	static std::map<Key, Entry>				mEntries;
+	static std::map<std::type_index, std::string> mTypeNames;
+
+	static Clock::time_point				mFrameStart;
+	static std::vector<float>				mFrameTimes; // ms, ring buffer
+	static int								mFrameTimesPos;
+	static long long						mFrameCount;
+	static int								mWindowFrameCount;
+};
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+
+#define PROFILE_SCOPE(name) Profiler::ScopedTimer PROFILER_CONCAT(profilerTimer, __LINE__)(name)
+#define PROFILE_COMPONENT(component) Profiler::ScopedTimer PROFILER_CONCAT(profilerTimer, __LINE__)(Profiler::isEnabled() ? Profiler::getTypeName(component) : nullptr)
+#define PROFILE_FRAME_BEGIN() Profiler::beginFrame()
+#define PROFILE_FRAME_END() Profiler::endFrame()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_COMPONENT(component)
+#define PROFILE_FRAME_BEGIN()
+#define PROFILE_FRAME_END()
+
+#endif // _ENABLE_PROFILER_
+
+#endif // ES_CORE_PROFILER_H
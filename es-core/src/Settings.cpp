@@ -27,6 +27,7 @@ IMPLEMENT_STATIC_BOOL_SETTING(BackgroundMusic, true)
 IMPLEMENT_STATIC_BOOL_SETTING(VSync, true)
 IMPLEMENT_STATIC_BOOL_SETTING(PreloadMedias, false)
 IMPLEMENT_STATIC_BOOL_SETTING(IgnoreLeadingArticles, false)
+IMPLEMENT_STATIC_BOOL_SETTING(IdleFrameSkipping, true)
 IMPLEMENT_STATIC_INT_SETTING(ScreenSaverTime, 5 * 60 * 1000)
 
 #if WIN32
@@ -51,6 +52,7 @@ void Settings::updateCachedSetting(const std::string& name)
 	UPDATE_STATIC_BOOL_SETTING(VSync)
 	UPDATE_STATIC_BOOL_SETTING(PreloadMedias)
 	UPDATE_STATIC_BOOL_SETTING(IgnoreLeadingArticles)		
+	UPDATE_STATIC_BOOL_SETTING(IdleFrameSkipping)
 	UPDATE_STATIC_INT_SETTING(ScreenSaverTime)
 
 	if (mLoaded)
@@ -64,6 +66,7 @@ std::vector<const char*> settings_dont_save {
 	{ "ForceKid" },
 	{ "ForceKiosk" },
 	{ "IgnoreGamelist" },
+	{ "RebuildGamelistCache" },
 	{ "HideConsole" },
 	{ "ShowExit" },
 	{ "ExitOnRebootRequired" },
@@ -176,19 +179,24 @@ void Settings::setDefaults()
 	mIntMap["ScreenSaverTime"] = Settings::_ScreenSaverTime;
 	mIntMap["ScraperResizeWidth"] = 640;
 	mIntMap["ScraperResizeHeight"] = 0;
+	mIntMap["ScraperCacheDays"] = 30;
 
 #if defined(_WIN32) || defined(TINKERBOARD) || defined(X86) || defined(X86_64) || defined(ODROIDN2) || defined(ODROIDC2) || defined(ODROIDXU4) || defined(RPI4)
 	// Boards > 1Gb RAM
 	mIntMap["MaxVRAM"] = 256;
+	mIntMap["MaxTextureRAM"] = 128;
 #elif defined(ODROIDGOA) || defined(GAMEFORCE) || defined(RK3326) || defined(RPI2) || defined(RPI3) || defined(ROCKPRO64)
 	// Boards with 1Gb RAM
 	mIntMap["MaxVRAM"] = 128;
+	mIntMap["MaxTextureRAM"] = 64;
 #elif defined(_RPI_)
 	// Rpi 0, 1
 	mIntMap["MaxVRAM"] = 128;
+	mIntMap["MaxTextureRAM"] = 32;
 #else
 	// Other boards
 	mIntMap["MaxVRAM"] = 100;
+	mIntMap["MaxTextureRAM"] = 48;
 #endif
 
 	mStringMap["TransitionStyle"] = "auto";
@@ -285,10 +293,22 @@ void Settings::setDefaults()
 	mStringMap["DefaultGridSize"] = "";
 
 	mBoolMap["ThreadedLoading"] = true;
+	mBoolMap["GamelistCache"] = true;
+	mBoolMap["GamelistJournal"] = true;
+	mBoolMap["LazyMetadata"] = true;
+	mBoolMap["RebuildGamelistCache"] = false;
 	mBoolMap["AsyncImages"] = true;
 	mBoolMap["PreloadUI"] = false;
 	mBoolMap["PreloadMedias"] = Settings::_PreloadMedias;
 	mBoolMap["OptimizeVRAM"] = true;
+	mBoolMap["CompressTextures"] = false;
+	mIntMap["TextureCacheSize"] = 256;
+	mBoolMap["ThumbnailCache"] = true;
+	mIntMap["ThumbnailCacheSize"] = 256;
+	mBoolMap["BatchRendering"] = true;
+	mBoolMap["TextureAtlas"] = true;
+	mBoolMap["IdleFrameSkipping"] = Settings::_IdleFrameSkipping;
+	mBoolMap["PrewarmGlyphs"] = true;
 	mBoolMap["OptimizeVideo"] = true;
 
 	mBoolMap["ShowFilenames"] = false;
@@ -4,6 +4,7 @@
 #include "components/ImageComponent.h"
 #include "components/TextComponent.h"
 #include "resources/Font.h"
+#include "resources/TextureAtlas.h"
 #include "resources/TextureResource.h"
 #include "InputManager.h"
 #include "Log.h"
@@ -24,9 +25,15 @@
 #include "components/VolumeInfoComponent.h"
 #include "Splash.h"
 #include "PowerSaver.h"
+#include "Profiler.h"
+
+#define MAX_IDLE_FRAME_TIME 1000 // Redraw at least once per second, for what changes without invalidating
+
+std::atomic<bool> Window::mInvalidated(true);
 
 Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
-  mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mClockElapsed(0) 
+  mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mClockElapsed(0),
+  mTimeSinceLastRender(0), mSkippedFrames(0)
 {		
 	mTransitionOffset = 0;
 
@@ -62,6 +69,8 @@ void Window::pushGui(GuiComponent* gui)
 	gui->onShow();
 	mGuiStack.push_back(gui);
 	gui->updateHelpPrompts();
+
+	invalidate();
 }
 
 void Window::removeGui(GuiComponent* gui)
@@ -72,6 +81,7 @@ void Window::removeGui(GuiComponent* gui)
 		{						
 			gui->onHide();
 			i = mGuiStack.erase(i);
+			invalidate();
 
 			if(i == mGuiStack.cend() && mGuiStack.size()) // we just popped the stack and the stack is not empty
 			{
@@ -149,6 +159,8 @@ bool Window::init(bool initRenderer, bool initInputManager)
 	if (peekGui())
 		peekGui()->updateHelpPrompts();
 
+	invalidate();
+
 	return true;
 }
 
@@ -185,12 +197,16 @@ void Window::deinit(bool deinitRenderer)
 
 void Window::textInput(const char* text)
 {
+	invalidate();
+
 	if(peekGui())
 		peekGui()->textInput(text);
 }
 
 void Window::input(InputConfig* config, Input input)
 {
+	invalidate();
+
 	if (config == nullptr)
 		return;
 	
@@ -251,6 +267,20 @@ void Window::input(InputConfig* config, Input input)
 		// toggle TextComponent debug view with Ctrl-I
 		Settings::setDebugImage(!Settings::DebugImage());
 	}
+#ifdef _ENABLE_PROFILER_
+	else if (config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_p && SDL_GetModState() & KMOD_LCTRL)
+	{
+		// toggle the profiler & its overlay with Ctrl-P
+		Profiler::setEnabled(!Profiler::isEnabled());
+	}
+	else if (config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_d && SDL_GetModState() & KMOD_LCTRL)
+	{
+		// write the profiler statistics with Ctrl-D
+		std::string path = Profiler::dump();
+		if (!path.empty())
+			displayNotificationMessage(path);
+	}
+#endif
 	else
 	{
 		if (mControllerActivity != nullptr)
@@ -281,6 +311,8 @@ void Window::displayNotificationMessage(std::string message, int duration)
 	msg.first = message;
 	msg.second = duration;
 	mNotificationMessages.push_back(msg);
+
+	invalidate();
 }
 
 
@@ -404,9 +436,12 @@ void Window::processSongTitleNotifications()
 
 void Window::update(int deltaTime)
 {
+	PROFILE_SCOPE("Window::update");
+
 	processPostedFunctions();
 	processSongTitleNotifications();
 	processNotificationMessages();
+	Font::processPrewarmedGlyphs();
 
 	if (mNormalizeNextUpdate)
 	{
@@ -420,11 +455,17 @@ void Window::update(int deltaTime)
 
 	mFrameTimeElapsed += deltaTime;
 	mFrameCountElapsed++;
+	mTimeSinceLastRender += deltaTime;
 	if (mFrameTimeElapsed > 500)
 	{
 		mAverageDeltaTime = mFrameTimeElapsed / mFrameCountElapsed;
 
-		if (Settings::DrawFramerate())
+		bool showProfiler = false;
+#ifdef _ENABLE_PROFILER_
+		showProfiler = Profiler::isEnabled();
+#endif
+
+		if (Settings::DrawFramerate() || showProfiler)
 		{
 			std::stringstream ss;
 
@@ -436,10 +477,27 @@ void Window::update(int deltaTime)
 			float textureVramUsageMb = TextureResource::getTotalMemUsage() / 1000.0f / 1000.0f;
 			float textureTotalUsageMb = TextureResource::getTotalTextureSize() / 1000.0f / 1000.0f;
 			float fontVramUsageMb = Font::getTotalMemUsage() / 1000.0f / 1000.0f;
+			float textureRamUsageMb = TextureData::getTotalRAMUsage() / 1000.0f / 1000.0f;
 
 			ss << "\nFont VRAM: " << fontVramUsageMb << " Tex VRAM: " << textureVramUsageMb <<
 				" Tex Max: " << textureTotalUsageMb;
+			ss << "\nTex RAM: " << textureRamUsageMb << " Evicted: " << TextureResource::getEvictionCount() <<
+				" Atlas: " << TextureAtlas::getPageCount() << " pages " << (TextureAtlas::getUsedSize() / 1024) << "KB";
+
+			// renderer work of the last frame
+			Renderer::FrameStatistics stats = Renderer::getFrameStatistics();
+			ss << "\nDraw calls: " << stats.drawCalls << " State changes: " << stats.stateChanges <<
+				" Upload: " << (stats.uploadedBytes / 1024) << "KB Batched: " << stats.batchedDraws;
+			ss << "\nSkipped frames: " << mSkippedFrames;
+
+			Font::LayoutStatistics layouts = Font::getLayoutStatistics();
+			ss << " Text layouts: " << layouts.passes << " Cached: " << layouts.hits;
+#ifdef _ENABLE_PROFILER_
+			if (showProfiler)
+				ss << "\n" << Profiler::getSummary();
+#endif
 			mFrameDataText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(ss.str(), 50.f, 50.f, 0xFF00FFFF));
+			invalidate();
 		}
 
 		mFrameTimeElapsed = 0;
@@ -466,7 +524,11 @@ void Window::update(int deltaTime)
 				else
 					clockBuf = Utils::Time::timeToString(clockNow, "%H:%M");
 
-				mClock->setText(clockBuf);
+				if (mClock->getValue() != clockBuf)
+				{
+					mClock->setText(clockBuf);
+					invalidate();
+				}
 			}
 
 			mClockElapsed = 1000; // next update in 1000ms
@@ -476,7 +538,10 @@ void Window::update(int deltaTime)
 	mTimeSinceLastInput += deltaTime;
 
 	if (peekGui())
+	{
+		PROFILE_COMPONENT(peekGui());
 		peekGui()->update(deltaTime);
+	}
 
 	// Update the screensaver
 	if (mScreenSaver)
@@ -495,10 +560,36 @@ void Window::update(int deltaTime)
 	AudioManager::update(deltaTime);
 }
 
+bool Window::isRenderNeeded()
+{
+	if (!Settings::IdleFrameSkipping() || mInvalidated || mTimeSinceLastRender >= MAX_IDLE_FRAME_TIME)
+		return true;
+
+	// Activities that change the screen continuously without invalidating each frame
+	if (PowerSaver::isPaused() || mRenderScreenSaver || isProcessing() || mNotificationPopups.size() || mAsyncNotificationComponent.size())
+		return true;
+
+	if (mScreenSaver != nullptr && mScreenSaver->isScreenSaverActive())
+		return true;
+
+	return false;
+}
+
+void Window::skipFrame()
+{
+	mSkippedFrames++;
+}
+
 void Window::render()
 {
+	PROFILE_SCOPE("Window::render");
+
 	Transform4x4f transform = Transform4x4f::Identity();
 
+	// Invalidations made while rendering are for the next frame
+	mInvalidated = false;
+	mTimeSinceLastRender = 0;
+
 	mRenderedHelpPrompts = false;
 
 	// draw only bottom and top of GuiStack (if they are different)
@@ -507,7 +598,11 @@ void Window::render()
 		auto& bottom = mGuiStack.front();
 		auto& top = mGuiStack.back();
 
-		bottom->render(transform);
+		{
+			PROFILE_COMPONENT(bottom);
+			bottom->render(transform);
+		}
+
 		if(bottom != top)
 		{
 			if ((top->getTag() == "GuiLoading") && mGuiStack.size() > 2)
@@ -518,6 +613,7 @@ void Window::render()
 				if (middle != bottom)
 					middle->render(transform);
 
+				PROFILE_COMPONENT(top);
 				top->render(transform);
 			}
 			else
@@ -530,6 +626,8 @@ void Window::render()
 				}
 
 				mBackgroundOverlay->render(transform);
+
+				PROFILE_COMPONENT(top);
 				top->render(transform);
 			}
 		}
@@ -539,7 +637,14 @@ void Window::render()
 		if(!mRenderedHelpPrompts)
 			mHelp->render(transform);
 
-	if(Settings::DrawFramerate() && mFrameDataText)
+	bool showProfiler = false;
+#ifdef _ENABLE_PROFILER_
+	showProfiler = Profiler::isEnabled();
+	if (showProfiler)
+		Profiler::renderGraph();
+#endif
+
+	if((Settings::DrawFramerate() || showProfiler) && mFrameDataText)
 	{
 		Renderer::setMatrix(Transform4x4f::Identity());
 		mDefaultFonts.at(1)->renderTextCache(mFrameDataText.get());
@@ -737,6 +842,7 @@ void Window::onSleep()
 
 void Window::onWake()
 {
+	invalidate();
 	Scripting::fireEvent("wake");
 }
 
@@ -912,6 +1018,9 @@ void Window::processPostedFunctions()
 {
 	std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
 
+	if (mFunctions.size())
+		invalidate();
+
 	for (auto func : mFunctions)
 	{
 		TRYCATCH("processPostedFunction", func.func())
@@ -6,6 +6,7 @@
 #include "InputConfig.h"
 #include "Settings.h"
 #include "math/Vector2f.h"
+#include <atomic>
 #include <memory>
 #include <functional>
 
@@ -59,6 +60,12 @@ public:
 	void update(int deltaTime);
 	void render();
 
+	// Idle frame skipping : render & swap only when something changed since the last frame.
+	// Components call invalidate() when they change outside of input handling (animations, video frames, async loads...)
+	static void invalidate() { mInvalidated = true; }
+	bool isRenderNeeded();
+	void skipFrame();
+
 	bool init(bool initRenderer = true, bool initInputManager = true);
 	void deinit(bool deinitRenderer = true);
 
@@ -159,6 +166,10 @@ private:
 	bool mRenderedHelpPrompts;
 
 	int mTransitionOffset;
+
+	static std::atomic<bool> mInvalidated;
+	int mTimeSinceLastRender;
+	unsigned int mSkippedFrames;
 };
 
 #endif // ES_CORE_WINDOW_H
@@ -57,6 +57,8 @@ void AnimatedImageComponent::update(int deltaTime)
 
 	mFrameAccumulator += deltaTime;
 
+	const int currentFrame = mCurrentFrame;
+
 	while(mFrames.at(mCurrentFrame).second <= mFrameAccumulator)
 	{
 		mCurrentFrame++;
@@ -77,6 +79,9 @@ void AnimatedImageComponent::update(int deltaTime)
 
 		mFrameAccumulator -= mFrames.at(mCurrentFrame).second;
 	}
+
+	if (mCurrentFrame != currentFrame)
+		invalidate();
 }
 
 void AnimatedImageComponent::render(const Transform4x4f& trans)
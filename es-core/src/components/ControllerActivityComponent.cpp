@@ -144,6 +144,7 @@ void ControllerActivityComponent::update(int deltaTime)
 			{
 				pad.timeOut = 0;
 				pad.keyState = 0;
+				invalidate();
 			}
 		}
 	}
@@ -503,6 +504,8 @@ int ControllerActivityComponent::renderTexture(float x, float w, std::shared_ptr
 	vertices[2] = { { left + sz.x(), top },{ 1.0f, 1.0f }, clr };
 	vertices[3] = { { left + sz.x(), sz.y() },{ 1.0f, 0.0f }, clr };
 
+	TextureResource::mapTextureCoordinates(vertices, 4, texture->getTextureRect());
+
 	Renderer::drawTriangleStrips(&vertices[0], 4);
 	Renderer::bindTexture(0);
 
@@ -137,6 +137,7 @@ void DateTimeEditComponent::update(int deltaTime)
 		{
 			mRelativeUpdateAccumulator = 0;
 			updateTextCache();
+			invalidate();
 		}
 	}
 
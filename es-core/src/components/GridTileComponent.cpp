@@ -117,6 +117,24 @@ std::shared_ptr<TextureResource> GridTileComponent::getTexture(bool marquee)
 	return nullptr; 
 }
 
+void GridTileComponent::prefetch()
+{
+	if (mImage != nullptr)
+		mImage->prefetch();
+
+	if (mMarquee != nullptr)
+		mMarquee->prefetch();
+}
+
+void GridTileComponent::cancelPrefetch()
+{
+	if (mImage != nullptr)
+		mImage->cancelPrefetch();
+
+	if (mMarquee != nullptr)
+		mMarquee->cancelPrefetch();
+}
+
 void GridTileComponent::resize()
 {
 	auto& currentProperties = getCurrentProperties();
@@ -245,6 +245,9 @@ public:
 
 	std::shared_ptr<TextureResource> getTexture(bool marquee = false);
 
+	void prefetch();
+	void cancelPrefetch();
+
 	Vector3f getLaunchTarget();
 
 private:
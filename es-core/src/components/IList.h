@@ -269,6 +269,7 @@ protected:
 	void listUpdate(int deltaTime)
 	{
 		// update the title overlay opacity
+		const unsigned char previousOpacity = mTitleOverlayOpacity;
 		const int dir = (mScrollTier >= mTierList.count - 1) ? 1 : -1; // fade in if scroll tier is >= 1, otherwise fade out
 		int op = mTitleOverlayOpacity + deltaTime*dir; // we just do a 1-to-1 time -> opacity, no scaling
 		if(op >= 255)
@@ -278,9 +279,15 @@ protected:
 		else
 			mTitleOverlayOpacity = (unsigned char)op;
 
+		if (mTitleOverlayOpacity != previousOpacity)
+			invalidate();
+
 		if(mScrollVelocity == 0 || size() < 2)
 			return;
 
+		// held direction : the cursor keeps moving without input events
+		invalidate();
+
 		mScrollCursorAccumulator += deltaTime;
 		mScrollTierAccumulator += deltaTime;
 
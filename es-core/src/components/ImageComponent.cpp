@@ -24,7 +24,7 @@ ImageComponent::ImageComponent(Window* window, bool forceLoad, bool dynamic) : G
 	mTargetIsMax(false), mTargetIsMin(false), mFlipX(false), mFlipY(false), mTargetSize(0, 0), mColorShift(0xFFFFFFFF),
 	mColorShiftEnd(0xFFFFFFFF), mColorGradientHorizontal(true), mForceLoad(forceLoad), mDynamic(dynamic),
 	mFadeOpacity(0), mFading(false), mRotateByTargetSize(false), mTopLeftCrop(0.0f, 0.0f), mBottomRightCrop(1.0f, 1.0f),
-	mReflection(0.0f, 0.0f), mPadding(Vector4f(0, 0, 0, 0))
+	mReflection(0.0f, 0.0f), mPadding(Vector4f(0, 0, 0, 0)), mTextureRect(0, 0, 1, 1)
 {
 	mScaleOrigin = Vector2f::Zero();
 	mCheckClipping = true;
@@ -401,6 +401,9 @@ void ImageComponent::updateVertices()
 			mVertices[i].tex[1] = py - mVertices[i].tex[1];
 	}
 
+	mTextureRect = mTexture->getTextureRect();
+	TextureResource::mapTextureCoordinates(mVertices, 4, mTextureRect);
+
 	updateColors();
 	updateRoundCorners();
 }
@@ -494,6 +497,10 @@ void ImageComponent::render(const Transform4x4f& parentTrans)
 			return;
 		}
 
+		// The texture was uploaded to the atlas, or moved
+		if (mTexture->getTextureRect() != mTextureRect)
+			updateVertices();
+
 		beginCustomClipRect();
 
 		// Align left
@@ -608,6 +615,9 @@ void ImageComponent::fadeIn(bool textureLoaded)
 
 			// Apply the combination of the target opacity and current fade			
 			updateColors();
+
+			// The fade goes on at the next frame
+			invalidate();
 		}
 	}
 }
@@ -783,6 +793,12 @@ void ImageComponent::applyTheme(const std::shared_ptr<ThemeData>& theme, const s
 				else
 					setImage(path, false, MaxSizeInfo(), false);
 			}
+
+			// Theme images are kept in memory longer than game media
+			if (mTexture != nullptr)
+				mTexture->setTextureClass(TEXTURE_CLASS_THEME);
+			if (mLoadingTexture != nullptr)
+				mLoadingTexture->setTextureClass(TEXTURE_CLASS_THEME);
 		}
 	}
 
@@ -832,6 +848,22 @@ void ImageComponent::onHide()
 		mTexture->setRequired(false);	
 }
 
+void ImageComponent::prefetch()
+{
+	auto texture = mLoadingTexture != nullptr ? mLoadingTexture : mTexture;
+	if (texture != nullptr && !texture->isLoaded())
+		texture->prefetch();
+}
+
+void ImageComponent::cancelPrefetch()
+{
+	if (mLoadingTexture != nullptr)
+		mLoadingTexture->cancelPrefetch();
+
+	if (mTexture != nullptr)
+		mTexture->cancelPrefetch();
+}
+
 void ImageComponent::update(int deltaTime)
 {
 	GuiComponent::update(deltaTime);
@@ -844,7 +876,10 @@ void ImageComponent::update(int deltaTime)
 		{
 			auto item = mPlaylist->getNextItem();
 			if (!item.empty())
+			{
 				setImage(item, false, getMaxSizeInfo());
+				invalidate();
+			}
 
 			mPlaylistTimer = 0.0;
 		}
@@ -96,6 +96,10 @@ public:
 
 	std::shared_ptr<TextureResource> getTexture() { return mTexture; };
 
+	// Starts loading the image in background while it is still off screen
+	void prefetch();
+	void cancelPrefetch();
+
 	const MaxSizeInfo getMaxSizeInfo()
 	{
 		if (mTargetSize == Vector2f(0, 0))
@@ -143,6 +147,7 @@ private:
 	// Used internally whenever the resizing parameters or texture change.
 
 	Renderer::Vertex mVertices[4];
+	Vector4f mTextureRect; // part of the bound texture the vertices were built for
 
 	void updateVertices();
 	void updateColors();
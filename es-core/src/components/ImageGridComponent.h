@@ -74,6 +74,7 @@ protected:
 public:
 	using IList<ImageGridData, T>::size;
 	using IList<ImageGridData, T>::isScrolling;
+	using IList<ImageGridData, T>::getScrollingVelocity;
 	using IList<ImageGridData, T>::stopScrolling;
 
 	ImageGridComponent(Window* window);
@@ -119,6 +120,7 @@ private:
 	void buildTiles();
 	void updateTiles(bool allowAnimation = true, bool updateSelectedState = true);
 	void updateTileAtPos(int tilePos, int imgPos, bool allowAnimation = true, bool updateSelectedState = true);
+	void prefetchTiles();
 	void calcGridDimension();
 	
 	inline bool isVertical() { return mScrollDirection == SCROLL_VERTICALLY; };
@@ -1009,6 +1011,8 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 		if (std::find(newTextures.cbegin(), newTextures.cend(), tex) == newTextures.cend())
 			TextureResource::cancelAsync(tex);
 	}
+
+	prefetchTiles();
 	
 	if (updateSelectedState)
 		mLastCursor = mCursor;
@@ -1016,6 +1020,49 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 	mEntriesDirty = false;
 }
 
+// The EXTRAITEMS rows (or columns) on each side of the grid are off screen : load the ones the cursor is heading to
+// while the visible tiles are done, and drop the pending loads of the ones it is leaving.
+template<typename T>
+void ImageGridComponent<T>::prefetchTiles()
+{
+	int dimOpposite = isVertical() ? mGridDimension.x() : mGridDimension.y();
+	if (dimOpposite <= 0)
+		return;
+
+	int lines = (int)mTiles.size() / dimOpposite;
+	if (lines <= 2 * EXTRAITEMS)
+		return;
+
+	int velocity = getScrollingVelocity();
+
+	// Slow scrolling only reaches the nearest line before the next cursor move, fast tiers the whole buffer.
+	// When the cursor is stopped, the nearest line on both sides is prepared
+	int depth = (velocity != 0 && mScrollTier > 0) ? EXTRAITEMS : 1;
+
+	for (int ti = 0; ti < (int)mTiles.size(); ti++)
+	{
+		auto tile = mTiles.at(ti);
+		if (!tile->isVisible())
+			continue;
+
+		int line = ti / dimOpposite;
+
+		int distance; // Number of lines from the visible part of the grid, negative before it
+		if (line < EXTRAITEMS)
+			distance = line - EXTRAITEMS;
+		else if (line >= lines - EXTRAITEMS)
+			distance = line - (lines - EXTRAITEMS) + 1;
+		else
+			continue;
+
+		bool isAhead = velocity == 0 || (velocity > 0) == (distance > 0);
+		if (isAhead && abs(distance) <= depth)
+			tile->prefetch();
+		else
+			tile->cancelPrefetch();
+	}
+}
+
 template<typename T>
 void ImageGridComponent<T>::updateTileAtPos(int tilePos, int imgPos, bool allowAnimation, bool updateSelectedState)
 {
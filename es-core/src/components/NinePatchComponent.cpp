@@ -7,7 +7,7 @@
 NinePatchComponent::NinePatchComponent(Window* window, const std::string& path, unsigned int edgeColor, unsigned int centerColor) : GuiComponent(window),
 	mCornerSize(16, 16),
 	mEdgeColor(edgeColor), mCenterColor(centerColor),
-	mVertices(NULL), mPadding(Vector4f(0, 0, 0, 0))
+	mVertices(NULL), mPadding(Vector4f(0, 0, 0, 0)), mTextureRect(0, 0, 1, 1)
 {
     mRoundedVertices.clear();
 	mTimer = 0;
@@ -134,6 +134,9 @@ void NinePatchComponent::buildVertices()
 		v += 6;
 	}
 
+	mTextureRect = mTexture->getTextureRect();
+	TextureResource::mapTextureCoordinates(mVertices, 6 * 9, mTextureRect);
+
 	updateColors();
 }
 
@@ -178,6 +181,13 @@ void NinePatchComponent::render(const Transform4x4f& parentTrans)
 	}
 	else if (mTexture->bind())
 	{
+		if (mTexture->getTextureRect() != mTextureRect)
+		{
+			buildVertices();
+			if (mVertices == nullptr)
+				return;
+		}
+
 		if (mAnimateTiming > 0)
 		{
 			float opacity = mOpacity / 255.0;
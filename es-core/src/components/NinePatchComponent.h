@@ -67,6 +67,7 @@ private:
 	unsigned int mEdgeColor;
 	unsigned int mCenterColor;
 	std::shared_ptr<TextureResource> mTexture;
+	Vector4f mTextureRect;
 	
 	Vector2f mPreviousSize;
 
@@ -65,6 +65,8 @@ void ScrollableContainer::setScrollPos(const Vector2f& pos)
 
 void ScrollableContainer::update(int deltaTime)
 {
+	const Vector2f scrollPos = mScrollPos;
+
 	if(mAutoScrollSpeed != 0)
 	{
 		mAutoScrollAccumulator += deltaTime;
@@ -107,6 +109,9 @@ void ScrollableContainer::update(int deltaTime)
 			reset();
 	}
 
+	if (mScrollPos != scrollPos)
+		invalidate();
+
 	GuiComponent::update(deltaTime);
 }
 
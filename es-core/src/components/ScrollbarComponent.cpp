@@ -74,6 +74,8 @@ void ScrollbarComponent::update(int deltaTime)
 
 	if (mFadeOutTime > 0)
 	{
+		invalidate();
+
 		mFadeOutTime -= deltaTime;
 		if (mFadeOutTime <= 0)
 		{
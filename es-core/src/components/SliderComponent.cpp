@@ -62,6 +62,8 @@ void SliderComponent::update(int deltaTime)
 {
 	if(mMoveRate != 0)
 	{
+		invalidate();
+
 		mMoveAccumulator += deltaTime;
 		while(mMoveAccumulator >= MOVE_REPEAT_RATE)
 		{
@@ -397,6 +397,9 @@ void TextComponent::update(int deltaTime)
 {
 	GuiComponent::update(deltaTime);
 
+	const int marqueeOffset = mMarqueeOffset;
+	const int marqueeOffset2 = mMarqueeOffset2;
+
 	if (!mShowing)
 	{
 		mMarqueeTime = 0;
@@ -489,6 +492,9 @@ void TextComponent::update(int deltaTime)
 		mMarqueeOffset = 0;
 		mMarqueeOffset2 = 0;
 	}
+
+	if (mMarqueeOffset != marqueeOffset || mMarqueeOffset2 != marqueeOffset2)
+		invalidate();
 }
 
 void TextComponent::onShow()
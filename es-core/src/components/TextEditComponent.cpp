@@ -237,10 +237,15 @@ void TextEditComponent::update(int deltaTime)
 		}
 	}
 
+	const bool cursorVisible = mBlinkTime < BLINKTIME / 2;
+
 	mBlinkTime += deltaTime;
 	if (mBlinkTime >= BLINKTIME)
 		mBlinkTime = 0;
 
+	if (mEditing && (mBlinkTime < BLINKTIME / 2) != cursorVisible)
+		invalidate();
+
 	updateCursorRepeat(deltaTime);
 	GuiComponent::update(deltaTime);
 }
@@ -662,6 +662,16 @@ namespace Renderer
 		Instance()->bindTexture(_texture);
 	}
 
+	bool supportsTexture(const Texture::Type _type)
+	{
+		return Instance()->supportsTexture(_type);
+	}
+
+	unsigned int createCompressedTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data, const unsigned int _size)
+	{
+		return Instance()->createCompressedTexture(_type, _linear, _repeat, _width, _height, _data, _size);
+	}
+
 	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
 		Instance()->drawLines(_vertices, _numVertices, _srcBlendFactor, _dstBlendFactor);
@@ -717,4 +727,9 @@ namespace Renderer
 		Instance()->swapBuffers();
 	}
 
+	FrameStatistics getFrameStatistics()
+	{
+		return Instance()->getFrameStatistics();
+	}
+
 } // Renderer::
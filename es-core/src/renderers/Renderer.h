@@ -37,7 +37,9 @@ namespace Renderer
 			RGBA     = 0,
             RGB      = 1,
 			ALPHA    = 2,
-            RGBA1555 = 3
+            RGBA1555 = 3,
+			ETC1     = 4, // opaque, uploaded as ETC2 RGB8 when only ETC2 is available
+			ETC2_RGBA = 5 // ETC2 RGBA8 with EAC alpha
 		}; // Type
 
 	} // Texture::
@@ -64,6 +66,18 @@ namespace Renderer
 
 	}; // Vertex
 
+	// Counters of the last rendered frame, for the debug overlay
+	struct FrameStatistics
+	{
+		FrameStatistics() : drawCalls(0), stateChanges(0), uploadedBytes(0), batchedDraws(0) { }
+
+		unsigned int drawCalls;     // glDrawArrays calls
+		unsigned int stateChanges;  // shader, texture & blend state switches
+		unsigned int uploadedBytes; // vertex data sent to the GPU
+		unsigned int batchedDraws;  // draws merged into the previous one
+
+	}; // FrameStatistics
+
 	class IRenderer
 	{
 	public:
@@ -82,6 +96,10 @@ namespace Renderer
 		virtual void         updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data) = 0;
 		virtual void         bindTexture(const unsigned int _texture) = 0;
 
+		// Compressed textures are optional, renderers without support keep these defaults
+		virtual bool         supportsTexture(const Texture::Type _type) { return _type < Texture::ETC1; }
+		virtual unsigned int createCompressedTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data, const unsigned int _size) { return 0; }
+
 		virtual void         drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA) = 0;
 		virtual void         drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA, bool verticesChanged = true) = 0;
 		virtual void		 drawTriangleFan(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA) = 0;
@@ -96,6 +114,8 @@ namespace Renderer
 
 		virtual void         setSwapInterval() = 0;
 		virtual void         swapBuffers() = 0;
+
+		virtual FrameStatistics getFrameStatistics() { return FrameStatistics(); }
 	};
 	
 	std::vector<std::string> getRendererNames();
@@ -130,6 +150,8 @@ namespace Renderer
 	void         destroyTexture    (const unsigned int _texture);
 	void         updateTexture     (const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data);
 	void         bindTexture       (const unsigned int _texture);
+	bool         supportsTexture   (const Texture::Type _type);
+	unsigned int createCompressedTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data, const unsigned int _size);
 	void         drawLines         (const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
 	void         drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA, bool verticesChanged = true);
 	void         setProjection     (const Transform4x4f& _projection);
@@ -138,6 +160,7 @@ namespace Renderer
 	void         setScissor        (const Rect& _scissor);
 	void         setSwapInterval   ();
 	void         swapBuffers       ();
+	FrameStatistics getFrameStatistics();
 
 	std::string  getDriverName();
 	std::vector<std::pair<std::string, std::string>> getDriverInformation();
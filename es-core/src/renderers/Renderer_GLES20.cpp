@@ -19,6 +19,18 @@
 #define GL_UNSIGNED_SHORT_1_5_5_5_REV_EXT GL_UNSIGNED_SHORT_1_5_5_5_REV
 #endif
 
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
 namespace Renderer
 {
 
@@ -50,14 +62,47 @@ namespace Renderer
 	static std::set<unsigned int> _alphaTextures;
 	static std::set<unsigned int> _opaqueTextures;
 
+	// Compressed formats listed by the driver
+	static GLenum _etc1Format = 0;
+	static bool   _etc2RgbaSupported = false;
+
 	static unsigned int boundTexture = 0;
 
+	// Frame-level batching : consecutive triangle strips sharing texture, shader & blend mode are transformed on the CPU,
+	// joined with degenerate triangles and sent with a single upload & draw call
+	constexpr int MAX_BATCH_VERTICES = 16384;
+	constexpr int BATCH_VERTEX_BUFFERS = 4;
+
+	static bool                batchingEnabled = true;
+	static GLuint              batchVertexBuffer[BATCH_VERTEX_BUFFERS];
+	static int                 currentBatchVBO = 0;
+	static std::vector<Vertex> batchVertices;
+	static ShaderProgram*      batchProgram = nullptr;
+	static Blend::Factor       batchSrcBlendFactor = Blend::ONE;
+	static Blend::Factor       batchDstBlendFactor = Blend::ONE;
+
+	static bool   blendEnabled = false;
+	static GLenum blendSrcFactor = GL_ZERO;
+	static GLenum blendDstFactor = GL_ZERO;
+
+	// False once the batch buffer replaced the vertices of the last unbatched draw
+	static bool vertexBufferReusable = false;
+
+	static FrameStatistics currentFrameStatistics;
+	static FrameStatistics lastFrameStatistics;
+
 //////////////////////////////////////////////////////////////////////////
 
 	static ShaderProgram* currentProgram = nullptr;
 	
-	static void useProgram(ShaderProgram* program)
+	static void useProgram(ShaderProgram* program, const Transform4x4f* matrix = nullptr)
 	{
+        if (program != nullptr && program != currentProgram)
+            currentFrameStatistics.stateChanges++;
+
+        if (matrix == nullptr)
+            matrix = &mvpMatrix;
+
         GLint id;
         /*GL_CHECK_ERROR(glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&id));
         bool changeProgram = false;
@@ -68,7 +113,7 @@ namespace Renderer
         if (program == &shaderProgramColorTexture)
         {
             GL_CHECK_ERROR(glUseProgram(shaderProgramColorTexture.id));
-            GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorTexture.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+            GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorTexture.mvpUniform, 1, GL_FALSE, (float*)matrix));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorTexture.posAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos)));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorTexture.colAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const void*)offsetof(Vertex, col)));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorTexture.texAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, tex)));
@@ -80,7 +125,7 @@ namespace Renderer
         if (program == &shaderProgramColorTextureOpaque)
         {
             GL_CHECK_ERROR(glUseProgram(shaderProgramColorTextureOpaque.id));
-            GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorTextureOpaque.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+            GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorTextureOpaque.mvpUniform, 1, GL_FALSE, (float*)matrix));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorTextureOpaque.posAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos)));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorTextureOpaque.colAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const void*)offsetof(Vertex, col)));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorTextureOpaque.texAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, tex)));
@@ -93,7 +138,7 @@ namespace Renderer
         {
             // Setup shader (always NOT textured)
             GL_CHECK_ERROR(glUseProgram(shaderProgramColorNoTexture.id));
-            GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorNoTexture.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+            GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorNoTexture.mvpUniform, 1, GL_FALSE, (float*)matrix));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorNoTexture.posAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos)));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorNoTexture.colAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const void*)offsetof(Vertex, col)));
             GL_CHECK_ERROR(glEnableVertexAttribArray(shaderProgramColorNoTexture.posAttrib));
@@ -103,7 +148,7 @@ namespace Renderer
         if (program == &shaderProgramAlpha)
         {
             GL_CHECK_ERROR(glUseProgram(shaderProgramAlpha.id));
-            GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramAlpha.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+            GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramAlpha.mvpUniform, 1, GL_FALSE, (float*)matrix));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramAlpha.posAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos)));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramAlpha.colAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const void*)offsetof(Vertex, col)));
             GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramAlpha.texAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, tex)));
@@ -297,8 +342,31 @@ static GLuint bigVertexBuffer = 0;
             GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[i]));
             GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * MAX_VERTICES_PER_CALL, nullptr, GL_DYNAMIC_DRAW));
         }
+
+		GL_CHECK_ERROR(glGenBuffers(BATCH_VERTEX_BUFFERS, batchVertexBuffer));
+		batchVertices.reserve(MAX_BATCH_VERTICES);
 	} // setupVertexBuffer
 
+//////////////////////////////////////////////////////////////////////////
+
+	static void uploadVertices(const Vertex* _vertices, const unsigned int _numVertices)
+	{
+        if (_numVertices > MAX_VERTICES_PER_CALL)
+        {
+            GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, bigVertexBuffer));
+            GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_STATIC_DRAW));
+        }
+        else
+        {
+            GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[currentVBO]));
+            currentVBO = (currentVBO + 1) % MAX_VERTEX_BUFFERS;
+            GL_CHECK_ERROR(glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * _numVertices, _vertices));
+        }
+
+		currentFrameStatistics.uploadedBytes += sizeof(Vertex) * _numVertices;
+		vertexBufferReusable = true;
+	} // uploadVertices
+
 //////////////////////////////////////////////////////////////////////////
 
 	static GLenum convertBlendFactor(const Blend::Factor _blendFactor)
@@ -320,6 +388,131 @@ static GLuint bigVertexBuffer = 0;
 
 	} // convertBlendFactor
 
+//////////////////////////////////////////////////////////////////////////
+
+	// Blending is disabled as soon as one of the factors is ONE
+	static void setBlendMode(const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		bool enable = (_srcBlendFactor != Blend::ONE && _dstBlendFactor != Blend::ONE);
+		if (enable != blendEnabled)
+		{
+			if (enable)
+				GL_CHECK_ERROR(glEnable(GL_BLEND));
+			else
+				GL_CHECK_ERROR(glDisable(GL_BLEND));
+
+			blendEnabled = enable;
+			currentFrameStatistics.stateChanges++;
+		}
+
+		if (!enable)
+			return;
+
+		GLenum src = convertBlendFactor(_srcBlendFactor);
+		GLenum dst = convertBlendFactor(_dstBlendFactor);
+		if (src != blendSrcFactor || dst != blendDstFactor)
+		{
+			GL_CHECK_ERROR(glBlendFunc(src, dst));
+			blendSrcFactor = src;
+			blendDstFactor = dst;
+			currentFrameStatistics.stateChanges++;
+		}
+
+	} // setBlendMode
+
+//////////////////////////////////////////////////////////////////////////
+
+	static ShaderProgram* getTextureProgram(const unsigned int _texture)
+	{
+		if (_texture == 0)
+			return &shaderProgramColorNoTexture;
+
+		if (_alphaTextures.find(_texture) != _alphaTextures.cend())
+			return &shaderProgramAlpha;
+
+		if (_opaqueTextures.find(_texture) != _opaqueTextures.cend())
+			return &shaderProgramColorTextureOpaque;
+
+		return &shaderProgramColorTexture;
+
+	} // getTextureProgram
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void drawArrays(const GLenum _mode, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		setBlendMode(_srcBlendFactor, _dstBlendFactor);
+		GL_CHECK_ERROR(glDrawArrays(_mode, 0, _numVertices));
+		currentFrameStatistics.drawCalls++;
+
+	} // drawArrays
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void flushBatch()
+	{
+		if (batchVertices.empty())
+			return;
+
+		GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, batchVertexBuffer[currentBatchVBO]));
+		currentBatchVBO = (currentBatchVBO + 1) % BATCH_VERTEX_BUFFERS;
+		GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * batchVertices.size(), batchVertices.data(), GL_STREAM_DRAW));
+		currentFrameStatistics.uploadedBytes += sizeof(Vertex) * batchVertices.size();
+		vertexBufferReusable = false;
+
+		// Vertices are already in world space
+		useProgram(batchProgram, &projectionMatrix);
+		drawArrays(GL_TRIANGLE_STRIP, batchVertices.size(), batchSrcBlendFactor, batchDstBlendFactor);
+
+		batchVertices.clear();
+
+	} // flushBatch
+
+//////////////////////////////////////////////////////////////////////////
+
+	static bool addToBatch(const Vertex* _vertices, const unsigned int _numVertices, ShaderProgram* _program, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		// Degenerate vertices take 2 more slots
+		if (_numVertices < 3 || _numVertices + 2 > MAX_BATCH_VERTICES)
+			return false;
+
+		// Projective transforms can't be applied on the CPU without the w component
+		const float* tm = (const float*)&worldViewMatrix;
+		if (tm[3] != 0.0f || tm[7] != 0.0f || tm[11] != 0.0f || tm[15] != 1.0f)
+			return false;
+
+		if (!batchVertices.empty() && (batchProgram != _program || batchSrcBlendFactor != _srcBlendFactor || batchDstBlendFactor != _dstBlendFactor || batchVertices.size() + _numVertices + 2 > MAX_BATCH_VERTICES))
+			flushBatch();
+
+		batchProgram = _program;
+		batchSrcBlendFactor = _srcBlendFactor;
+		batchDstBlendFactor = _dstBlendFactor;
+
+		bool join = !batchVertices.empty();
+		if (join)
+		{
+			// Repeat the last vertex of the previous strip & the first one of this strip : the triangles between them have no area
+			batchVertices.push_back(batchVertices.back());
+			currentFrameStatistics.batchedDraws++;
+		}
+
+		for (unsigned int i = 0; i < _numVertices; i++)
+		{
+			Vertex vertex = _vertices[i];
+			vertex.pos = Vector2f(
+				tm[0] * _vertices[i].pos.x() + tm[4] * _vertices[i].pos.y() + tm[12],
+				tm[1] * _vertices[i].pos.x() + tm[5] * _vertices[i].pos.y() + tm[13]);
+
+			batchVertices.push_back(vertex);
+
+			if (join && i == 0)
+				batchVertices.push_back(vertex);
+		}
+
+		return true;
+
+	} // addToBatch
+
 //////////////////////////////////////////////////////////////////////////
 
 	static GLenum convertTextureType(const Texture::Type _type)
@@ -462,6 +655,29 @@ static GLuint bigVertexBuffer = 0;
 
 		LOG(LogInfo) << " ARB_texture_non_power_of_two: " << (extensions.find("ARB_texture_non_power_of_two") != std::string::npos ? "ok" : "MISSING");
 
+		_etc1Format = 0;
+		_etc2RgbaSupported = false;
+
+#if !OPENGL_EXTENSIONS
+		GLint formatCount = 0;
+		glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount);
+		if (formatCount > 0)
+		{
+			std::vector<GLint> formats(formatCount);
+			glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+
+			for (auto format : formats)
+			{
+				if (format == GL_ETC1_RGB8_OES || (format == GL_COMPRESSED_RGB8_ETC2 && _etc1Format == 0))
+					_etc1Format = format;
+				else if (format == GL_COMPRESSED_RGBA8_ETC2_EAC)
+					_etc2RgbaSupported = true;
+			}
+		}
+#endif
+
+		LOG(LogInfo) << " ETC1 textures: " << (_etc1Format != 0 ? "ok" : "MISSING") << ", ETC2 RGBA textures: " << (_etc2RgbaSupported ? "ok" : "MISSING");
+
 #if OPENGL_EXTENSIONS
 		initializeGlExtensions();
 #endif
@@ -469,6 +685,14 @@ static GLuint bigVertexBuffer = 0;
 		setupShaders();
 		setupVertexBuffer();
 
+		batchingEnabled = Settings::getInstance()->getBool("BatchRendering");
+		batchVertices.clear();
+		vertexBufferReusable = false;
+		blendEnabled = false;
+		blendSrcFactor = GL_ZERO;
+		blendDstFactor = GL_ZERO;
+		boundTexture = 0;
+
 		GL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
 
 #if OPENGL_EXTENSIONS
@@ -486,6 +710,8 @@ static GLuint bigVertexBuffer = 0;
 
 	void GLES20Renderer::destroyContext()
 	{
+		batchVertices.clear();
+
 		SDL_GL_DeleteContext(sdlContext);
 		sdlContext = nullptr;
 
@@ -576,6 +802,8 @@ static GLuint bigVertexBuffer = 0;
 
 	void GLES20Renderer::destroyTexture(const unsigned int _texture)
 	{
+		flushBatch();
+
 		auto it1 = _alphaTextures.find(_texture);
 		if (it1 != _alphaTextures.cend())
 			_alphaTextures.erase(it1);
@@ -586,8 +814,67 @@ static GLuint bigVertexBuffer = 0;
 
 		GL_CHECK_ERROR(glDeleteTextures(1, &_texture));
 
+		// GL falls back to texture 0, and the name can be reused by the next texture created
+		if (boundTexture == _texture)
+			boundTexture = 0;
+
 	} // destroyTexture
 
+//////////////////////////////////////////////////////////////////////////
+
+	bool GLES20Renderer::supportsTexture(const Texture::Type _type)
+	{
+		if (_type == Texture::ETC1)
+			return _etc1Format != 0;
+
+		if (_type == Texture::ETC2_RGBA)
+			return _etc2RgbaSupported;
+
+		return true;
+
+	} // supportsTexture
+
+//////////////////////////////////////////////////////////////////////////
+
+	unsigned int GLES20Renderer::createCompressedTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data, const unsigned int _size)
+	{
+		if (!supportsTexture(_type) || _data == nullptr)
+			return 0;
+
+		const GLenum format = (_type == Texture::ETC1 ? _etc1Format : GL_COMPRESSED_RGBA8_ETC2_EAC);
+		unsigned int texture;
+
+		glGenTextures(1, &texture);
+		if (glGetError() != GL_NO_ERROR)
+		{
+			LOG(LogError) << "CreateCompressedTexture error: glGenTextures failed";
+			return 0;
+		}
+
+		bindTexture(texture);
+
+		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
+		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE));
+
+		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+		GL_CHECK_ERROR(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _linear ? GL_LINEAR : GL_NEAREST));
+
+		glCompressedTexImage2D(GL_TEXTURE_2D, 0, format, _width, _height, 0, _size, _data);
+		if (glGetError() != GL_NO_ERROR)
+		{
+			LOG(LogError) << "CreateCompressedTexture error: glCompressedTexImage2D failed";
+			destroyTexture(texture);
+			return 0;
+		}
+
+		// ETC1 has no alpha channel
+		if (_type == Texture::ETC1 && _opaqueTextures.find(texture) == _opaqueTextures.cend())
+			_opaqueTextures.insert(texture);
+
+		return texture;
+
+	} // createCompressedTexture
+
 //////////////////////////////////////////////////////////////////////////
 
 	void GLES20Renderer::updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
@@ -606,6 +893,9 @@ static GLuint bigVertexBuffer = 0;
                 texFormat = GL_UNSIGNED_SHORT_1_5_5_5_REV_EXT;
                 break;
         }
+
+		// Draws waiting in the batch use the current content
+		flushBatch();
 		bindTexture(_texture);
 
 		// Regular GL_ALPHA textures are black + alpha in shaders
@@ -638,42 +928,27 @@ static GLuint bigVertexBuffer = 0;
 		if (boundTexture == _texture)
 			return;
 
+		// The pending batch is drawn with the texture bound so far
+		flushBatch();
+
 		boundTexture = _texture;
         GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, _texture));
+		currentFrameStatistics.stateChanges++;
 	} // bindTexture
 
 //////////////////////////////////////////////////////////////////////////
 
 	void GLES20Renderer::drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
+		flushBatch();
+
         // Pass buffer data
-        if (_numVertices > MAX_VERTICES_PER_CALL)
-        {
-            GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, bigVertexBuffer));
-            GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_STATIC_DRAW));
-        }
-        else
-        {
-            GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[currentVBO]));
-            currentVBO = (currentVBO + 1) % MAX_VERTEX_BUFFERS;
-            GL_CHECK_ERROR(glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * _numVertices, _vertices));
-        }
+		uploadVertices(_vertices, _numVertices);
 
 		useProgram(&shaderProgramColorNoTexture);
 
 		// Do rendering
-		if (_srcBlendFactor != Blend::ONE && _dstBlendFactor != Blend::ONE)
-		{
-			GL_CHECK_ERROR(glEnable(GL_BLEND));
-			GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
-			GL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, _numVertices));
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-		}
-		else
-		{
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-			GL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, _numVertices));
-		}
+		drawArrays(GL_LINES, _numVertices, _srcBlendFactor, _dstBlendFactor);
 
 	} // drawLines
 
@@ -681,56 +956,31 @@ static GLuint bigVertexBuffer = 0;
 
 	void GLES20Renderer::drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor, bool verticesChanged)
 	{
+		ShaderProgram* program = getTextureProgram(boundTexture);
+
+		if (batchingEnabled && addToBatch(_vertices, _numVertices, program, _srcBlendFactor, _dstBlendFactor))
+			return;
+
+		flushBatch();
+
         // Pass buffer data if changed
-        if (verticesChanged)
-        {
-            if (_numVertices > MAX_VERTICES_PER_CALL)
-            {
-                GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, bigVertexBuffer));
-                GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_STATIC_DRAW));
-            }
-            else
-            {
-                GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[currentVBO]));
-                currentVBO = (currentVBO + 1) % MAX_VERTEX_BUFFERS;
-                GL_CHECK_ERROR(glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * _numVertices, _vertices));
-            }
-        }
+        if (verticesChanged || !vertexBufferReusable)
+			uploadVertices(_vertices, _numVertices);
 
 		// Setup shader
-		if (boundTexture != 0)
-		{
-			if (_alphaTextures.find(boundTexture) != _alphaTextures.cend())
-				useProgram(&shaderProgramAlpha);
-			else if (_opaqueTextures.find(boundTexture) != _opaqueTextures.cend())
-            		{
-                		useProgram(&shaderProgramColorTextureOpaque);
-            		}
-            		else
-                		useProgram(&shaderProgramColorTexture);
-		}
-		else
-			useProgram(&shaderProgramColorNoTexture);
+		useProgram(program);
 
 		// Do rendering
-		if (_srcBlendFactor != Blend::ONE && _dstBlendFactor != Blend::ONE)
-		{
-			GL_CHECK_ERROR(glEnable(GL_BLEND));
-			GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
-			GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices));
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-		}
-		else
-		{
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-			GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices));
-		}
+		drawArrays(GL_TRIANGLE_STRIP, _numVertices, _srcBlendFactor, _dstBlendFactor);
+
     } // drawTriangleStrips
 
 //////////////////////////////////////////////////////////////////////////
 
 	void GLES20Renderer::setProjection(const Transform4x4f& _projection)
 	{
+		flushBatch();
+
 		projectionMatrix = _projection;
 		mvpMatrix = projectionMatrix * worldViewMatrix;
 	} // setProjection
@@ -748,6 +998,8 @@ static GLuint bigVertexBuffer = 0;
 
 	void GLES20Renderer::setViewport(const Rect& _viewport)
 	{
+		flushBatch();
+
 		// glViewport starts at the bottom left of the window
 		GL_CHECK_ERROR(glViewport( _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h));
 
@@ -757,6 +1009,8 @@ static GLuint bigVertexBuffer = 0;
 
 	void GLES20Renderer::setScissor(const Rect& _scissor)
 	{
+		flushBatch();
+
 		if((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0))
 		{
 			GL_CHECK_ERROR(glDisable(GL_SCISSOR_TEST));
@@ -795,6 +1049,11 @@ static GLuint bigVertexBuffer = 0;
 
 	void GLES20Renderer::swapBuffers()
 	{
+		flushBatch();
+
+		lastFrameStatistics = currentFrameStatistics;
+		currentFrameStatistics = FrameStatistics();
+
 		useProgram(nullptr);
 		SDL_GL_SwapWindow(getSDLWindow());
 		GL_CHECK_ERROR(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
@@ -804,51 +1063,22 @@ static GLuint bigVertexBuffer = 0;
 
 	void GLES20Renderer::drawTriangleFan(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-        GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[currentVBO]));
-        currentVBO = (currentVBO + 1) % MAX_VERTEX_BUFFERS;
-        GL_CHECK_ERROR(glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * _numVertices, _vertices));
+		flushBatch();
+
+		uploadVertices(_vertices, _numVertices);
 
 		// Setup shader
-		if (boundTexture != 0)
-		{
-			if (_alphaTextures.find(boundTexture) != _alphaTextures.cend())
-				useProgram(&shaderProgramAlpha);
-			else if (_opaqueTextures.find(boundTexture) != _opaqueTextures.cend())
-                		useProgram(&shaderProgramColorTextureOpaque);
-            		else
-                		useProgram(&shaderProgramColorTexture);
-		}
-		else
-			useProgram(&shaderProgramColorNoTexture);
+		useProgram(getTextureProgram(boundTexture));
 
 		// Do rendering
-		if (_srcBlendFactor != Blend::ONE && _dstBlendFactor != Blend::ONE)
-		{
-			GL_CHECK_ERROR(glEnable(GL_BLEND));
-			GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
-			GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_FAN, 0, _numVertices));
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-		}
-		else
-		{
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-			GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_FAN, 0, _numVertices));			
-		}
+		drawArrays(GL_TRIANGLE_FAN, _numVertices, _srcBlendFactor, _dstBlendFactor);
 	}
 
 	void GLES20Renderer::setStencil(const Vertex* _vertices, const unsigned int _numVertices)
 	{
-        if (_numVertices > MAX_VERTICES_PER_CALL)
-        {
-            GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, bigVertexBuffer));
-            GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_STATIC_DRAW));
-        }
-        else
-        {
-            GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[currentVBO]));
-            currentVBO = (currentVBO + 1) % MAX_VERTEX_BUFFERS;
-            GL_CHECK_ERROR(glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * _numVertices, _vertices));
-        }
+		flushBatch();
+
+		uploadVertices(_vertices, _numVertices);
 
 		useProgram(&shaderProgramColorNoTexture);
 
@@ -861,6 +1091,7 @@ static GLuint bigVertexBuffer = 0;
 		glClear(GL_STENCIL_BUFFER_BIT);
 
 		glDrawArrays(GL_TRIANGLE_FAN, 0, _numVertices);
+		currentFrameStatistics.drawCalls++;
 
 		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 		glDepthMask(GL_TRUE);
@@ -871,8 +1102,14 @@ static GLuint bigVertexBuffer = 0;
 
 	void GLES20Renderer::disableStencil()
 	{
+		flushBatch();
 		glDisable(GL_STENCIL_TEST);
 	}
+
+	FrameStatistics GLES20Renderer::getFrameStatistics()
+	{
+		return lastFrameStatistics;
+	}
 } // Renderer::
 
 #endif // USE_OPENGLES_20
@@ -12,18 +12,67 @@
 #include "Settings.h"
 #include "ImageIO.h"
 #include <algorithm>
+#include <atomic>
+#include <set>
+#include <string.h>
+#include <thread>
 
 #ifdef WIN32
 #include <Windows.h>
 #endif
 
+#define FONT_TEXTURE_WIDTH			1024
+#define FONT_TEXTURE_HEIGHT			512
+#define FONT_TEXTURE_MAX_SIZE		2048
+#define GLYPH_PREWARM_PER_FRAME		128
+#define LAYOUT_CACHE_MAX_SIZE		(4 * 1024 * 1024)
+#define LAYOUT_CACHE_MAX_ENTRIES	2048
+
 FT_Library Font::sLibrary = NULL;
 
 int Font::getSize() const { return mSize; }
 
 std::map< std::pair<std::string, int>, std::weak_ptr<Font> > Font::sFontMap;
+std::map< std::string, std::weak_ptr<Font::FontAtlas> > Font::sAtlasMap;
 static std::map<unsigned int, std::string> substituableChars;
 
+std::list<Font::LayoutEntry> Font::sLayoutList;
+std::unordered_map<Font::LayoutKey, std::list<Font::LayoutEntry>::iterator, Font::LayoutKeyHash> Font::sLayoutMap;
+size_t Font::sLayoutMemUsage = 0;
+int Font::sLayoutGeneration = 0;
+Font::LayoutStatistics Font::sLayoutStatistics = { 0, 0 };
+
+std::vector<unsigned int> Font::sPrewarmChars;
+std::vector<Font::PrewarmResult> Font::sPrewarmResults;
+std::mutex Font::sPrewarmLock;
+
+struct GlyphPrewarmJob
+{
+	std::weak_ptr<Font> font;
+	std::vector<std::string> paths; // font file, then fallback fonts
+	int size;
+	std::vector<unsigned int> chars;
+};
+
+// Guarded by Font::sPrewarmLock
+static std::vector<GlyphPrewarmJob> prewarmJobs;
+
+static struct GlyphPrewarmWorker
+{
+	GlyphPrewarmWorker() : exit(false), running(false) { }
+
+	~GlyphPrewarmWorker()
+	{
+		exit = true;
+		if (thread.joinable())
+			thread.join();
+	}
+
+	std::thread			thread;
+	std::atomic<bool>	exit;
+	bool				running; // guarded by Font::sPrewarmLock
+} prewarmWorker;
+
 Font::FontFace::FontFace(ResourceData&& d, int size) : data(d)
 {
 	int err = FT_New_Memory_Face(sLibrary, data.ptr.get(), (FT_Long)data.length, 0, &face);
@@ -49,13 +98,20 @@ void Font::initLibrary()
 	}
 }
 
-size_t Font::getMemUsage() const
+size_t Font::FontAtlas::getMemUsage() const
 {
 	size_t memUsage = 0;
-	
-	for(auto tex : mTextures)
+
+	for (auto tex : textures)
 		memUsage += (tex->textureId != 0 ? tex->textureSize.x() * tex->textureSize.y() * 4 : 0);
 
+	return memUsage;
+}
+
+size_t Font::getMemUsage() const
+{
+	size_t memUsage = mAtlas->getMemUsage();
+
 	for(auto it = mFaceCache.cbegin(); it != mFaceCache.cend(); it++)
 		memUsage += it->second->data.length;
 
@@ -66,6 +122,9 @@ size_t Font::getTotalMemUsage()
 {
 	size_t total = 0;
 
+	// Sizes of the same font file share their textures : count them once
+	std::set<const FontAtlas*> atlases;
+
 	auto it = sFontMap.cbegin();
 	while(it != sFontMap.cend())
 	{
@@ -75,7 +134,14 @@ size_t Font::getTotalMemUsage()
 			continue;
 		}
 
-		total += it->second.lock()->getMemUsage();
+		auto font = it->second.lock();
+
+		for (auto fit = font->mFaceCache.cbegin(); fit != font->mFaceCache.cend(); fit++)
+			total += fit->second->data.length;
+
+		if (atlases.insert(font->mAtlas.get()).second)
+			total += font->mAtlas->getMemUsage();
+
 		it++;
 	}
 
@@ -106,8 +172,14 @@ Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
 	if(!sLibrary)
 		initLibrary();
 
-	for (unsigned int i = 0; i < 255; i++)
-		mGlyphCacheArray[i] = NULL;
+	auto atlas = sAtlasMap.find(mPath);
+	if (atlas != sAtlasMap.cend() && !atlas->second.expired())
+		mAtlas = atlas->second.lock();
+	else
+	{
+		mAtlas = std::make_shared<FontAtlas>();
+		sAtlasMap[mPath] = mAtlas;
+	}
 
 	// always initialize ASCII characters
 	for(unsigned int i = 32; i < 128; i++)
@@ -118,12 +190,17 @@ Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
 
 Font::~Font()
 {
-	unload();
+	// The textures belong to the atlas, they may still be used by other sizes of this font
+	clearFaceCache();
+	removeLayouts(this);
+}
 
-	for (auto tex : mTextures)
+Font::FontAtlas::~FontAtlas()
+{
+	for (auto tex : textures)
 		delete tex;
 
-	mTextures.clear();
+	textures.clear();
 }
 
 void Font::reload()
@@ -143,7 +220,7 @@ bool Font::unload()
 {
 	if (mLoaded)
 	{		
-		for (auto tex : mTextures)
+		for (auto tex : mAtlas->textures)
 			tex->deinitTexture();
 
 		clearFaceCache();
@@ -170,15 +247,23 @@ std::shared_ptr<Font> Font::get(int size, const std::string& path)
 	std::shared_ptr<Font> font = std::shared_ptr<Font>(new Font(def.second, def.first));
 	sFontMap[def] = std::weak_ptr<Font>(font);
 	ResourceManager::getInstance()->addReloadable(font);
+
+	if (!sPrewarmChars.empty())
+		prewarmFont(font);
+
 	return font;
 }
 
-Font::FontTexture::FontTexture()
+Font::FontTexture::FontTexture(const Vector2i& size)
 {
 	textureId = 0;
-	textureSize = Vector2i(2048, 512);
+	textureSize = size;
 	writePos = Vector2i::Zero();
 	rowHeight = 0;
+
+	pixels.resize(size.x() * size.y(), 0);
+	dirtyTop = size.y();
+	dirtyBottom = 0;
 }
 
 Font::FontTexture::~FontTexture()
@@ -218,12 +303,38 @@ void Font::FontTexture::initTexture()
 {
 	if (textureId == 0)
 	{
-		textureId = Renderer::createTexture(Renderer::Texture::ALPHA, true, false, textureSize.x(), textureSize.y(), nullptr);
+		// the copy in RAM holds every glyph written so far
+		textureId = Renderer::createTexture(Renderer::Texture::ALPHA, true, false, textureSize.x(), textureSize.y(), pixels.data());
 		if (textureId == 0)
 			LOG(LogError) << "FontTexture::initTexture() failed to create texture " << textureSize.x() << "x" << textureSize.y();
+
+		dirtyTop = textureSize.y();
+		dirtyBottom = 0;
 	}
 }
 
+void Font::FontTexture::write(const Vector2i& cursor, const Vector2i& size, const unsigned char* data, int pitch)
+{
+	for (int y = 0; y < size.y(); y++)
+		memcpy(&pixels[(cursor.y() + y) * textureSize.x() + cursor.x()], data + y * pitch, size.x());
+
+	dirtyTop = Math::min(dirtyTop, cursor.y());
+	dirtyBottom = Math::max(dirtyBottom, cursor.y() + size.y());
+}
+
+void Font::FontTexture::flush()
+{
+	if (dirtyBottom <= dirtyTop)
+		return;
+
+	// Whole rows are contiguous in the copy, a single upload covers all the glyphs added since the last one
+	if (textureId != 0)
+		Renderer::updateTexture(textureId, Renderer::Texture::ALPHA, 0, dirtyTop, textureSize.x(), dirtyBottom - dirtyTop, &pixels[dirtyTop * textureSize.x()]);
+
+	dirtyTop = textureSize.y();
+	dirtyBottom = 0;
+}
+
 void Font::FontTexture::deinitTexture()
 {
 	if(textureId != 0)
@@ -235,10 +346,11 @@ void Font::FontTexture::deinitTexture()
 
 void Font::getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out)
 {
-	if(mTextures.size())
+	auto& textures = mAtlas->textures;
+	if(textures.size())
 	{
 		// check if the most recent texture has space
-		tex_out = mTextures.back();
+		tex_out = textures.back();
 
 		// will this one work?
 		if(tex_out->findEmpty(glyphSize, cursor_out))
@@ -248,23 +360,22 @@ void Font::getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_ou
 	}
 
 	// current textures are full,
-	// make a new one
-	FontTexture* tex = new FontTexture();
-
-	int x = Math::min(2048, mSize * 64);
-	int y = Math::min(2048, Math::max(glyphSize.y(), mSize) + 2) * 1.2;
+	// make a new one, shared with the other sizes of this font
+	int x = Math::min(FONT_TEXTURE_MAX_SIZE, Math::max(FONT_TEXTURE_WIDTH, (glyphSize.x() + 5) & ~3));
+	int y = Math::min(FONT_TEXTURE_MAX_SIZE, Math::max(FONT_TEXTURE_HEIGHT, glyphSize.y() + 2));
 
-	tex->textureSize = Vector2i(x, y);
+	FontTexture* tex = new FontTexture(Vector2i(x, y));
 	tex->initTexture();
 
 	tex_out = tex;
 
-	mTextures.push_back(tex);
+	textures.push_back(tex);
 	
 	bool ok = tex_out->findEmpty(glyphSize, cursor_out);
 	if(!ok)
 	{
 		LOG(LogError) << "Glyph too big to fit on a new texture (glyph size > " << tex_out->textureSize.x() << ", " << tex_out->textureSize.y() << ")!";
+		textures.pop_back();
 		delete tex;
 		tex_out = NULL;
 	}
@@ -291,9 +402,15 @@ std::vector<std::string> getFallbackFontPaths()
 	return paths;
 }
 
-FT_Face Font::getFaceForChar(unsigned int id)
+static const std::vector<std::string>& getFallbackFonts()
 {
 	static const std::vector<std::string> fallbackFonts = getFallbackFontPaths();
+	return fallbackFonts;
+}
+
+FT_Face Font::getFaceForChar(unsigned int id)
+{
+	const std::vector<std::string>& fallbackFonts = getFallbackFonts();
 
 	// look through our current font + fallback fonts to see if any have the glyph we're looking for
 	for(unsigned int i = 0; i < fallbackFonts.size() + 1; i++)
@@ -323,22 +440,71 @@ void Font::clearFaceCache()
 	mFaceCache.clear();
 }
 
-Font::Glyph* Font::getGlyph(unsigned int id)
+Font::GlyphTable::GlyphTable() : mMask(255), mCount(0)
+{
+	mSlots.resize(mMask + 1, Slot { 0, nullptr });
+}
+
+Font::GlyphTable::~GlyphTable()
+{
+	for (auto& slot : mSlots)
+		if (slot.glyph != nullptr)
+			delete slot.glyph;
+}
+
+void Font::GlyphTable::insert(unsigned int id, Glyph* glyph)
 {
-	if (id < 255)
+	// keep the table at most 3/4 full so probing stays short
+	if ((mCount + 1) * 4 > mSlots.size() * 3)
+		grow();
+
+	size_t i = hash(id);
+	while (mSlots[i].glyph != nullptr && mSlots[i].id != id)
+		i = (i + 1) & mMask;
+
+	if (mSlots[i].glyph == nullptr)
+		mCount++;
+	else if (mSlots[i].glyph != glyph)
+		delete mSlots[i].glyph;
+
+	mSlots[i].id = id;
+	mSlots[i].glyph = glyph;
+}
+
+void Font::GlyphTable::grow()
+{
+	std::vector<Slot> slots(mSlots.size() * 2, Slot { 0, nullptr });
+	mSlots.swap(slots);
+	mMask = mSlots.size() - 1;
+
+	for (auto& slot : slots)
 	{
-		// FCA Optimisation : array is faster than a map
-		// When computing & displaying long descriptions in gamelist views, it can come here textsize*2 times per frame
-		Glyph* fastCache = mGlyphCacheArray[id];
-		if (fastCache != NULL)
-			return fastCache;
+		if (slot.glyph == nullptr)
+			continue;
+
+		size_t i = hash(slot.id);
+		while (mSlots[i].glyph != nullptr)
+			i = (i + 1) & mMask;
+
+		mSlots[i] = slot;
 	}
-	else
+}
+
+Font::Glyph* Font::getGlyph(unsigned int id)
+{
+	// is it already loaded?
+	// When computing & displaying long descriptions in gamelist views, it can come here textsize*2 times per frame
+	Glyph* glyph = mGlyphs.find(id);
+	if (glyph != nullptr)
 	{
-		// is it already loaded?
-		auto it = mGlyphMap.find(id);
-		if (it != mGlyphMap.cend())
-			return it->second;
+		if (glyph->prewarmed)
+		{
+			glyph->prewarmed = false;
+			if (glyph->glyphSize.y() > mMaxGlyphHeight)
+				mMaxGlyphHeight = glyph->glyphSize.y();
+		}
+
+		return glyph;
 	}
 
 	// nope, need to make a glyph
@@ -357,8 +523,14 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 		return NULL;
 	}
 
-	Vector2i glyphSize(g->bitmap.width, g->bitmap.rows);
+	return addGlyph(id, Vector2i(g->bitmap.width, g->bitmap.rows),
+		Vector2f((float)g->metrics.horiAdvance / 64.0f, (float)g->metrics.vertAdvance / 64.0f),
+		Vector2f((float)g->metrics.horiBearingX / 64.0f, (float)g->metrics.horiBearingY / 64.0f),
+		g->bitmap.buffer, g->bitmap.pitch);
+}
 
+Font::Glyph* Font::addGlyph(unsigned int id, const Vector2i& glyphSize, const Vector2f& advance, const Vector2f& bearing, const unsigned char* bitmap, int pitch, bool prewarmed)
+{
 	FontTexture* tex = NULL;
 	Vector2i cursor;
 	getTextureForNewGlyph(glyphSize, tex, cursor);
@@ -376,54 +548,229 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 	pGlyph->texture = tex;
 	pGlyph->texPos = Vector2f((float)cursor.x() / (float)tex->textureSize.x(), (float)cursor.y() / (float)tex->textureSize.y());
 	pGlyph->texSize = Vector2f((float)glyphSize.x() / (float)tex->textureSize.x(), (float)glyphSize.y() / (float)tex->textureSize.y());
-	pGlyph->advance = Vector2f((float)g->metrics.horiAdvance / 64.0f, (float)g->metrics.vertAdvance / 64.0f);
-	pGlyph->bearing = Vector2f((float)g->metrics.horiBearingX / 64.0f, (float)g->metrics.horiBearingY / 64.0f);	
+	pGlyph->advance = advance;
+	pGlyph->bearing = bearing;
 	pGlyph->cursor = cursor;
 	pGlyph->glyphSize = glyphSize;
+	pGlyph->prewarmed = prewarmed;
 
-	// upload glyph bitmap to texture
-	if (glyphSize.x() > 0 && glyphSize.y() > 0)
-		Renderer::updateTexture(tex->textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), g->bitmap.buffer);
+	// copy glyph bitmap to texture, it is uploaded before the texture is drawn
+	if (glyphSize.x() > 0 && glyphSize.y() > 0 && bitmap != nullptr)
+		tex->write(cursor, glyphSize, bitmap, pitch);
 
-	// update max glyph height
-	if(glyphSize.y() > mMaxGlyphHeight)
+	// update max glyph height, prewarmed glyphs must not change the layout of texts before they are used
+	if(!prewarmed && glyphSize.y() > mMaxGlyphHeight)
 		mMaxGlyphHeight = glyphSize.y();
 
-	mGlyphMap[id] = pGlyph;
-
-	if (id < 255)
-		mGlyphCacheArray[id] = pGlyph;
+	mGlyphs.insert(id, pGlyph);
 
 	// done
 	return pGlyph;
 }
 
-// completely recreate the texture data for all textures based on mGlyphs information
-void Font::rebuildTextures()
+void Font::prewarm(const std::string& text)
 {
-	// recreate OpenGL textures
-	for(auto tex : mTextures)
-		tex->initTexture();
+	std::vector<unsigned int> chars;
+
+	size_t i = 0;
+	while (i < text.length())
+	{
+		unsigned int character = Utils::String::chars2Unicode(text, i); // advances i
+		if (character >= 32)
+			chars.push_back(character);
+	}
+
+	std::sort(chars.begin(), chars.end());
+	chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+
+	sPrewarmChars = chars;
+	if (sPrewarmChars.empty())
+		return;
+
+	LOG(LogDebug) << "Font::prewarm() " << sPrewarmChars.size() << " characters";
+
+	for (auto it = sFontMap.cbegin(); it != sFontMap.cend(); it++)
+		if (!it->second.expired())
+			prewarmFont(it->second.lock());
+}
+
+void Font::prewarmFont(const std::shared_ptr<Font>& font)
+{
+	GlyphPrewarmJob job;
+	job.font = font;
+	job.size = font->mSize;
+	job.paths.push_back(font->mPath);
+
+	for (auto path : getFallbackFonts())
+		job.paths.push_back(path);
+
+	for (auto character : sPrewarmChars)
+		if (font->mGlyphs.find(character) == nullptr)
+			job.chars.push_back(character);
+
+	if (job.chars.empty())
+		return;
+
+	std::unique_lock<std::mutex> lock(sPrewarmLock);
+	prewarmJobs.push_back(std::move(job));
+
+	if (!prewarmWorker.running)
+	{
+		// the previous thread has run out of jobs
+		if (prewarmWorker.thread.joinable())
+			prewarmWorker.thread.join();
+
+		prewarmWorker.running = true;
+		prewarmWorker.thread = std::thread(&Font::prewarmThread);
+	}
+}
+
+void Font::prewarmThread()
+{
+	// FreeType objects can't be shared between threads : this one uses its own library & faces
+	FT_Library library;
+	if (FT_Init_FreeType(&library))
+	{
+		LOG(LogError) << "Font::prewarmThread() error initializing FreeType!";
+
+		std::unique_lock<std::mutex> lock(sPrewarmLock);
+		prewarmJobs.clear();
+		prewarmWorker.running = false;
+		return;
+	}
+
+	while (!prewarmWorker.exit)
+	{
+		GlyphPrewarmJob job;
+
+		{
+			std::unique_lock<std::mutex> lock(sPrewarmLock);
+			if (prewarmJobs.empty())
+			{
+				prewarmWorker.running = false;
+				break;
+			}
+
+			job = std::move(prewarmJobs.front());
+			prewarmJobs.erase(prewarmJobs.begin());
+		}
+
+		std::vector<ResourceData> datas;
+		std::vector<FT_Face> faces;
+
+		for (auto path : job.paths)
+		{
+			ResourceData data = ResourceManager::getInstance()->getFileData(path);
+			if (data.ptr == nullptr)
+				continue;
+
+			FT_Face face;
+			if (FT_New_Memory_Face(library, data.ptr.get(), (FT_Long)data.length, 0, &face))
+				continue;
+
+			FT_Set_Pixel_Sizes(face, 0, job.size);
+			datas.push_back(data);
+			faces.push_back(face);
+		}
+
+		PrewarmResult result;
+		result.font = job.font;
+
+		for (auto character : job.chars)
+		{
+			if (prewarmWorker.exit)
+				break;
+
+			// same face as getFaceForChar. Characters no face has are left to getGlyph, which draws the "missing" glyph
+			FT_Face face = nullptr;
+			for (auto fc : faces)
+			{
+				if (FT_Get_Char_Index(fc, character) != 0)
+				{
+					face = fc;
+					break;
+				}
+			}
+
+			if (face == nullptr || FT_Load_Char(face, character, FT_LOAD_RENDER))
+				continue;
+
+			FT_GlyphSlot g = face->glyph;
+
+			PrewarmedGlyph glyph;
+			glyph.id = character;
+			glyph.size = Vector2i(g->bitmap.width, g->bitmap.rows);
+			glyph.advance = Vector2f((float)g->metrics.horiAdvance / 64.0f, (float)g->metrics.vertAdvance / 64.0f);
+			glyph.bearing = Vector2f((float)g->metrics.horiBearingX / 64.0f, (float)g->metrics.horiBearingY / 64.0f);
+			glyph.bitmap.resize(glyph.size.x() * glyph.size.y());
+
+			for (int y = 0; y < glyph.size.y(); y++)
+				memcpy(glyph.bitmap.data() + y * glyph.size.x(), g->bitmap.buffer + y * g->bitmap.pitch, glyph.size.x());
+
+			result.glyphs.push_back(std::move(glyph));
+		}
 
-	// reupload the texture data
-	for(auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
+		for (auto face : faces)
+			FT_Done_Face(face);
+
+		if (!result.glyphs.empty())
+		{
+			std::unique_lock<std::mutex> lock(sPrewarmLock);
+			sPrewarmResults.push_back(std::move(result));
+		}
+	}
+
+	FT_Done_FreeType(library);
+}
+
+void Font::processPrewarmedGlyphs()
+{
+	// Packing is cheap, but a few hundred glyphs at once would still make a frame late
+	int budget = GLYPH_PREWARM_PER_FRAME;
+
+	while (budget > 0)
 	{
-		FT_Face face = getFaceForChar(it->first);
-		FT_GlyphSlot glyphSlot = face->glyph;
+		PrewarmResult result;
 
-		// load the glyph bitmap through FT
-		FT_Load_Char(face, it->first, FT_LOAD_RENDER);
+		{
+			std::unique_lock<std::mutex> lock(sPrewarmLock);
+			if (sPrewarmResults.empty())
+				return;
 
-		Glyph* glyph = it->second;
+			PrewarmResult& front = sPrewarmResults.front();
+			if ((int)front.glyphs.size() <= budget)
+			{
+				result = std::move(front);
+				sPrewarmResults.erase(sPrewarmResults.begin());
+			}
+			else
+			{
+				result.font = front.font;
+				result.glyphs.assign(std::make_move_iterator(front.glyphs.end() - budget), std::make_move_iterator(front.glyphs.end()));
+				front.glyphs.resize(front.glyphs.size() - budget);
+			}
+		}
+
+		budget -= (int)result.glyphs.size();
+
+		auto font = result.font.lock();
+		if (font == nullptr)
+			continue;
 
-		// upload to texture
-		Renderer::updateTexture(glyph->texture->textureId, Renderer::Texture::ALPHA,
-			glyph->cursor.x(), glyph->cursor.y(),
-			glyph->glyphSize.x(), glyph->glyphSize.y(),
-			glyphSlot->bitmap.buffer);
+		for (auto& glyph : result.glyphs)
+			if (font->mGlyphs.find(glyph.id) == nullptr)
+				font->addGlyph(glyph.id, glyph.size, glyph.advance, glyph.bearing, glyph.bitmap.data(), glyph.size.x(), true);
 	}
 }
 
+// completely recreate the texture data for all textures from their copy in RAM
+void Font::rebuildTextures()
+{
+	// recreate OpenGL textures, shared textures already recreated by another size are kept
+	for(auto tex : mAtlas->textures)
+		tex->initTexture();
+}
+
 void Font::renderTextCache(TextCache* cache, bool verticesChanged)
 {
 	if(cache == NULL)
@@ -439,6 +786,9 @@ void Font::renderTextCache(TextCache* cache, bool verticesChanged)
 		if (vertex.textureIdPtr == nullptr)
 			continue;
 
+		if (vertex.texture != nullptr)
+			vertex.texture->flush();
+
 		if (tex != *vertex.textureIdPtr)
 		{
 			tex = *vertex.textureIdPtr;
@@ -482,6 +832,9 @@ void Font::renderGradientTextCache(TextCache* cache, unsigned int colorTop, unsi
 		if (*it->textureIdPtr == 0)
 			continue;
 
+		if (it->texture != nullptr)
+			it->texture->flush();
+
 		std::vector<Renderer::Vertex> vxs;
 		vxs.resize(it->verts.size());
 
@@ -587,8 +940,114 @@ std::string tryFastBidi(const std::string& text)
     return ret;
 }
 
+Font::LayoutKey::LayoutKey(const Font* _font, LayoutKind _kind, const std::string& _text, float _width, float _lineSpacing, Alignment _alignment, const Vector2f& _offset)
+	: font(_font), kind(_kind), text(_text), width(_width), lineSpacing(_lineSpacing), alignment(_alignment), offset(_offset)
+{
+	maxGlyphHeight = font->mMaxGlyphHeight;
+	generation = sLayoutGeneration;
+	rtl = (kind == LAYOUT_BUILD && EsLocale::isRTL());
+}
+
+bool Font::LayoutKey::operator==(const LayoutKey& other) const
+{
+	return font == other.font && kind == other.kind && width == other.width && lineSpacing == other.lineSpacing && alignment == other.alignment &&
+		offset == other.offset && maxGlyphHeight == other.maxGlyphHeight && generation == other.generation && rtl == other.rtl && text == other.text;
+}
+
+size_t Font::LayoutKeyHash::operator()(const LayoutKey& key) const
+{
+	size_t hash = std::hash<std::string>()(key.text);
+	hash ^= std::hash<const void*>()(key.font) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<float>()(key.width) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	hash ^= (size_t)key.kind + (size_t)key.alignment * 4 + (size_t)key.maxGlyphHeight * 16;
+	return hash;
+}
+
+const Font::LayoutEntry* Font::findLayout(const LayoutKey& key)
+{
+	auto it = sLayoutMap.find(key);
+	if (it == sLayoutMap.cend())
+	{
+		sLayoutStatistics.passes++;
+		return nullptr;
+	}
+
+	sLayoutStatistics.hits++;
+
+	// most recently used first
+	if (it->second != sLayoutList.begin())
+		sLayoutList.splice(sLayoutList.begin(), sLayoutList, it->second);
+
+	return &(*it->second);
+}
+
+const Font::LayoutEntry* Font::storeLayout(const LayoutKey& key, LayoutEntry& entry)
+{
+	entry.memUsage += sizeof(LayoutEntry) + key.text.size() * 2 + entry.wrappedText.size();
+
+	if (entry.textCache != nullptr)
+	{
+		for (auto& list : entry.textCache->vertexLists)
+			entry.memUsage += list.verts.size() * sizeof(Renderer::Vertex);
+
+		entry.memUsage += entry.textCache->imageSubstitutes.size() * sizeof(TextImageSubstitute);
+	}
+
+	// a huge text would evict everything else
+	if (entry.memUsage > LAYOUT_CACHE_MAX_SIZE / 8)
+		return nullptr;
+
+	while (!sLayoutList.empty() && (sLayoutMemUsage + entry.memUsage > LAYOUT_CACHE_MAX_SIZE || sLayoutList.size() >= LAYOUT_CACHE_MAX_ENTRIES))
+	{
+		auto it = sLayoutMap.find(*sLayoutList.back().key);
+		sLayoutMemUsage -= sLayoutList.back().memUsage;
+		sLayoutList.pop_back();
+		sLayoutMap.erase(it);
+	}
+
+	auto inserted = sLayoutMap.insert(std::make_pair(key, sLayoutList.end()));
+	if (!inserted.second)
+		return &(*inserted.first->second);
+
+	entry.key = &inserted.first->first;
+	sLayoutList.push_front(entry);
+	inserted.first->second = sLayoutList.begin();
+	sLayoutMemUsage += entry.memUsage;
+
+	return &sLayoutList.front();
+}
+
+void Font::removeLayouts(const Font* font)
+{
+	for (auto it = sLayoutList.begin(); it != sLayoutList.end(); )
+	{
+		if (it->key->font != font)
+		{
+			++it;
+			continue;
+		}
+
+		sLayoutMemUsage -= it->memUsage;
+		sLayoutMap.erase(*it->key);
+		it = sLayoutList.erase(it);
+	}
+}
+
+Font::LayoutStatistics Font::getLayoutStatistics()
+{
+	LayoutStatistics stats = sLayoutStatistics;
+	sLayoutStatistics = { 0, 0 };
+	return stats;
+}
+
 Vector2f Font::sizeText(std::string text, float lineSpacing)
 {
+	LayoutKey key(this, LAYOUT_SIZE, text, 0.0f, lineSpacing);
+
+	const LayoutEntry* cached = findLayout(key);
+	if (cached != nullptr)
+		return cached->size;
+
 	float lineWidth = 0.0f;
 	float highestWidth = 0.0f;
 
@@ -624,7 +1083,11 @@ Vector2f Font::sizeText(std::string text, float lineSpacing)
 	if(lineWidth > highestWidth)
 		highestWidth = lineWidth;
 
-	return Vector2f(highestWidth, y);
+	LayoutEntry entry;
+	entry.size = Vector2f(highestWidth, y);
+	storeLayout(key, entry);
+
+	return entry.size;
 }
 
 float Font::getHeight(float lineSpacing) const
@@ -650,6 +1113,12 @@ static inline bool isWhiteSpace(unsigned int c)
 // Breaks up a normal string with newlines to make it fit xLen
 std::string Font::wrapText(std::string text, float maxWidth)
 {
+	LayoutKey key(this, LAYOUT_WRAP, text, maxWidth);
+
+	const LayoutEntry* cached = findLayout(key);
+	if (cached != nullptr)
+		return cached->wrappedText;
+
 	std::string out;
 
 	int lastCursor = 0;
@@ -694,6 +1163,10 @@ std::string Font::wrapText(std::string text, float maxWidth)
 		}
 	}
 
+	LayoutEntry entry;
+	entry.wrappedText = out;
+	storeLayout(key, entry);
+
 	return out;
 }
 
@@ -768,8 +1241,34 @@ float Font::getNewlineStartOffset(const std::string& text, const unsigned int& c
 	}
 }
 
-TextCache* Font::buildTextCache(const std::string& _text, Vector2f offset, unsigned int color, float xLen, Alignment alignment, float lineSpacing)
+TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsigned int color, float xLen, Alignment alignment, float lineSpacing)
+{
+	LayoutKey key(this, LAYOUT_BUILD, text, xLen, lineSpacing, alignment, offset);
+
+	std::shared_ptr<TextCache> layout;
+
+	const LayoutEntry* cached = findLayout(key);
+	if (cached != nullptr)
+		layout = cached->textCache;
+	else
+	{
+		LayoutEntry entry;
+		entry.textCache = std::shared_ptr<TextCache>(layoutText(text, offset, xLen, alignment, lineSpacing));
+		storeLayout(key, entry);
+
+		layout = entry.textCache;
+	}
+
+	TextCache* cache = new TextCache(*layout);
+	cache->setColor(color);
+	return cache;
+}
+
+// Decodes, measures & places the glyphs of a text, in white
+TextCache* Font::layoutText(const std::string& _text, Vector2f offset, float xLen, Alignment alignment, float lineSpacing)
 {
+	const unsigned int color = 0xFFFFFFFF;
+
 	float x = offset[0] + (xLen != 0 ? getNewlineStartOffset(_text, 0, xLen, alignment) : 0);
 	
 	float yTop = getGlyph('S')->bearing.y();
@@ -949,6 +1448,7 @@ TextCache* Font::buildTextCache(const std::string& _text, Vector2f offset, unsig
 		TextCache::VertexList& vertList = cache->vertexLists.at(i);
 
 		vertList.textureIdPtr = &it->first->textureId;
+		vertList.texture = it->first;
 		vertList.verts = it->second;
 		i++;
 	}
@@ -1027,6 +1527,7 @@ void Font::OnThemeChanged()
 	};
 
 	substituableChars = defaultMap;
+	sLayoutGeneration++;
 
 	auto paths = ResourceManager::getInstance()->getResourcePaths();
 	std::reverse(paths.begin(), paths.end());
@@ -9,6 +9,9 @@
 #include "ThemeData.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 class TextCache;
@@ -75,6 +78,20 @@ public:
 	size_t getMemUsage() const; // returns an approximation of VRAM used by this font's texture (in bytes)
 	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by font textures (in bytes)
 
+	// Rasterizes the characters of an UTF-8 text in a background thread for all the fonts, and the ones created later.
+	// The glyphs are added to the fonts by processPrewarmedGlyphs(), called once per frame.
+	static void prewarm(const std::string& text);
+	static void processPrewarmedGlyphs();
+
+	struct LayoutStatistics
+	{
+		unsigned int passes; // texts decoded & measured
+		unsigned int hits; // results reused from the layout cache
+	};
+
+	// Layout work since the last call
+	static LayoutStatistics getLayoutStatistics();
+
 private:
 	static FT_Library sLibrary;
 	static std::map< std::pair<std::string, int>, std::weak_ptr<Font> > sFontMap;
@@ -90,15 +107,35 @@ private:
 		Vector2i writePos;
 		int rowHeight;
 
-		FontTexture();
+		FontTexture(const Vector2i& size);
 		~FontTexture();
 		bool findEmpty(const Vector2i& size, Vector2i& cursor_out);
 
 		// you must call initTexture() after creating a FontTexture to get a textureId
 		void initTexture(); // initializes the OpenGL texture according to this FontTexture's settings, updating textureId
 		void deinitTexture(); // deinitializes the OpenGL texture if any exists, is automatically called in the destructor
+
+		// Glyphs are written to a copy of the texture in RAM, and the changed rows are uploaded at once before drawing
+		void write(const Vector2i& cursor, const Vector2i& size, const unsigned char* data, int pitch);
+		void flush();
+
+	private:
+		std::vector<unsigned char> pixels;
+		int dirtyTop;
+		int dirtyBottom;
+	};
+
+	// Textures shared by all the sizes of a font file, so texts of different sizes can be drawn in the same batch
+	struct FontAtlas
+	{
+		~FontAtlas();
+		size_t getMemUsage() const;
+
+		std::vector<FontTexture*> textures;
 	};
 
+	static std::map< std::string, std::weak_ptr<FontAtlas> > sAtlasMap;
+
 	struct FontFace
 	{
 		const ResourceData data;
@@ -110,7 +147,7 @@ private:
 
 	void rebuildTextures();
 
-	std::vector<FontTexture*> mTextures;
+	std::shared_ptr<FontAtlas> mAtlas;
 
 	void getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out);
 
@@ -130,12 +167,70 @@ private:
 
 		Vector2i cursor;
 		Vector2i glyphSize;
+
+		bool prewarmed; // not used yet, so not counted in the font height
+	};
+
+	// Open addressing hash table of the glyphs by character, owns the glyphs
+	class GlyphTable
+	{
+	public:
+		GlyphTable();
+		~GlyphTable();
+
+		inline Glyph* find(unsigned int id) const
+		{
+			for (size_t i = hash(id); ; i = (i + 1) & mMask)
+			{
+				const Slot& slot = mSlots[i];
+				if (slot.glyph == nullptr || slot.id == id)
+					return slot.glyph;
+			}
+		}
+
+		void insert(unsigned int id, Glyph* glyph);
+
+	private:
+		struct Slot
+		{
+			unsigned int id;
+			Glyph* glyph;
+		};
+
+		inline size_t hash(unsigned int id) const { return (id * 2654435761u) & mMask; }
+		void grow();
+
+		std::vector<Slot> mSlots;
+		size_t mMask;
+		size_t mCount;
 	};
 
-	Glyph* mGlyphCacheArray[255]; // used to cache 255 first chars
-	std::map<unsigned int, Glyph*> mGlyphMap;
+	GlyphTable mGlyphs;
 
 	Glyph* getGlyph(unsigned int id);
+	Glyph* addGlyph(unsigned int id, const Vector2i& glyphSize, const Vector2f& advance, const Vector2f& bearing, const unsigned char* bitmap, int pitch, bool prewarmed = false);
+
+	struct PrewarmedGlyph
+	{
+		unsigned int id;
+		Vector2i size;
+		Vector2f advance;
+		Vector2f bearing;
+		std::vector<unsigned char> bitmap;
+	};
+
+	struct PrewarmResult
+	{
+		std::weak_ptr<Font> font;
+		std::vector<PrewarmedGlyph> glyphs;
+	};
+
+	static void prewarmFont(const std::shared_ptr<Font>& font);
+	static void prewarmThread();
+
+	static std::vector<unsigned int> sPrewarmChars;
+	static std::vector<PrewarmResult> sPrewarmResults;
+	static std::mutex sPrewarmLock;
 
 	int mMaxGlyphHeight;
 	
@@ -145,6 +240,62 @@ private:
 
 	float getNewlineStartOffset(const std::string& text, const unsigned int& charStart, const float& xLen, const Alignment& alignment);
 
+	TextCache* layoutText(const std::string& text, Vector2f offset, float xLen, Alignment alignment, float lineSpacing);
+
+	// Results of sizeText, wrapText & buildTextCache for the last texts, shared by all the fonts & evicted in LRU order.
+	// Glyphs never change once created, but a taller glyph changes the line height : it is part of the key.
+	enum LayoutKind
+	{
+		LAYOUT_SIZE,
+		LAYOUT_WRAP,
+		LAYOUT_BUILD
+	};
+
+	struct LayoutKey
+	{
+		LayoutKey(const Font* font, LayoutKind kind, const std::string& text, float width = 0.0f, float lineSpacing = 0.0f, Alignment alignment = ALIGN_LEFT, const Vector2f& offset = Vector2f::Zero());
+
+		bool operator==(const LayoutKey& other) const;
+
+		const Font*		font;
+		LayoutKind		kind;
+		std::string		text;
+		float			width;
+		float			lineSpacing;
+		Alignment		alignment;
+		Vector2f		offset;
+		int				maxGlyphHeight;
+		int				generation;
+		bool			rtl;
+	};
+
+	struct LayoutKeyHash
+	{
+		size_t operator()(const LayoutKey& key) const;
+	};
+
+	struct LayoutEntry
+	{
+		LayoutEntry() : key(nullptr), size(Vector2f::Zero()), memUsage(0) { }
+
+		const LayoutKey*			key;
+		Vector2f					size;
+		std::string					wrappedText;
+		std::shared_ptr<TextCache>	textCache; // built in white, copied & colored by buildTextCache
+
+		size_t						memUsage;
+	};
+
+	static const LayoutEntry* findLayout(const LayoutKey& key);
+	static const LayoutEntry* storeLayout(const LayoutKey& key, LayoutEntry& entry);
+	static void removeLayouts(const Font* font);
+
+	static std::list<LayoutEntry> sLayoutList; // most recently used first
+	static std::unordered_map<LayoutKey, std::list<LayoutEntry>::iterator, LayoutKeyHash> sLayoutMap;
+	static size_t sLayoutMemUsage;
+	static int sLayoutGeneration; // changes with the substitutable characters
+	static LayoutStatistics sLayoutStatistics;
+
 	friend TextCache;
 };
 
@@ -170,6 +321,7 @@ protected:
 	{
 		std::vector<Renderer::Vertex> verts;
 		unsigned int* textureIdPtr; // this is a pointer because the texture ID can change during deinit/reinit (when launching a game)
+		Font::FontTexture* texture;
 	};
 
 	std::vector<VertexList> vertexLists;
@@ -0,0 +1,176 @@
+#include "resources/TextureAtlas.h"
+
+#include "renderers/Renderer.h"
+#include "Log.h"
+#include "Settings.h"
+#include <algorithm>
+#include <string.h>
+
+#define ATLAS_PAGE_SIZE		1024
+#define ATLAS_MAX_PAGES		4
+#define ATLAS_MAX_ITEM_SIZE	128
+
+std::vector<TextureAtlas::Page> TextureAtlas::mPages;
+size_t TextureAtlas::mUsedSize = 0;
+std::mutex TextureAtlas::mLock;
+
+bool TextureAtlas::isEnabled()
+{
+	return Settings::getInstance()->getBool("TextureAtlas");
+}
+
+bool TextureAtlas::canAdd(size_t width, size_t height)
+{
+	return width > 0 && height > 0 && width <= ATLAS_MAX_ITEM_SIZE && height <= ATLAS_MAX_ITEM_SIZE && isEnabled();
+}
+
+bool TextureAtlas::Page::findEmpty(const Vector2i& size, Vector2i& cursor_out)
+{
+	// Reuse the room left by a removed picture, the smallest one that fits
+	int best = -1;
+	for (int i = 0; i < (int)freeSlots.size(); i++)
+	{
+		const Slot& slot = freeSlots[i];
+		if (slot.size.x() < size.x() || slot.size.y() < size.y())
+			continue;
+
+		if (best < 0 || slot.size.x() * slot.size.y() < freeSlots[best].size.x() * freeSlots[best].size.y())
+			best = i;
+	}
+
+	if (best >= 0)
+	{
+		Slot slot = freeSlots[best];
+		freeSlots.erase(freeSlots.begin() + best);
+
+		// Give back what is not used
+		if (slot.size.x() > size.x())
+			freeSlots.push_back(Slot(Vector2i(slot.pos.x() + size.x(), slot.pos.y()), Vector2i(slot.size.x() - size.x(), size.y())));
+
+		if (slot.size.y() > size.y())
+			freeSlots.push_back(Slot(Vector2i(slot.pos.x(), slot.pos.y() + size.y()), Vector2i(slot.size.x(), slot.size.y() - size.y())));
+
+		cursor_out = slot.pos;
+		return true;
+	}
+
+	if (writePos.x() + size.x() > ATLAS_PAGE_SIZE && writePos.y() + rowHeight + size.y() <= ATLAS_PAGE_SIZE)
+	{
+		// row full, but it should fit on the next row
+		writePos = Vector2i(0, writePos.y() + rowHeight);
+		rowHeight = 0;
+	}
+
+	if (writePos.x() + size.x() > ATLAS_PAGE_SIZE || writePos.y() + size.y() > ATLAS_PAGE_SIZE)
+		return false;
+
+	cursor_out = writePos;
+	writePos[0] += size.x();
+
+	if (size.y() > rowHeight)
+		rowHeight = size.y();
+
+	return true;
+}
+
+unsigned int TextureAtlas::add(const unsigned char* dataRGBA, size_t width, size_t height, bool linear, Vector2i& position, Vector4f& textureRect)
+{
+	if (dataRGBA == nullptr || !canAdd(width, height))
+		return 0;
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	// The picture with a 1px border on each side
+	const Vector2i slotSize((int)width + 2, (int)height + 2);
+
+	Page* page = nullptr;
+	Vector2i cursor;
+
+	for (auto& pg : mPages)
+	{
+		if (pg.linear == linear && pg.findEmpty(slotSize, cursor))
+		{
+			page = &pg;
+			break;
+		}
+	}
+
+	if (page == nullptr)
+	{
+		if (mPages.size() >= ATLAS_MAX_PAGES)
+			return 0;
+
+		unsigned int textureId = Renderer::createTexture(Renderer::Texture::RGBA, linear, false, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, nullptr);
+		if (textureId == 0)
+		{
+			LOG(LogError) << "TextureAtlas::add() failed to create texture " << ATLAS_PAGE_SIZE << "x" << ATLAS_PAGE_SIZE;
+			return 0;
+		}
+
+		LOG(LogDebug) << "TextureAtlas : new page " << ATLAS_PAGE_SIZE << "x" << ATLAS_PAGE_SIZE << (linear ? " (linear)" : "");
+
+		mPages.push_back(Page(textureId, linear));
+		page = &mPages.back();
+		page->findEmpty(slotSize, cursor);
+	}
+
+	// Copy the pixels & repeat the edges in the border
+	std::vector<unsigned char> padded(slotSize.x() * slotSize.y() * 4);
+	for (int y = 0; y < slotSize.y(); y++)
+	{
+		int sy = std::max(0, std::min(y - 1, (int)height - 1));
+		unsigned char* dst = &padded[y * slotSize.x() * 4];
+		const unsigned char* src = dataRGBA + sy * width * 4;
+
+		memcpy(dst, src, 4);
+		memcpy(dst + 4, src, width * 4);
+		memcpy(dst + (width + 1) * 4, src + (width - 1) * 4, 4);
+	}
+
+	Renderer::updateTexture(page->textureId, Renderer::Texture::RGBA, cursor.x(), cursor.y(), slotSize.x(), slotSize.y(), padded.data());
+
+	page->count++;
+	mUsedSize += width * height * 4;
+
+	position = Vector2i(cursor.x() + 1, cursor.y() + 1);
+	textureRect = Vector4f(
+		(float)position.x() / ATLAS_PAGE_SIZE, (float)position.y() / ATLAS_PAGE_SIZE,
+		(float)width / ATLAS_PAGE_SIZE, (float)height / ATLAS_PAGE_SIZE);
+
+	return page->textureId;
+}
+
+void TextureAtlas::remove(unsigned int textureId, const Vector2i& position, size_t width, size_t height)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	for (auto it = mPages.begin(); it != mPages.end(); ++it)
+	{
+		if (it->textureId != textureId)
+			continue;
+
+		mUsedSize -= width * height * 4;
+
+		it->count--;
+		if (it->count <= 0)
+		{
+			Renderer::destroyTexture(it->textureId);
+			mPages.erase(it);
+		}
+		else
+			it->freeSlots.push_back(Slot(Vector2i(position.x() - 1, position.y() - 1), Vector2i((int)width + 2, (int)height + 2)));
+
+		return;
+	}
+}
+
+size_t TextureAtlas::getPageCount()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	return mPages.size();
+}
+
+size_t TextureAtlas::getUsedSize()
+{
+	return mUsedSize;
+}
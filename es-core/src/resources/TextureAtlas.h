@@ -0,0 +1,55 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+#define ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+
+#include "math/Vector2i.h"
+#include "math/Vector4f.h"
+#include <mutex>
+#include <vector>
+
+// Shared GL textures holding small theme & UI pictures (icons, stars, help glyphs, indicators...).
+// Elements drawn from the same page don't need a texture switch, so the renderer can draw them in a single batch.
+// Pictures are packed in rows like the font glyphs, with a 1px border copied from their edges so linear filtering
+// never reads the neighbours.
+class TextureAtlas
+{
+public:
+	static bool isEnabled();
+	static bool canAdd(size_t width, size_t height);
+
+	// Copies RGBA pixels to a page. Returns the page texture and sets position & textureRect (x, y, w, h in texture coordinates), or returns 0 if there is no room
+	static unsigned int add(const unsigned char* dataRGBA, size_t width, size_t height, bool linear, Vector2i& position, Vector4f& textureRect);
+	static void remove(unsigned int textureId, const Vector2i& position, size_t width, size_t height);
+
+	static size_t getPageCount();
+	static size_t getUsedSize(); // bytes of the pictures stored in the pages
+
+private:
+	struct Slot
+	{
+		Slot(const Vector2i& _pos, const Vector2i& _size) : pos(_pos), size(_size) { }
+
+		Vector2i pos;
+		Vector2i size;
+	};
+
+	struct Page
+	{
+		Page(unsigned int id, bool isLinear) : textureId(id), linear(isLinear), writePos(Vector2i::Zero()), rowHeight(0), count(0) { }
+
+		bool findEmpty(const Vector2i& size, Vector2i& cursor_out);
+
+		unsigned int		textureId;
+		bool				linear;
+		Vector2i			writePos;
+		int					rowHeight;
+		int					count;
+		std::vector<Slot>	freeSlots;
+	};
+
+	static std::vector<Page>	mPages;
+	static size_t				mUsedSize;
+	static std::mutex			mLock;
+};
+
+#endif // ES_CORE_RESOURCES_TEXTURE_ATLAS_H
@@ -0,0 +1,540 @@
+#include "resources/TextureCompressor.h"
+
+#include "renderers/Renderer.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include "Paths.h"
+#include "Settings.h"
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_MAGIC		0x58545345 // "ESTX"
+#define CACHE_VERSION	1
+#define CACHE_MAX_AGE_DAYS	90
+
+// ETC1 intensity modifiers, indexed by table codeword then by pixel index (msb << 1 | lsb)
+static const int etc1Modifiers[8][4] =
+{
+	{  2,   8,  -2,   -8 },
+	{  5,  17,  -5,  -17 },
+	{  9,  29,  -9,  -29 },
+	{ 13,  42, -13,  -42 },
+	{ 18,  60, -18,  -60 },
+	{ 24,  80, -24,  -80 },
+	{ 33, 106, -33, -106 },
+	{ 47, 183, -47, -183 }
+};
+
+// EAC alpha modifiers, indexed by table then by the 3 bits pixel index
+static const int eacModifiers[16][8] =
+{
+	{ -3, -6,  -9, -15, 2, 5, 8, 14 },
+	{ -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5,  -8, -13, 1, 4, 7, 12 },
+	{ -2, -4,  -6, -13, 1, 3, 5, 12 },
+	{ -3, -6,  -8, -12, 2, 5, 7, 11 },
+	{ -3, -7,  -9, -11, 2, 6, 8, 10 },
+	{ -4, -7,  -8, -11, 3, 6, 7, 10 },
+	{ -3, -5,  -8, -11, 2, 4, 7, 10 },
+	{ -2, -6,  -8, -10, 1, 5, 7,  9 },
+	{ -2, -5,  -8, -10, 1, 4, 7,  9 },
+	{ -2, -4,  -8, -10, 1, 3, 7,  9 },
+	{ -2, -5,  -7, -10, 1, 4, 6,  9 },
+	{ -3, -4,  -7, -10, 2, 3, 6,  9 },
+	{ -1, -2,  -3, -10, 0, 1, 2,  9 },
+	{ -4, -6,  -8,  -9, 3, 5, 7,  8 },
+	{ -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+static inline int clamp255(int value)
+{
+	return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+// 4x4 block, pixels in ETC order : column by column (pixel i is at x = i / 4, y = i % 4)
+struct EtcBlock
+{
+	unsigned char rgba[16][4];
+};
+
+static void readBlock(const unsigned char* data, int channels, size_t width, size_t height, size_t bx, size_t by, EtcBlock& block)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		// Blocks crossing the border repeat the last row / column
+		size_t x = std::min(bx * 4 + i / 4, width - 1);
+		size_t y = std::min(by * 4 + i % 4, height - 1);
+
+		const unsigned char* pixel = data + (y * width + x) * channels;
+		block.rgba[i][0] = pixel[0];
+		block.rgba[i][1] = pixel[1];
+		block.rgba[i][2] = pixel[2];
+		block.rgba[i][3] = channels == 4 ? pixel[3] : 255;
+	}
+}
+
+static inline void writeBigEndian(unsigned char* dest, unsigned int hi, unsigned int lo)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		dest[i] = (hi >> (24 - i * 8)) & 0xFF;
+		dest[i + 4] = (lo >> (24 - i * 8)) & 0xFF;
+	}
+}
+
+// Finds the best table for the 8 pixels of a half block around a base color. Returns the squared error
+static int encodeSubblock(const EtcBlock& block, const int* pixels, const int base[3], int& bestTable, int bestIndexes[8])
+{
+	int bestError = INT_MAX;
+
+	for (int table = 0; table < 8; table++)
+	{
+		int error = 0;
+		int indexes[8];
+
+		for (int p = 0; p < 8 && error < bestError; p++)
+		{
+			const unsigned char* pixel = block.rgba[pixels[p]];
+			int pixelError = INT_MAX;
+
+			for (int m = 0; m < 4; m++)
+			{
+				int modifier = etc1Modifiers[table][m];
+				int dr = clamp255(base[0] + modifier) - pixel[0];
+				int dg = clamp255(base[1] + modifier) - pixel[1];
+				int db = clamp255(base[2] + modifier) - pixel[2];
+				int e = dr * dr + dg * dg + db * db;
+
+				if (e < pixelError)
+				{
+					pixelError = e;
+					indexes[p] = m;
+				}
+			}
+
+			error += pixelError;
+		}
+
+		if (error < bestError)
+		{
+			bestError = error;
+			bestTable = table;
+			memcpy(bestIndexes, indexes, sizeof(indexes));
+		}
+	}
+
+	return bestError;
+}
+
+static void averageColor(const EtcBlock& block, const int* pixels, int avg[3])
+{
+	for (int c = 0; c < 3; c++)
+	{
+		int sum = 0;
+		for (int p = 0; p < 8; p++)
+			sum += block.rgba[pixels[p]][c];
+
+		avg[c] = (sum + 4) / 8;
+	}
+}
+
+static void encodeColorBlock(const EtcBlock& block, unsigned char* dest)
+{
+	static const int subblocks[2][2][8] =
+	{
+		{ { 0, 1, 2, 3, 4, 5, 6, 7 }, { 8, 9, 10, 11, 12, 13, 14, 15 } },	// flip 0 : left & right halves
+		{ { 0, 1, 4, 5, 8, 9, 12, 13 }, { 2, 3, 6, 7, 10, 11, 14, 15 } }	// flip 1 : top & bottom halves
+	};
+
+	int bestError = INT_MAX;
+	unsigned int bestHi = 0, bestLo = 0;
+
+	for (int flip = 0; flip < 2; flip++)
+	{
+		int avg[2][3];
+		averageColor(block, subblocks[flip][0], avg[0]);
+		averageColor(block, subblocks[flip][1], avg[1]);
+
+		for (int diff = 0; diff < 2; diff++)
+		{
+			int codes[2][3];
+			int colors[2][3];
+
+			for (int c = 0; c < 3; c++)
+			{
+				if (diff)
+				{
+					// 5 bits base color, the second one is a 3 bits signed delta
+					codes[0][c] = (avg[0][c] * 31 + 127) / 255;
+					codes[1][c] = codes[0][c] + std::max(-4, std::min(3, (avg[1][c] * 31 + 127) / 255 - codes[0][c]));
+					codes[1][c] = std::max(0, std::min(31, codes[1][c]));
+
+					for (int s = 0; s < 2; s++)
+						colors[s][c] = (codes[s][c] << 3) | (codes[s][c] >> 2);
+				}
+				else
+				{
+					for (int s = 0; s < 2; s++)
+					{
+						codes[s][c] = (avg[s][c] + 8) / 17;
+						colors[s][c] = codes[s][c] * 17;
+					}
+				}
+			}
+
+			int tables[2];
+			int indexes[2][8];
+			int error = encodeSubblock(block, subblocks[flip][0], colors[0], tables[0], indexes[0]);
+			if (error >= bestError)
+				continue;
+
+			error += encodeSubblock(block, subblocks[flip][1], colors[1], tables[1], indexes[1]);
+			if (error >= bestError)
+				continue;
+
+			unsigned int hi;
+			if (diff)
+			{
+				hi = (codes[0][0] << 27) | (((codes[1][0] - codes[0][0]) & 7) << 24) |
+					(codes[0][1] << 19) | (((codes[1][1] - codes[0][1]) & 7) << 16) |
+					(codes[0][2] << 11) | (((codes[1][2] - codes[0][2]) & 7) << 8);
+			}
+			else
+			{
+				hi = (codes[0][0] << 28) | (codes[1][0] << 24) |
+					(codes[0][1] << 20) | (codes[1][1] << 16) |
+					(codes[0][2] << 12) | (codes[1][2] << 8);
+			}
+
+			hi |= (tables[0] << 5) | (tables[1] << 2) | (diff << 1) | flip;
+
+			unsigned int lo = 0;
+			for (int s = 0; s < 2; s++)
+			{
+				for (int p = 0; p < 8; p++)
+				{
+					int pixel = subblocks[flip][s][p];
+					int index = indexes[s][p];
+
+					lo |= ((index >> 1) << (pixel + 16)) | ((index & 1) << pixel);
+				}
+			}
+
+			bestError = error;
+			bestHi = hi;
+			bestLo = lo;
+		}
+	}
+
+	writeBigEndian(dest, bestHi, bestLo);
+}
+
+static void encodeAlphaBlock(const EtcBlock& block, unsigned char* dest)
+{
+	int minAlpha = 255, maxAlpha = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		minAlpha = std::min(minAlpha, (int)block.rgba[i][3]);
+		maxAlpha = std::max(maxAlpha, (int)block.rgba[i][3]);
+	}
+
+	int bestError = INT_MAX;
+	int bestBase = minAlpha, bestMultiplier = 1, bestTable = 13;
+	int bestIndexes[16] = { 0 };
+
+	if (minAlpha == maxAlpha)
+	{
+		// Table 13 has a 0 modifier
+		for (int i = 0; i < 16; i++)
+			bestIndexes[i] = 4;
+	}
+	else
+	{
+		int base = (minAlpha + maxAlpha + 1) / 2;
+
+		for (int table = 0; table < 16 && bestError > 0; table++)
+		{
+			int range = eacModifiers[table][7] - eacModifiers[table][3];
+			int multiplier = std::max(1, std::min(15, (maxAlpha - minAlpha + range - 1) / range));
+
+			for (int m = std::max(1, multiplier - 1); m <= std::min(15, multiplier + 1); m++)
+			{
+				int error = 0;
+				int indexes[16];
+
+				for (int i = 0; i < 16 && error < bestError; i++)
+				{
+					int pixelError = INT_MAX;
+					for (int idx = 0; idx < 8; idx++)
+					{
+						int e = clamp255(base + eacModifiers[table][idx] * m) - block.rgba[i][3];
+						e *= e;
+
+						if (e < pixelError)
+						{
+							pixelError = e;
+							indexes[i] = idx;
+						}
+					}
+
+					error += pixelError;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					bestBase = base;
+					bestMultiplier = m;
+					bestTable = table;
+					memcpy(bestIndexes, indexes, sizeof(indexes));
+				}
+			}
+		}
+	}
+
+	unsigned long long bits = ((unsigned long long)bestBase << 56) | ((unsigned long long)bestMultiplier << 52) | ((unsigned long long)bestTable << 48);
+	for (int i = 0; i < 16; i++)
+		bits |= (unsigned long long)bestIndexes[i] << (45 - i * 3);
+
+	writeBigEndian(dest, (unsigned int)(bits >> 32), (unsigned int)(bits & 0xFFFFFFFF));
+}
+
+static bool hasTransparency(const unsigned char* data, int channels, size_t width, size_t height)
+{
+	if (channels != 4)
+		return false;
+
+	size_t count = width * height;
+	for (size_t i = 0; i < count; i++)
+		if (data[i * 4 + 3] != 255)
+			return true;
+
+	return false;
+}
+
+bool TextureCompressor::isEnabled()
+{
+	if (!Settings::getInstance()->getBool("CompressTextures"))
+		return false;
+
+	return Renderer::supportsTexture(Renderer::Texture::ETC1);
+}
+
+size_t TextureCompressor::getDataSize(TextureFormat format, size_t width, size_t height)
+{
+	size_t blocks = ((width + 3) / 4) * ((height + 3) / 4);
+
+	if (format == ETC1)
+		return blocks * 8;
+
+	if (format == ETC2)
+		return blocks * 16;
+
+	return 0;
+}
+
+unsigned char* TextureCompressor::compress(const unsigned char* data, int channels, size_t width, size_t height, TextureFormat& format, size_t& size)
+{
+	if (data == nullptr || width == 0 || height == 0 || (channels != 3 && channels != 4))
+		return nullptr;
+
+	format = hasTransparency(data, channels, width, height) ? ETC2 : ETC1;
+
+	// Images with transparency stay uncompressed when ETC2 can't be used
+	if (format == ETC2 && !Renderer::supportsTexture(Renderer::Texture::ETC2_RGBA))
+		return nullptr;
+
+	size = getDataSize(format, width, height);
+
+	unsigned char* ret = (unsigned char*)malloc(size);
+	if (ret == nullptr)
+		return nullptr;
+
+	unsigned char* dest = ret;
+	EtcBlock block;
+
+	for (size_t by = 0; by < (height + 3) / 4; by++)
+	{
+		for (size_t bx = 0; bx < (width + 3) / 4; bx++)
+		{
+			readBlock(data, channels, width, height, bx, by, block);
+
+			if (format == ETC2)
+			{
+				encodeAlphaBlock(block, dest);
+				dest += 8;
+			}
+
+			// Never uses the ETC2 overflow modes, so the same block is valid ETC1 & ETC2 RGB data
+			encodeColorBlock(block, dest);
+			dest += 8;
+		}
+	}
+
+	return ret;
+}
+
+std::string TextureCompressor::getCacheKey(const std::string& path, MaxSizeInfo maxSize)
+{
+	unsigned long long size = 0;
+	time_t time = 0;
+
+	if (!Utils::FileSystem::getFileSizeAndModificationTime(path, &size, &time))
+		return "";
+
+	return path + "|" + std::to_string(size) + "|" + std::to_string((long long)time) + "|" +
+		std::to_string((int)maxSize.x()) + "x" + std::to_string((int)maxSize.y()) + (maxSize.externalZoom() ? "z" : "");
+}
+
+std::string TextureCompressor::getCachePath(const std::string& key)
+{
+	// FNV-1a
+	unsigned long long hash = 14695981039346656037ULL;
+	for (auto c : key)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ULL;
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.etc", hash);
+
+	return Paths::getUserEmulationStationPath() + "/cache/textures/" + name;
+}
+
+void TextureCompressor::sweepCache(const std::atomic<bool>* cancel)
+{
+	std::string path = Paths::getUserEmulationStationPath() + "/cache/textures";
+	if (!Utils::FileSystem::isDirectory(path))
+		return;
+
+	// Keys hold the source modification time : entries of replaced medias are never read again
+	unsigned long long maxSize = (unsigned long long)std::max(0, Settings::getInstance()->getInt("TextureCacheSize")) * 1024 * 1024;
+
+	auto freed = Utils::FileSystem::trimCacheFolder(path, CACHE_MAX_AGE_DAYS, maxSize, cancel);
+	if (freed > 0)
+	{
+		LOG(LogInfo) << "TextureCompressor : " << (freed / 1024) << "KB of unused textures removed from the cache";
+	}
+}
+
+template<typename T> static bool readValue(FILE* file, T& value)
+{
+	return fread(&value, sizeof(T), 1, file) == 1;
+}
+
+template<typename T> static void writeValue(std::string& buffer, T value)
+{
+	buffer.append((const char*)&value, sizeof(T));
+}
+
+unsigned char* TextureCompressor::loadFromCache(const std::string& key, CompressedTextureInfo& info, size_t& size)
+{
+	if (key.empty())
+		return nullptr;
+
+	std::string path = getCachePath(key);
+
+#ifdef WIN32
+	FILE* file = _wfopen(Utils::String::convertToWideString(path).c_str(), L"rb");
+#else
+	FILE* file = fopen(path.c_str(), "rb");
+#endif
+	if (file == nullptr)
+		return nullptr;
+
+	unsigned char* ret = nullptr;
+
+	unsigned int magic = 0, version = 0, keySize = 0;
+	if (readValue(file, magic) && magic == CACHE_MAGIC && readValue(file, version) && version == CACHE_VERSION && readValue(file, keySize) && keySize == key.size())
+	{
+		std::string storedKey(keySize, 0);
+
+		unsigned char format = 0;
+		unsigned int width = 0, height = 0, dataSize = 0;
+		int sizes[4];
+
+		if (fread(&storedKey[0], 1, keySize, file) == keySize && storedKey == key &&
+			readValue(file, format) && readValue(file, width) && readValue(file, height) &&
+			readValue(file, info.sourceWidth) && readValue(file, info.sourceHeight) &&
+			fread(sizes, sizeof(int), 4, file) == 4 && readValue(file, dataSize) &&
+			(format == ETC1 || format == ETC2) && dataSize == getDataSize((TextureFormat)format, width, height))
+		{
+			ret = (unsigned char*)malloc(dataSize);
+			if (ret != nullptr && fread(ret, 1, dataSize, file) != dataSize)
+			{
+				free(ret);
+				ret = nullptr;
+			}
+
+			info.format = (TextureFormat)format;
+			info.width = width;
+			info.height = height;
+			info.baseSize = Vector2i(sizes[0], sizes[1]);
+			info.packedSize = Vector2i(sizes[2], sizes[3]);
+			size = dataSize;
+		}
+	}
+
+	fclose(file);
+	return ret;
+}
+
+bool TextureCompressor::saveToCache(const std::string& key, const CompressedTextureInfo& info, const unsigned char* data, size_t size)
+{
+	if (key.empty() || data == nullptr)
+		return false;
+
+	std::string buffer;
+	writeValue<unsigned int>(buffer, CACHE_MAGIC);
+	writeValue<unsigned int>(buffer, CACHE_VERSION);
+	writeValue<unsigned int>(buffer, (unsigned int)key.size());
+	buffer.append(key);
+	writeValue<unsigned char>(buffer, (unsigned char)info.format);
+	writeValue<unsigned int>(buffer, (unsigned int)info.width);
+	writeValue<unsigned int>(buffer, (unsigned int)info.height);
+	writeValue<float>(buffer, info.sourceWidth);
+	writeValue<float>(buffer, info.sourceHeight);
+	writeValue<int>(buffer, info.baseSize.x());
+	writeValue<int>(buffer, info.baseSize.y());
+	writeValue<int>(buffer, info.packedSize.x());
+	writeValue<int>(buffer, info.packedSize.y());
+	writeValue<unsigned int>(buffer, (unsigned int)size);
+
+	std::string path = getCachePath(key);
+	std::string tmpPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+
+#ifdef WIN32
+	FILE* file = _wfopen(Utils::String::convertToWideString(tmpPath).c_str(), L"wb");
+#else
+	FILE* file = fopen(tmpPath.c_str(), "wb");
+#endif
+	if (file == nullptr)
+		return false;
+
+	bool ret = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && fwrite(data, 1, size, file) == size;
+	ret = (fclose(file) == 0) && ret;
+
+	if (ret)
+	{
+		// Loader threads can compress the same file, each one writes its own temporary file : the last complete file wins
+		remove(path.c_str());
+		ret = rename(tmpPath.c_str(), path.c_str()) == 0;
+	}
+
+	if (!ret)
+	{
+		LOG(LogWarning) << "TextureCompressor : unable to write " << path;
+		remove(tmpPath.c_str());
+	}
+
+	return ret;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_TEXTURE_COMPRESSOR_H
+#define ES_CORE_RESOURCES_TEXTURE_COMPRESSOR_H
+
+#include <atomic>
+#include <string>
+#include "math/Vector2i.h"
+#include "resources/TextureData.h"
+
+struct CompressedTextureInfo
+{
+	TextureFormat	format;
+	size_t			width;
+	size_t			height;
+	float			sourceWidth;
+	float			sourceHeight;
+	Vector2i		baseSize;
+	Vector2i		packedSize;
+};
+
+// Software ETC1 / ETC2 encoder & on-disk cache of the transcoded textures.
+// Opaque images are stored as ETC1 blocks (4 bits per pixel, also valid ETC2 RGB8 data), images with transparency as ETC2 RGBA8 with EAC alpha (8 bits per pixel).
+// Cache entries are keyed by source path, modification time, file size & requested size, so the image is only transcoded once.
+class TextureCompressor
+{
+public:
+	// The CompressTextures setting is on and the renderer can upload the compressed formats
+	static bool isEnabled();
+
+	// Encodes RGBA32 or RGB24 pixels. Returns a malloc'ed buffer, or nullptr if the renderer can't use the needed format
+	static unsigned char* compress(const unsigned char* data, int channels, size_t width, size_t height, TextureFormat& format, size_t& size);
+
+	static size_t getDataSize(TextureFormat format, size_t width, size_t height);
+
+	static std::string getCacheKey(const std::string& path, MaxSizeInfo maxSize);
+	static unsigned char* loadFromCache(const std::string& key, CompressedTextureInfo& info, size_t& size);
+	static bool saveToCache(const std::string& key, const CompressedTextureInfo& info, const unsigned char* data, size_t size);
+
+	// Removes the entries unused for months, then the oldest ones until the cache fits in "TextureCacheSize" MB. Meant for a background thread
+	static void sweepCache(const std::atomic<bool>* cancel = nullptr);
+
+private:
+	static std::string getCachePath(const std::string& key);
+};
+
+#endif // ES_CORE_RESOURCES_TEXTURE_COMPRESSOR_H
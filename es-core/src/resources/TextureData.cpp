@@ -3,8 +3,12 @@
 #include "math/Misc.h"
 #include "renderers/Renderer.h"
 #include "resources/ResourceManager.h"
+#include "resources/TextureAtlas.h"
+#include "resources/TextureCompressor.h"
+#include "resources/ThumbnailCache.h"
 #include "ImageIO.h"
 #include "Log.h"
+#include "Profiler.h"
 #include <nanosvg/nanosvg.h>
 #include <nanosvg/nanosvgrast.h>
 #include <string.h>
@@ -20,12 +24,17 @@
 
 #define OPTIMIZEVRAM Settings::getInstance()->getBool("OptimizeVRAM")
 
-TextureData::TextureData(bool tile, bool linear) : mTile(tile), mLinear(linear), mTextureID(0), mTextureData(nullptr), mTextureFormat(RGBA32), mScalable(false),
+std::atomic<size_t> TextureData::sTotalRAMUsage(0);
+std::atomic<size_t> TextureData::sTotalVRAMUsage(0);
+
+TextureData::TextureData(bool tile, bool linear) : mTile(tile), mLinear(linear), mTextureID(0), mTextureData(nullptr), mTextureFormat(RGBA32), mTextureDataSize(0), mScalable(false),
 									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f),
-									  mPackedSize(Vector2i(0, 0)), mBaseSize(Vector2i(0, 0))
+									  mPackedSize(Vector2i(0, 0)), mBaseSize(Vector2i(0, 0)), mInAtlas(false), mAtlasPosition(Vector2i(0, 0)), mTextureRect(0, 0, 1, 1),
+									  mRAMUsage(0), mVRAMUsage(0)
 {
 	mIsExternalDataRGBA = false;
 	mRequired = false;
+	mTextureClass = TEXTURE_CLASS_MEDIA;
 }
 
 TextureData::~TextureData()
@@ -38,6 +47,9 @@ void TextureData::initFromPath(const std::string& path)
 {
 	// Just set the path. It will be loaded later
 	mPath = path;
+	// Embedded resources are part of the UI
+	if (!mPath.empty() && mPath[0] == ':')
+		mTextureClass = TEXTURE_CLASS_THEME;
 	// Only textures with paths are reloadable
 	mReloadable = true;
 }
@@ -153,6 +165,7 @@ bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length
 
     mTextureData = dataRGBA;
     mTextureFormat = RGBA32;
+	updateMemoryUsage();
 	return true;
 }
 
@@ -257,6 +270,7 @@ bool TextureData::initFromRGB24(unsigned char* dataRGB, size_t width, size_t hei
     mTextureFormat = RGB24;
     mWidth = width;
     mHeight = height;
+    updateMemoryUsage();
     return true;
 }
 
@@ -286,6 +300,7 @@ bool TextureData::initFromRGBA(unsigned char* dataRGBA, size_t width, size_t hei
     mTextureFormat = RGBA32;
 	mWidth = width;
 	mHeight = height;
+	updateMemoryUsage();
 	return true;
 }
 
@@ -301,6 +316,7 @@ bool TextureData::updateFromExternalRGBA(unsigned char* dataRGBA, size_t width,
     mTextureData = dataRGBA;
 	mWidth = width;
 	mHeight = height;
+	updateMemoryUsage();
 
     //if ((mTextureID == 0) && (mWidth != 0) && (mHeight != 0))
     //    mTextureID = Renderer::createTexture(Renderer::Texture::RGBA, mLinear, mTile, mWidth, mHeight, nullptr);
@@ -381,6 +397,115 @@ bool TextureData::loadFromCbz()
 	return retval;
 }
 
+bool TextureData::loadFromCompressedCache()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mTextureData || (mTextureID != 0))
+			return true;
+	}
+
+	CompressedTextureInfo info;
+	size_t size = 0;
+
+	unsigned char* data = TextureCompressor::loadFromCache(TextureCompressor::getCacheKey(mPath, mMaxSize), info, size);
+	if (data == nullptr)
+		return false;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	if (mTextureData || (mTextureID != 0))
+	{
+		free(data);
+		return true;
+	}
+
+	mTextureData = data;
+	mTextureDataSize = size;
+	mTextureFormat = info.format;
+	mWidth = info.width;
+	mHeight = info.height;
+	mSourceWidth = info.sourceWidth;
+	mSourceHeight = info.sourceHeight;
+	mBaseSize = info.baseSize;
+	mPackedSize = info.packedSize;
+	mScalable = false;
+	updateMemoryUsage();
+	return true;
+}
+
+bool TextureData::loadFromThumbnailCache()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mTextureData || (mTextureID != 0))
+			return true;
+	}
+
+	int channels;
+	size_t width, height;
+	Vector2i baseSize;
+
+	unsigned char* data = ThumbnailCache::load(mPath, mMaxSize, channels, width, height, baseSize);
+	if (data == nullptr)
+		return false;
+
+	mBaseSize = baseSize;
+	mPackedSize = Vector2i(width, height);
+	mSourceWidth = (float) width;
+	mSourceHeight = (float) height;
+	mScalable = false;
+
+	if (channels == 3)
+		return initFromRGB24(data, width, height, false);
+
+	return initFromRGBA(data, width, height, false);
+}
+
+void TextureData::saveToThumbnailCache()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	if (mTextureData == nullptr || mIsExternalDataRGBA || (mTextureFormat != RGBA32 && mTextureFormat != RGB24))
+		return;
+
+	ThumbnailCache::save(mPath, mMaxSize, mTextureData, mTextureFormat == RGB24 ? 3 : 4, mWidth, mHeight, mBaseSize);
+}
+
+bool TextureData::compressTextureData(const std::string& cacheKey)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	if (mTextureData == nullptr || mIsExternalDataRGBA || (mTextureFormat != RGBA32 && mTextureFormat != RGB24))
+		return false;
+
+	TextureFormat format;
+	size_t size;
+
+	unsigned char* data = TextureCompressor::compress(mTextureData, mTextureFormat == RGB24 ? 3 : 4, mWidth, mHeight, format, size);
+	if (data == nullptr)
+		return false;
+
+	free(mTextureData);
+
+	mTextureData = data;
+	mTextureDataSize = size;
+	mTextureFormat = format;
+	updateMemoryUsage();
+
+	CompressedTextureInfo info;
+	info.format = format;
+	info.width = mWidth;
+	info.height = mHeight;
+	info.sourceWidth = mSourceWidth;
+	info.sourceHeight = mSourceHeight;
+	info.baseSize = mBaseSize;
+	info.packedSize = mPackedSize;
+
+	TextureCompressor::saveToCache(cacheKey, info, data, size);
+	return true;
+}
+
 bool TextureData::load(bool updateCache)
 {
 	bool retval = false;
@@ -392,6 +517,35 @@ bool TextureData::load(bool updateCache)
 
 		if (mPath.substr(mPath.size() - 4, std::string::npos) == ".cbz")
 			return loadFromCbz();
+
+		// Embedded resources & svg files are neither compressed nor cached
+		bool isMediaFile = mPath[0] != ':' && mPath.substr(mPath.size() - 4, std::string::npos) != ".svg";
+
+		std::string cacheKey;
+		if (isMediaFile && TextureCompressor::isEnabled())
+		{
+			if (loadFromCompressedCache())
+			{
+				if (updateCache)
+					ImageIO::updateImageCache(mPath, Utils::FileSystem::getFileSize(mPath), mBaseSize.x(), mBaseSize.y());
+
+				return true;
+			}
+
+			cacheKey = TextureCompressor::getCacheKey(mPath, mMaxSize);
+		}
+
+		bool useThumbnails = isMediaFile && !mMaxSize.empty() && ThumbnailCache::isEnabled();
+		if (useThumbnails && loadFromThumbnailCache())
+		{
+			if (!cacheKey.empty())
+				compressTextureData(cacheKey);
+
+			if (updateCache)
+				ImageIO::updateImageCache(mPath, Utils::FileSystem::getFileSize(mPath), mBaseSize.x(), mBaseSize.y());
+
+			return true;
+		}
 		
 		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
 		const ResourceData& data = rm->getFileData(mPath);
@@ -408,6 +562,13 @@ bool TextureData::load(bool updateCache)
 		else
 			retval = initImageFromMemory((const unsigned char*)data.ptr.get(), data.length);
 
+		// Only pictures that had to be scaled down are worth a thumbnail
+		if (retval && useThumbnails && mPackedSize != Vector2i(0, 0))
+			saveToThumbnailCache();
+
+		if (retval && !cacheKey.empty())
+			compressTextureData(cacheKey);
+
 		if (updateCache && retval)
 			ImageIO::updateImageCache(mPath, data.length, mBaseSize.x(), mBaseSize.y());
 	}
@@ -439,6 +600,27 @@ bool TextureData::uploadAndBind()
 			return false;
 		}
 
+		PROFILE_SCOPE("TextureData::upload");
+
+		if (mTextureFormat == ETC1 || mTextureFormat == ETC2)
+		{
+			Renderer::Texture::Type type = (mTextureFormat == ETC1 ? Renderer::Texture::ETC1 : Renderer::Texture::ETC2_RGBA);
+			mTextureID = Renderer::createCompressedTexture(type, mLinear, mTile, mWidth, mHeight, mTextureData, mTextureDataSize);
+			if (mTextureID == 0)
+				return false;
+
+			free(mTextureData);
+			mTextureData = nullptr;
+			updateMemoryUsage();
+			return true;
+		}
+
+		if (uploadToAtlas())
+		{
+			Renderer::bindTexture(mTextureID);
+			return true;
+		}
+
 		// Upload texture
         Renderer::Texture::Type format = Renderer::Texture::RGBA;
         if (mTextureFormat == RGB24)
@@ -453,6 +635,7 @@ bool TextureData::uploadAndBind()
 			free(mTextureData);
 
 		mTextureData = nullptr;
+		updateMemoryUsage();
 	}
 
 	return true;
@@ -463,11 +646,43 @@ void TextureData::releaseVRAM()
 	std::unique_lock<std::mutex> lock(mMutex);
 	if (mTextureID != 0)
 	{
-		Renderer::destroyTexture(mTextureID);
+		if (mInAtlas)
+			TextureAtlas::remove(mTextureID, mAtlasPosition, mWidth, mHeight);
+		else
+			Renderer::destroyTexture(mTextureID);
+
 		mTextureID = 0;
+		mInAtlas = false;
+		mTextureRect = Vector4f(0, 0, 1, 1);
+		updateMemoryUsage();
 	}
 }
 
+// Must be called with mMutex held. Small theme pictures go to a shared page instead of their own texture
+bool TextureData::uploadToAtlas()
+{
+	if (mTile || mIsExternalDataRGBA || mTextureFormat != RGBA32 || mTextureClass != TEXTURE_CLASS_THEME || !TextureAtlas::canAdd(mWidth, mHeight))
+		return false;
+
+	unsigned int textureId = TextureAtlas::add(mTextureData, mWidth, mHeight, mLinear, mAtlasPosition, mTextureRect);
+	if (textureId == 0)
+		return false;
+
+	mTextureID = textureId;
+	mInAtlas = true;
+
+	free(mTextureData);
+	mTextureData = nullptr;
+	updateMemoryUsage();
+	return true;
+}
+
+Vector4f TextureData::getTextureRect()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mTextureRect;
+}
+
 void TextureData::releaseRAM()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
@@ -476,6 +691,7 @@ void TextureData::releaseRAM()
 		free(mTextureData);
 
     mTextureData = nullptr;
+	updateMemoryUsage();
 }
 
 size_t TextureData::width()
@@ -534,11 +750,59 @@ void TextureData::setSourceSize(float width, float height)
 size_t TextureData::getVRAMUsage()
 {
 	if ((mTextureID != 0) || (mTextureData != nullptr))
-		return mWidth * mHeight * 4;
+		return getUploadedSize();
 	else
 		return 0;
 }
 
+size_t TextureData::getEstimatedVRAMUsage()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mWidth * mHeight * 4;
+}
+
+size_t TextureData::getUploadedSize()
+{
+	if (mTextureFormat == ETC1 || mTextureFormat == ETC2)
+		return mTextureDataSize;
+
+	// Drivers store RGB textures with 32 bits per pixel
+	return mWidth * mHeight * 4;
+}
+
+// Must be called with mMutex held, each time mTextureData or mTextureID changes
+void TextureData::updateMemoryUsage()
+{
+	size_t ram = 0;
+	if (mTextureData != nullptr && !mIsExternalDataRGBA)
+	{
+		switch (mTextureFormat)
+		{
+		case RGB24:
+			ram = mWidth * mHeight * 3;
+			break;
+		case RGB565:
+			ram = mWidth * mHeight * 2;
+			break;
+		case ETC1:
+		case ETC2:
+			ram = mTextureDataSize;
+			break;
+		default:
+			ram = mWidth * mHeight * 4;
+			break;
+		}
+	}
+
+	size_t vram = (mTextureID != 0 ? getUploadedSize() : 0);
+
+	sTotalRAMUsage += ram - mRAMUsage;
+	sTotalVRAMUsage += vram - mVRAMUsage;
+
+	mRAMUsage = ram;
+	mVRAMUsage = vram;
+}
+
 void TextureData::setMaxSize(MaxSizeInfo maxSize)
 {
 	if (!Settings::getInstance()->getBool("OptimizeVRAM"))
@@ -2,9 +2,11 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_H
 
+#include <atomic>
 #include <mutex>
 #include <string>
 #include "ImageIO.h"
+#include "math/Vector4f.h"
 
 class TextureResource;
 
@@ -17,6 +19,13 @@ enum TextureFormat
     ETC2
 };
 
+// Eviction order : game media are released first, theme & UI assets only when releasing media is not enough
+enum TextureClass
+{
+	TEXTURE_CLASS_MEDIA,
+	TEXTURE_CLASS_THEME
+};
+
 class TextureData
 {
 public:
@@ -36,6 +45,8 @@ public:
 	// Read the data into memory if necessary
 	bool load(bool updateCache = false);
 	bool loadFromCbz();
+	bool loadFromCompressedCache();
+	bool loadFromThumbnailCache();
 
 	bool isLoaded();
 
@@ -52,6 +63,13 @@ public:
 	// Get the amount of VRAM currenty used by this texture
 	size_t getVRAMUsage();
 
+	// Amount of VRAM the texture will use once loaded, from the size of its last load (0 if it was never loaded). Never loads it
+	size_t getEstimatedVRAMUsage();
+
+	// Bytes currently held by all textures, in RAM (decoded pixels waiting for upload) & in VRAM
+	static size_t getTotalRAMUsage() { return sTotalRAMUsage; }
+	static size_t getTotalVRAMUsage() { return sTotalVRAMUsage; }
+
 	size_t width();
 	size_t height();
 	float sourceWidth();
@@ -77,11 +95,27 @@ public:
 
 	bool updateFromExternalRGBA(unsigned char* dataRGBA, size_t width, size_t height);
 
+	void saveToThumbnailCache();
+
+	// Transcodes the decoded pixels to ETC1 / ETC2 & stores them in the compressed texture cache
+	bool compressTextureData(const std::string& cacheKey);
+
 	bool isRequired() { return mRequired; };
 	void setRequired(bool value) { mRequired = value; };
 
+	TextureClass getTextureClass() { return mTextureClass; };
+	void setTextureClass(TextureClass value) { mTextureClass = value; };
+
+	// Part of the GL texture used by this picture : (0, 0, 1, 1) unless it is packed in the texture atlas
+	Vector4f getTextureRect();
+
 private:
+	size_t getUploadedSize();
+	void updateMemoryUsage();
+	bool uploadToAtlas();
+
 	bool			mRequired;
+	TextureClass	mTextureClass;
 
 	std::mutex		mMutex;
 	bool			mTile;
@@ -90,6 +124,7 @@ private:
 	unsigned int	mTextureID;
 	unsigned char*	mTextureData;
     TextureFormat   mTextureFormat;
+	size_t			mTextureDataSize; // compressed formats only
 	size_t			mWidth;
 	size_t			mHeight;
 	float			mSourceWidth;
@@ -102,6 +137,16 @@ private:
 	Vector2i		mBaseSize;
 
 	bool			mIsExternalDataRGBA;
+
+	bool			mInAtlas;
+	Vector2i		mAtlasPosition;
+	Vector4f		mTextureRect;
+
+	size_t			mRAMUsage;
+	size_t			mVRAMUsage;
+
+	static std::atomic<size_t> sTotalRAMUsage;
+	static std::atomic<size_t> sTotalVRAMUsage;
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_H
@@ -4,9 +4,14 @@
 #include "resources/TextureResource.h"
 #include "Settings.h"
 #include "Log.h"
+#include "Window.h"
 #include <algorithm>
 
-TextureDataManager::TextureDataManager()
+// Once a budget is exceeded, textures are released until the usage falls under this percentage of it,
+// so the next loads don't trigger an eviction each
+#define LOW_WATER_MARK	85
+
+TextureDataManager::TextureDataManager() : mEvictionCount(0)
 {
 	unsigned char data[5 * 5 * 4];
 	mBlank = std::make_shared<TextureData>(false, false);
@@ -86,6 +91,41 @@ void TextureDataManager::cancelAsync(const TextureResource* key)
 		mLoader->remove(*(*it).second);
 }
 
+void TextureDataManager::prefetch(const TextureResource* key)
+{
+	std::shared_ptr<TextureData> tex;
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		auto it = mTextureLookup.find(key);
+		if (it == mTextureLookup.cend())
+			return;
+
+		tex = *(*it).second;
+	}
+
+	if (tex->isLoaded())
+		return;
+
+	// Prefetching must never push out what is displayed
+	size_t maxVRAM = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
+	size_t maxRAM = (size_t)Settings::getInstance()->getInt("MaxTextureRAM") * 1024 * 1024;
+	if (TextureResource::getTotalMemUsage() >= maxVRAM || (maxRAM != 0 && TextureData::getTotalRAMUsage() >= maxRAM))
+		return;
+
+	mLoader->load(tex, TextureLoader::LoadPriority::PREFETCH);
+}
+
+void TextureDataManager::cancelPrefetch(const TextureResource* key)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	auto it = mTextureLookup.find(key);
+	if (it != mTextureLookup.cend())
+		mLoader->remove(*(*it).second, true);
+}
+
 std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key, TextureLoadMode enableLoading)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
@@ -144,17 +184,6 @@ size_t TextureDataManager::getTotalSize()
 	return total;
 }
 
-size_t TextureDataManager::getCommittedSize()
-{
-	std::unique_lock<std::mutex> lock(mMutex);
-
-	size_t total = 0;
-	for (auto tex : mTextures)
-		total += tex->getVRAMUsage();
-
-	return total;
-}
-
 size_t TextureDataManager::getQueueSize()
 {
 	return mLoader->getQueueSize();
@@ -186,64 +215,85 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 	}
 
 	// Not loaded. Make sure there is room
-	size_t size = TextureResource::getTotalMemUsage();
-	size_t max_texture = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
+	reclaimMemory(tex);
 
-	if (size >= max_texture)
+	if (!block)
+		mLoader->load(tex);
+	else
 	{
-		LOG(LogDebug) << "Cleanup VRAM\tCurrent VRAM : " << std::to_string(size / 1024.0 / 1024.0).c_str() << " MB";
+		mLoader->remove(tex);
+		tex->load();
+	}
+}
 
-		std::unique_lock<std::mutex> lock(mMutex);
+void TextureDataManager::reclaimMemory(const std::shared_ptr<TextureData>& loading)
+{
+	// The VRAM budget covers uploaded textures plus the ones waiting in RAM or in the queue, as they will end up in VRAM.
+	// The RAM budget only covers decoded pixels which are not uploaded yet (prefetched textures mostly)
+	size_t maxVRAM = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
+	size_t maxRAM = (size_t)Settings::getInstance()->getInt("MaxTextureRAM") * 1024 * 1024;
+
+	size_t vram = TextureResource::getTotalMemUsage();
+	size_t ram = TextureData::getTotalRAMUsage();
+
+	if (vram < maxVRAM && (maxRAM == 0 || ram < maxRAM))
+		return;
+
+	size_t vramTarget = maxVRAM / 100 * LOW_WATER_MARK;
+	size_t ramTarget = (maxRAM == 0 ? ram : maxRAM / 100 * LOW_WATER_MARK);
+
+	LOG(LogDebug) << "Cleanup VRAM\tCurrent VRAM : " << std::to_string(vram / 1024.0 / 1024.0).c_str() << " MB, RAM : " << std::to_string(ram / 1024.0 / 1024.0).c_str() << " MB";
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	// Game media first, theme & UI assets only if releasing all media was not enough
+	for (int textureClass = TEXTURE_CLASS_MEDIA; textureClass <= TEXTURE_CLASS_THEME; textureClass++)
+	{
 		for (auto it = mTextures.crbegin(); it != mTextures.crend(); ++it)
 		{
-			if (size < max_texture)
+			bool vramPressure = vram > vramTarget;
+			if (!vramPressure && ram <= ramTarget)
 				break;
 
-			if ((*it) == tex)
+			const std::shared_ptr<TextureData>& data = *it;
+			if (data == loading || data->isRequired() || data->getTextureClass() != textureClass)
 				continue;
 
-			if ((*it)->isRequired())
+			// Only RAM is over budget : textures which are not holding decoded pixels can stay
+			if (!vramPressure && data->getTextureData() == nullptr)
 				continue;
 
-			bool changed = false;
+			bool released = false;
 
-			if ((*it)->isLoaded())
+			// It may be already in the loader queue. In this case it wouldn't have been using
+			// any VRAM yet but it will be. Remove it from the loader queue
+			if (mLoader->remove(data))
 			{
-				LOG(LogDebug) << "Cleanup VRAM\tReleased : " << (*it)->getPath().c_str();
-
-				size -= (*it)->getVRAMUsage();
-
-				(*it)->releaseVRAM();
-				(*it)->releaseRAM();
+				LOG(LogDebug) << "Cleanup VRAM\tRemoved from queue : " << data->getPath().c_str();
+				released = true;
 			}
 
-			// It may be already in the loader queue. In this case it wouldn't have been using
-			// any VRAM yet but it will be. Remove it from the loader queue
-			if (mLoader->remove(*it))
+			if (data->isLoaded())
 			{
-				LOG(LogDebug) << "Cleanup VRAM\tRemoved from queue : " << (*it)->getPath().c_str();
-				changed = true;
+				LOG(LogDebug) << "Cleanup VRAM\tReleased : " << data->getPath().c_str();
+
+				data->releaseVRAM();
+				data->releaseRAM();
+				released = true;
 			}
-			
-			if (changed)
+
+			if (released)
 			{
-				lock.unlock();
-				size = TextureResource::getTotalMemUsage();
-				lock.lock();
+				mEvictionCount++;
+
+				vram = TextureResource::getTotalMemUsage();
+				ram = TextureData::getTotalRAMUsage();
 			}
 		}
 	}
-
-	if (!block)
-		mLoader->load(tex);
-	else
-	{
-		mLoader->remove(tex);
-		tex->load();
-	}
 }
 
-TextureLoader::TextureLoader(TextureDataManager* mgr) : mManager(mgr), mExit(false)
+TextureLoader::TextureLoader(TextureDataManager* mgr) : mManager(mgr), mExit(false), mQueuedBytes(0)
 {
 	int num_threads = std::thread::hardware_concurrency() / 2;
 	if (num_threads == 0)
@@ -272,21 +322,32 @@ void TextureLoader::threadProc()
 	{		
 		// Wait for an event to say there is something in the queue
 		std::unique_lock<std::mutex> lock(mLoaderLock);
-		mEvent.wait(lock, [this]() { return !paused && (mExit || !mTextureDataQ.empty()); });
+		mEvent.wait(lock, [this]() { return !paused && (mExit || hasQueuedTextures()); });
 
 		if (mExit)
 			break;
 
-		if (!mTextureDataQ.empty())
+		std::shared_ptr<TextureData> textureData;
+		for (auto& queue : mTextureDataQ)
 		{
-			std::shared_ptr<TextureData> textureData = mTextureDataQ.front();
-			mTextureDataQ.pop_front();
+			if (queue.empty())
+				continue;
 
-			mProcessingTextureDataQ.push_back(textureData);
+			textureData = queue.front();
+			queue.pop_front();
+			break;
+		}
+
+		if (textureData)
+		{
+			auto tx = mQueueIndex.find(textureData.get());
+			mQueuedBytes -= tx->second.size;
+			mQueueIndex.erase(tx);
+			mProcessingTextureData.insert(textureData.get());
 
 			lock.unlock();
 
-			if (textureData && !textureData->isLoaded())
+			if (!textureData->isLoaded())
 			{
 				//LOG(LogDebug) << "TextureLoader::Thread\tLoading " << textureData->getPath().c_str();
 				std::this_thread::yield();
@@ -294,23 +355,35 @@ void TextureLoader::threadProc()
 				textureData->load(true);
 				//mManager->onTextureLoaded(textureData);				
 
-				lock.lock();
-				mProcessingTextureDataQ.remove(textureData);			
-				lock.unlock();
+				// Components waiting for it are drawn at the next frame
+				Window::invalidate();
 			}
 
+			lock.lock();
+			mProcessingTextureData.erase(textureData.get());
+			lock.unlock();
+
 			std::this_thread::yield();
 		}		
 	}
 }
 
+bool TextureLoader::hasQueuedTextures()
+{
+	return !mQueueIndex.empty();
+}
+
 bool TextureLoader::paused = false;
 
-void TextureLoader::load(std::shared_ptr<TextureData> textureData)
+void TextureLoader::load(std::shared_ptr<TextureData> textureData, LoadPriority priority)
 {
 //	if (paused)
 	//	return;
 
+	// Amount of video memory the texture will use once loaded. Not width() / height() : they would load the picture
+	// right here while a loader thread may be loading it. The actual usage is counted by the texture once load() returns
+	size_t size = textureData->getEstimatedVRAMUsage();
+
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
 	// Make sure it's not already loaded
@@ -318,45 +391,54 @@ void TextureLoader::load(std::shared_ptr<TextureData> textureData)
 		return;
 
 	// If is is currently loading, don't add again
-	if (std::find(mProcessingTextureDataQ.cbegin(), mProcessingTextureDataQ.cend(), textureData) != mProcessingTextureDataQ.cend())
+	if (mProcessingTextureData.find(textureData.get()) != mProcessingTextureData.cend())
 		return;
 
-	// Remove it from the queue if it is already there
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
-		mTextureDataQ.erase(tx);
+	auto& queue = mTextureDataQ[priority];
+
+	auto tx = mQueueIndex.find(textureData.get());
+	if (tx != mQueueIndex.cend())
+	{
+		// A prefetch hint does not lower the priority of a texture already requested for display
+		if (tx->second.priority < priority)
+			return;
 
-	// Put it on the start of the queue as we want the newly requested textures to load first
-	mTextureDataQ.push_front(textureData);
+		// Put it on the start of its queue as we want the newly requested textures to load first
+		queue.splice(queue.begin(), mTextureDataQ[tx->second.priority], tx->second.position);
+		tx->second.priority = priority;
+		tx->second.position = queue.begin();
+		return;
+	}
+
+	queue.push_front(textureData);
+	mQueueIndex[textureData.get()] = { priority, queue.begin(), size };
+	mQueuedBytes += size;
 	mEvent.notify_one();
 }
 
-bool TextureLoader::remove(std::shared_ptr<TextureData> textureData)
+bool TextureLoader::remove(std::shared_ptr<TextureData> textureData, bool prefetchOnly)
 {
 	// Just remove it from the queue so we don't attempt to load it
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
-	{
-		mTextureDataQ.erase(tx);
-		return true;
-	}
+	auto tx = mQueueIndex.find(textureData.get());
+	if (tx == mQueueIndex.cend())
+		return false;
 
-	return false;
+	if (prefetchOnly && tx->second.priority != LoadPriority::PREFETCH)
+		return false;
+
+	mTextureDataQ[tx->second.priority].erase(tx->second.position);
+	mQueuedBytes -= tx->second.size;
+	mQueueIndex.erase(tx);
+	return true;
 }
 
 size_t TextureLoader::getQueueSize()
 {
-	std::unique_lock<std::mutex> lock(mLoaderLock);
-
 	// Gets the amount of video memory that will be used once all textures in
 	// the queue are loaded
-	size_t mem = 0;
-	for (auto tex : mTextureDataQ)
-		mem += tex->width() * tex->height() * 4;
-
-	return mem;
+	return mQueuedBytes;
 }
 
 void TextureLoader::clearQueue()
@@ -364,7 +446,11 @@ void TextureLoader::clearQueue()
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
 	// Just abort any waiting texture
-	mTextureDataQ.clear();	
+	for (auto& queue : mTextureDataQ)
+		queue.clear();
+
+	mQueueIndex.clear();
+	mQueuedBytes = 0;
 }
 
 void TextureDataManager::clearQueue()
@@ -2,12 +2,15 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 
+#include <atomic>
 #include <condition_variable>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class TextureDataManager;
@@ -17,11 +20,20 @@ class TextureResource;
 class TextureLoader
 {
 public:
+	// Textures on screen are always loaded before the ones requested ahead of scrolling
+	enum LoadPriority : int
+	{
+		VISIBLE = 0,
+		PREFETCH = 1,
+		PRIORITY_COUNT = 2
+	};
+
 	TextureLoader(TextureDataManager* mgr);
 	~TextureLoader();
 
-	void load(std::shared_ptr<TextureData> textureData);
-	bool remove(std::shared_ptr<TextureData> textureData);
+	void load(std::shared_ptr<TextureData> textureData, LoadPriority priority = LoadPriority::VISIBLE);
+	// prefetchOnly keeps textures queued because they are on screen
+	bool remove(std::shared_ptr<TextureData> textureData, bool prefetchOnly = false);
 	void clearQueue();
 
 	size_t getQueueSize();
@@ -31,8 +43,21 @@ public:
 private:	
 	void threadProc();
 
-	std::list<std::shared_ptr<TextureData>> 										mProcessingTextureDataQ;
-	std::list<std::shared_ptr<TextureData>> 										mTextureDataQ;
+	bool hasQueuedTextures();
+
+	typedef std::list<std::shared_ptr<TextureData>> TextureDataQueue;
+
+	struct QueuedTexture
+	{
+		LoadPriority				priority;
+		TextureDataQueue::iterator	position;
+		size_t						size;
+	};
+
+	// One queue per priority, most recent requests first. The index gives the queue position of each texture
+	TextureDataQueue												mTextureDataQ[LoadPriority::PRIORITY_COUNT];
+	std::unordered_map<TextureData*, QueuedTexture>					mQueueIndex;
+	std::unordered_set<TextureData*>								mProcessingTextureData;
 
 	std::vector<std::thread>	mThreads;
 	std::mutex					mLoaderLock;
@@ -40,6 +65,8 @@ private:
 	bool 						mExit;
 
 	TextureDataManager*			mManager;
+
+	std::atomic<size_t>			mQueuedBytes;
 };
 
 
@@ -78,13 +105,16 @@ public:
 	void remove(const TextureResource* key);
 
 	void cancelAsync(const TextureResource* key);
+
+	// Queues the texture at prefetch priority, without releasing other textures to make room
+	void prefetch(const TextureResource* key);
+	void cancelPrefetch(const TextureResource* key);
+
 	std::shared_ptr<TextureData> get(const TextureResource* key, TextureLoadMode enableLoading = TextureLoadMode::ENABLED);
 	bool bind(const TextureResource* key);
 
 	// Get the total size of all textures managed by this object, loaded and unloaded in bytes
 	size_t	getTotalSize();
-	// Get the total size of all committed textures (in VRAM) in bytes
-	size_t	getCommittedSize();
 	// Get the total size of all load-pending textures in the queue - these will
 	// be committed to VRAM as the queue is processed
 	size_t  getQueueSize();
@@ -95,8 +125,15 @@ public:
 
 	void onTextureLoaded(std::shared_ptr<TextureData> tex);
 
+	// Number of textures released to stay within the memory budgets since startup
+	size_t	getEvictionCount() { return mEvictionCount; }
+
 private:
+	// Releases the least recently used textures once a budget is exceeded, down to its low-water mark
+	void reclaimMemory(const std::shared_ptr<TextureData>& loading);
+
 	std::mutex					mMutex;
+	std::atomic<size_t>			mEvictionCount;
 
 	std::list<std::shared_ptr<TextureData> >												mTextures;
 	std::map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureLookup;
@@ -142,6 +142,28 @@ void TextureResource::prioritize() const
 		sTextureDataManager.get(this, TextureDataManager::TextureLoadMode::MOVETOTOPONLY);
 }
 
+void TextureResource::prefetch() const
+{
+	if (mTextureData == nullptr)
+		sTextureDataManager.prefetch(this);
+}
+
+void TextureResource::cancelPrefetch() const
+{
+	if (mTextureData == nullptr)
+		sTextureDataManager.cancelPrefetch(this);
+}
+
+void TextureResource::setTextureClass(TextureClass value) const
+{
+	if (mTextureData != nullptr)
+		return;
+
+	auto data = sTextureDataManager.get(this, TextureDataManager::TextureLoadMode::DISABLED);
+	if (data != nullptr)
+		data->setTextureClass(value);
+}
+
 void TextureResource::setRequired(bool value) const
 {
 	if (mTextureData != nullptr)
@@ -163,6 +185,27 @@ bool TextureResource::bind()
 	return sTextureDataManager.bind(this);	
 }
 
+Vector4f TextureResource::getTextureRect() const
+{
+	if (mTextureData != nullptr)
+		return mTextureData->getTextureRect();
+
+	auto data = sTextureDataManager.get(this, TextureDataManager::TextureLoadMode::DISABLED);
+	if (data != nullptr)
+		return data->getTextureRect();
+
+	return Vector4f(0, 0, 1, 1);
+}
+
+void TextureResource::mapTextureCoordinates(Renderer::Vertex* vertices, int count, const Vector4f& textureRect)
+{
+	if (textureRect == Vector4f(0, 0, 1, 1))
+		return;
+
+	for (int i = 0; i < count; i++)
+		vertices[i].tex = Vector2f(textureRect.x() + vertices[i].tex.x() * textureRect.z(), textureRect.y() + vertices[i].tex.y() * textureRect.w());
+}
+
 void TextureResource::cancelAsync(std::shared_ptr<TextureResource> texture)
 {
 	if (texture != nullptr)
@@ -293,23 +336,21 @@ bool TextureResource::isLoaded() const
 
 size_t TextureResource::getTotalMemUsage(bool includeQueueSize)
 {
-	size_t total = 0;
-	// Count up all textures that manage their own texture data
-	for (auto tex : sAllTextures)
-	{
-		if (tex->mTextureData != nullptr)
-			total += tex->mTextureData->getVRAMUsage();
-	}
-	// Now get the committed memory from the manager
-	total += sTextureDataManager.getCommittedSize();
-	// And the size of the loading queue
+	// Every texture keeps the totals up to date, whether it manages its own texture data or not
+	size_t total = TextureData::getTotalVRAMUsage() + TextureData::getTotalRAMUsage();
 
+	// And the size of the loading queue
 	if (includeQueueSize)
 		total += sTextureDataManager.getQueueSize();
 
 	return total;
 }
 
+size_t TextureResource::getEvictionCount()
+{
+	return sTextureDataManager.getEvictionCount();
+}
+
 size_t TextureResource::getTotalTextureSize()
 {
 	size_t total = 0;
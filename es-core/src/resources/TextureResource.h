@@ -4,6 +4,8 @@
 
 #include "math/Vector2i.h"
 #include "math/Vector2f.h"
+#include "math/Vector4f.h"
+#include "renderers/Renderer.h"
 #include "resources/ResourceManager.h"
 #include "resources/TextureDataManager.h"
 #include "resources/TextureData.h"
@@ -33,13 +35,23 @@ public:
 	bool isLoaded() const;
 	bool isTiled() const;
 	void prioritize() const;
+	// Queues the texture for loading before it is displayed, behind all the textures on screen
+	void prefetch() const;
+	void cancelPrefetch() const;
 	void setRequired(bool value) const;
+	void setTextureClass(TextureClass value) const;
 
 	const Vector2i getSize() const;
 	bool bind();
 
+	// Small theme pictures share an atlas texture : rect of this picture in the bound texture, valid after bind()
+	Vector4f getTextureRect() const;
+	// Converts 0..1 texture coordinates to the rect returned by getTextureRect
+	static void mapTextureCoordinates(Renderer::Vertex* vertices, int count, const Vector4f& textureRect);
+
 	static size_t getTotalMemUsage(bool includeQueueSize = true); // returns an approximation of total VRAM used by textures (in bytes)
 	static size_t getTotalTextureSize(); // returns the number of bytes that would be used if all textures were in memory
+	static size_t getEvictionCount(); // returns the number of textures released to stay within the memory budgets
 	
 	virtual bool unload();
 	virtual void reload();
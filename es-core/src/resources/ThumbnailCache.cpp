@@ -0,0 +1,271 @@
+#include "resources/ThumbnailCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include "Paths.h"
+#include "Settings.h"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include "stbimage/stb_image.h"
+#include "stbimage/stb_image_write.h"
+#include <libyuv.h>
+
+#define THUMBNAIL_MAGIC		0x48545345 // "ESTH"
+#define THUMBNAIL_VERSION	1
+#define SIZE_BUCKET			64
+#define CACHE_MAX_AGE_DAYS	90
+
+std::atomic<unsigned int> ThumbnailCache::mHits(0);
+std::atomic<unsigned int> ThumbnailCache::mMisses(0);
+std::atomic<unsigned long long> ThumbnailCache::mBytesSaved(0);
+
+bool ThumbnailCache::isEnabled()
+{
+	return Settings::getInstance()->getBool("ThumbnailCache");
+}
+
+static int toBucket(float size)
+{
+	return (((int)size + SIZE_BUCKET - 1) / SIZE_BUCKET) * SIZE_BUCKET;
+}
+
+std::string ThumbnailCache::getCacheKey(const std::string& path, MaxSizeInfo maxSize, unsigned long long& fileSize)
+{
+	time_t time = 0;
+	if (!Utils::FileSystem::getFileSizeAndModificationTime(path, &fileSize, &time))
+		return "";
+
+	// Close sizes share the same entry, the cached picture is scaled down when it is bigger than needed
+	return path + "|" + std::to_string(fileSize) + "|" + std::to_string((long long)time) + "|" +
+		std::to_string(toBucket(maxSize.x())) + "x" + std::to_string(toBucket(maxSize.y())) + (maxSize.externalZoom() ? "z" : "");
+}
+
+std::string ThumbnailCache::getCachePath(const std::string& key)
+{
+	// FNV-1a
+	unsigned long long hash = 14695981039346656037ULL;
+	for (auto c : key)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ULL;
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.thumb", hash);
+
+	return Paths::getUserEmulationStationPath() + "/cache/thumbnails/" + name;
+}
+
+void ThumbnailCache::sweepCache(const std::atomic<bool>* cancel)
+{
+	std::string path = Paths::getUserEmulationStationPath() + "/cache/thumbnails";
+	if (!Utils::FileSystem::isDirectory(path))
+		return;
+
+	// Keys hold the source modification time & size bucket : entries of replaced medias or old layouts are never read again
+	unsigned long long maxSize = (unsigned long long)std::max(0, Settings::getInstance()->getInt("ThumbnailCacheSize")) * 1024 * 1024;
+
+	auto freed = Utils::FileSystem::trimCacheFolder(path, CACHE_MAX_AGE_DAYS, maxSize, cancel);
+	if (freed > 0)
+	{
+		LOG(LogInfo) << "ThumbnailCache : " << (freed / 1024) << "KB of unused thumbnails removed from the cache";
+	}
+}
+
+template<typename T> static bool readValue(const std::string& buffer, size_t& pos, T& value)
+{
+	if (pos + sizeof(T) > buffer.size())
+		return false;
+
+	memcpy(&value, buffer.data() + pos, sizeof(T));
+	pos += sizeof(T);
+	return true;
+}
+
+template<typename T> static void writeValue(std::string& buffer, T value)
+{
+	buffer.append((const char*)&value, sizeof(T));
+}
+
+unsigned char* ThumbnailCache::load(const std::string& path, MaxSizeInfo maxSize, int& channels, size_t& width, size_t& height, Vector2i& baseSize)
+{
+	unsigned long long fileSize = 0;
+	std::string key = getCacheKey(path, maxSize, fileSize);
+	if (key.empty())
+		return nullptr;
+
+	std::string buffer;
+
+	{
+		std::ifstream file(WINSTRINGW(getCachePath(key)), std::ios::binary | std::ios::ate);
+		if (!file.fail())
+		{
+			buffer.resize((size_t)file.tellg());
+			file.seekg(0, std::ios::beg);
+			if (!file.read(&buffer[0], buffer.size()))
+				buffer.clear();
+		}
+	}
+
+	size_t pos = 0;
+	unsigned int magic = 0, version = 0, keySize = 0;
+	unsigned char storedChannels = 0;
+	int baseWidth = 0, baseHeight = 0;
+
+	if (!readValue(buffer, pos, magic) || magic != THUMBNAIL_MAGIC || !readValue(buffer, pos, version) || version != THUMBNAIL_VERSION ||
+		!readValue(buffer, pos, keySize) || pos + keySize > buffer.size() || buffer.compare(pos, keySize, key) != 0)
+	{
+		mMisses++;
+		return nullptr;
+	}
+
+	pos += keySize;
+
+	if (!readValue(buffer, pos, storedChannels) || !readValue(buffer, pos, baseWidth) || !readValue(buffer, pos, baseHeight))
+	{
+		mMisses++;
+		return nullptr;
+	}
+
+	int imgSizeX, imgSizeY, imgChannels;
+	unsigned char* bitmap = stbi_load_from_memory((const unsigned char*)buffer.data() + pos, (int)(buffer.size() - pos), &imgSizeX, &imgSizeY, &imgChannels, 4);
+	if (bitmap == nullptr)
+	{
+		mMisses++;
+		return nullptr;
+	}
+
+	Vector2i target = ImageIO::getScaledSize(Vector2i(baseWidth, baseHeight), &maxSize);
+
+	// Made for a smaller size of the same bucket : the original is needed
+	if (imgSizeX < target.x() || imgSizeY < target.y())
+	{
+		stbi_image_free(bitmap);
+		mMisses++;
+		return nullptr;
+	}
+
+	if (imgSizeX != target.x() || imgSizeY != target.y())
+	{
+		unsigned char* scaled = static_cast<unsigned char*>(aligned_alloc(32, target.x() * target.y() * 4));
+		if (libyuv::ARGBScale(bitmap, imgSizeX * 4, imgSizeX, imgSizeY, scaled, target.x() * 4, target.x(), target.y(), libyuv::FilterMode::kFilterBilinear))
+		{
+			free(scaled);
+			stbi_image_free(bitmap);
+			mMisses++;
+			return nullptr;
+		}
+
+		stbi_image_free(bitmap);
+		bitmap = scaled;
+	}
+
+	if (storedChannels == 3)
+	{
+		unsigned char* bitmap24 = static_cast<unsigned char*>(aligned_alloc(32, target.x() * target.y() * 3));
+		if (libyuv::ARGBToRGB24(bitmap, target.x() * 4, bitmap24, target.x() * 3, target.x(), target.y()))
+		{
+			free(bitmap24);
+			free(bitmap);
+			mMisses++;
+			return nullptr;
+		}
+
+		free(bitmap);
+		bitmap = bitmap24;
+	}
+
+	channels = (storedChannels == 3 ? 3 : 4);
+	width = target.x();
+	height = target.y();
+	baseSize = Vector2i(baseWidth, baseHeight);
+
+	mHits++;
+	if (fileSize > buffer.size())
+		mBytesSaved += fileSize - buffer.size();
+
+	return bitmap;
+}
+
+static void appendToBuffer(void* context, void* data, int size)
+{
+	((std::string*)context)->append((const char*)data, size);
+}
+
+bool ThumbnailCache::save(const std::string& path, MaxSizeInfo maxSize, const unsigned char* data, int channels, size_t width, size_t height, const Vector2i& baseSize)
+{
+	if (data == nullptr || width == 0 || height == 0 || (channels != 3 && channels != 4))
+		return false;
+
+	unsigned long long fileSize = 0;
+	std::string key = getCacheKey(path, maxSize, fileSize);
+	if (key.empty())
+		return false;
+
+	std::string buffer;
+	writeValue<unsigned int>(buffer, THUMBNAIL_MAGIC);
+	writeValue<unsigned int>(buffer, THUMBNAIL_VERSION);
+	writeValue<unsigned int>(buffer, (unsigned int)key.size());
+	buffer.append(key);
+	writeValue<unsigned char>(buffer, (unsigned char)channels);
+	writeValue<int>(buffer, baseSize.x());
+	writeValue<int>(buffer, baseSize.y());
+
+	size_t headerSize = buffer.size();
+
+	// Opaque pictures as jpg, png keeps the transparency
+	bool encoded;
+	if (channels == 3)
+		encoded = stbi_write_jpg_to_func(appendToBuffer, &buffer, (int)width, (int)height, 3, data, 90) != 0;
+	else
+		encoded = stbi_write_png_to_func(appendToBuffer, &buffer, (int)width, (int)height, 4, data, (int)width * 4) != 0;
+
+	if (!encoded || buffer.size() == headerSize)
+		return false;
+
+	// Not worth it if the original is not bigger
+	if (buffer.size() >= fileSize)
+		return false;
+
+	std::string cachePath = getCachePath(key);
+	std::string tmpPath = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(cachePath));
+
+	std::ofstream file(WINSTRINGW(tmpPath), std::ios::binary | std::ios::trunc);
+	if (file.fail())
+		return false;
+
+	file.write(buffer.data(), buffer.size());
+	file.close();
+
+	if (file.fail())
+	{
+		remove(tmpPath.c_str());
+		return false;
+	}
+
+	remove(cachePath.c_str());
+	if (rename(tmpPath.c_str(), cachePath.c_str()) != 0)
+	{
+		remove(tmpPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void ThumbnailCache::logStatistics()
+{
+	unsigned int hits = mHits;
+	unsigned int total = hits + mMisses;
+	if (total == 0)
+		return;
+
+	LOG(LogInfo) << "ThumbnailCache : " << hits << " hits / " << total << " loads (" << (hits * 100 / total) << "%), " << (mBytesSaved / 1024) << "KB not read from the original files";
+}
@@ -0,0 +1,35 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+#define ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+
+#include <atomic>
+#include <string>
+#include "ImageIO.h"
+
+// Persistent copies of big media files already scaled down to the size they are displayed at.
+// Entries are keyed by source path, size, modification time & requested size rounded to a bucket, so the grid & carousel
+// reload a small jpg/png instead of decoding & rescaling the original each time a texture is evicted.
+class ThumbnailCache
+{
+public:
+	static bool isEnabled();
+
+	// Returns the pixels scaled for maxSize, RGB24 when channels is 3, RGBA32 otherwise. baseSize is the size of the source image
+	static unsigned char* load(const std::string& path, MaxSizeInfo maxSize, int& channels, size_t& width, size_t& height, Vector2i& baseSize);
+	static bool save(const std::string& path, MaxSizeInfo maxSize, const unsigned char* data, int channels, size_t width, size_t height, const Vector2i& baseSize);
+
+	// Removes the entries unused for months, then the oldest ones until the cache fits in "ThumbnailCacheSize" MB. Meant for a background thread
+	static void sweepCache(const std::atomic<bool>* cancel = nullptr);
+
+	static void logStatistics();
+
+private:
+	static std::string getCacheKey(const std::string& path, MaxSizeInfo maxSize, unsigned long long& fileSize);
+	static std::string getCachePath(const std::string& key);
+
+	static std::atomic<unsigned int> mHits;
+	static std::atomic<unsigned int> mMisses;
+	static std::atomic<unsigned long long> mBytesSaved;
+};
+
+#endif // ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
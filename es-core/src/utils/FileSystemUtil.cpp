@@ -4,8 +4,10 @@
 #include "utils/StringUtil.h"
 #include "utils/ZipFile.h"
 #include "utils/md5.h"
+#include "utils/InternedPath.h"
 
 #include "Settings.h"
+#include "Log.h"
 #include <sys/stat.h>
 #include <string.h>
 #include <algorithm>
@@ -31,6 +33,10 @@
 
 #include <fstream>
 #include <sstream>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+#include <time.h>
 
 #include "Paths.h"
 
@@ -102,7 +108,8 @@ namespace Utils
 				int ret = stat64(key.c_str(), info);
 #endif
 
-				mFileCacheMutex.lock();
+				if (!mEnabled)
+					return ret;
 
 				FileCache cache(ret == 0, false);
 				if (cache.exists)
@@ -119,63 +126,165 @@ namespace Utils
 #endif
 				}
 
-				mFileCache[key] = cache;
+				add(key, cache);
+				return ret;
+			}
 
-				mFileCacheMutex.unlock();
+			static void add(const std::string& key, const FileCache& cache)
+			{
+				if (!mEnabled)
+					return;
 
-				return ret;
+				InternedPath ikey(key);
+
+				Shard& shard = getShard(ikey);
+				ShardLock lock(shard);
+				shard.entries[std::move(ikey)] = cache;
 			}
 
-			static void add(const std::string& key, FileCache cache)
+			// Tells the cache that all the entries of the folder are known : missing files are then reported as non-existing without any stat
+			static void setFolderComplete(const std::string& folder)
 			{
 				if (!mEnabled)
 					return;
 
-				mFileCacheMutex.lock();
-				mFileCache[key] = cache;
-				mFileCacheMutex.unlock();
+				InternedPath ifolder(folder);
+
+				Shard& shard = getShard(ifolder);
+				ShardLock lock(shard);
+				shard.completeFolders.insert(std::move(ifolder));
 			}
 
-			static FileCache* get(const std::string& key)
+			static bool get(const std::string& key, FileCache& cache)
 			{
 				if (!mEnabled)
-					return nullptr;
+					return false;
 
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
+				{
+					InternedPath ikey(key);
 
-				auto it = mFileCache.find(key);
-				if (it != mFileCache.cend())
-					return &it->second;
+					Shard& shard = getShard(ikey);
+					ShardLock lock(shard);
 
-				it = mFileCache.find(Utils::FileSystem::getParent(key) + "/*");
-				if (it != mFileCache.cend())
+					auto it = shard.entries.find(ikey);
+					if (it != shard.entries.cend())
+					{
+						mHits++;
+						cache = it->second;
+						return true;
+					}
+				}
+
+				InternedPath parent(Utils::FileSystem::getParent(key));
+
+				bool parentComplete;
+
+				{
+					Shard& shard = getShard(parent);
+					ShardLock lock(shard);
+					parentComplete = (shard.completeFolders.find(parent) != shard.completeFolders.cend());
+				}
+
+				if (parentComplete)
 				{
-					mFileCache[key] = FileCache(false, false);
-					return &mFileCache[key];
+					mNegativeHits++;
+
+					// Keep the negative entry, so next time it's found without looking at the parent
+					cache = FileCache(false, false);
+					add(key, cache);
+					return true;
 				}
 
-				return nullptr;
+				mMisses++;
+				return false;
 			}
 
 			static void resetCache()
 			{
-				mFileCacheMutex.lock();
-				mFileCache.clear();
-				mFileCacheMutex.unlock();
+				for (auto& shard : mShards)
+				{
+					ShardLock lock(shard);
+					shard.entries.clear();
+					shard.completeFolders.clear();
+				}
+
+				mHits = 0;
+				mNegativeHits = 0;
+				mMisses = 0;
+				mContentions = 0;
+			}
+
+			static FileCacheStats getStats()
+			{
+				FileCacheStats stats;
+				stats.hits = mHits;
+				stats.negativeHits = mNegativeHits;
+				stats.misses = mMisses;
+				stats.contentions = mContentions;
+				stats.entries = 0;
+				stats.completeFolders = 0;
+
+				for (auto& shard : mShards)
+				{
+					ShardLock lock(shard);
+					stats.entries += shard.entries.size();
+					stats.completeFolders += shard.completeFolders.size();
+				}
+
+				return stats;
 			}
 
 			static void setEnabled(bool value) { mEnabled = value; }
 			static bool isEnabled() { return mEnabled; }
 
 		private:
-			static std::map<std::string, FileCache> mFileCache;
-			static std::mutex mFileCacheMutex;
-			static bool mEnabled;
+			// The cache is split by path hash so parallel system loads rarely wait for each other
+			static const int SHARD_COUNT = 64;
+
+			struct Shard
+			{
+				std::mutex lock;
+				// Keyed by interned paths : the folder part is shared with the FileData paths
+				std::unordered_map<InternedPath, FileCache, InternedPathHash> entries;
+				std::unordered_set<InternedPath, InternedPathHash> completeFolders;
+			};
+
+			class ShardLock
+			{
+			public:
+				ShardLock(Shard& shard) : mLock(shard.lock, std::try_to_lock)
+				{
+					if (!mLock.owns_lock())
+					{
+						mContentions++;
+						mLock.lock();
+					}
+				}
+
+			private:
+				std::unique_lock<std::mutex> mLock;
+			};
+
+			static Shard& getShard(const InternedPath& key)
+			{
+				return mShards[key.hash() % SHARD_COUNT];
+			}
+
+			static Shard mShards[SHARD_COUNT];
+			static std::atomic<bool> mEnabled;
+
+			static std::atomic<unsigned int> mHits;
+			static std::atomic<unsigned int> mNegativeHits;
+			static std::atomic<unsigned int> mMisses;
+			static std::atomic<unsigned int> mContentions;
 		};
 
-		std::map<std::string, FileCache> FileCache::mFileCache;
-		std::mutex FileCache::mFileCacheMutex;
-		bool FileCache::mEnabled = false;
+		FileCache::Shard FileCache::mShards[FileCache::SHARD_COUNT];
+		std::atomic<bool> FileCache::mEnabled(false);
+		std::atomic<unsigned int> FileCache::mHits(0);
+		std::atomic<unsigned int> FileCache::mNegativeHits(0);
+		std::atomic<unsigned int> FileCache::mMisses(0);
+		std::atomic<unsigned int> FileCache::mContentions(0);
 
 	// FileSystemCacheActivator
 
@@ -198,11 +307,20 @@ namespace Utils
 
 			if (mReferenceCount <= 0)
 			{
+				FileCacheStats stats = FileCache::getStats();
+				LOG(LogDebug) << "FileCache : " << stats.hits << " hits, " << stats.negativeHits << " negative hits, " << stats.misses << " misses, "
+					<< stats.contentions << " contentions, " << stats.entries << " entries, " << stats.completeFolders << " complete folders";
+
 				FileCache::setEnabled(false);
 				FileCache::resetCache();
 			}
 		}
 
+		FileCacheStats FileSystemCacheActivator::getCacheStats()
+		{
+			return FileCache::getStats();
+		}
+
 	// Methods
 
 		stringList getDirContent(const std::string& _path, const bool _recursive, const bool includeHidden)
@@ -213,9 +331,6 @@ namespace Utils
 			// only parse the directory, if it's a directory
 			if(isDirectory(path))
 			{
-				// tell filecache we enumerated the folder
-				FileCache::add(path + "/*", FileCache(true, true));
-
 #if defined(_WIN32)
 				WIN32_FIND_DATAW findData;
 				std::string      wildcard = path + "/*";
@@ -290,6 +405,8 @@ namespace Utils
 				}
 #endif // _WIN32
 
+				// tell filecache we enumerated the folder, once all its entries are known
+				FileCache::setFolderComplete(path);
 			}
 
 			// sort the content list
@@ -316,9 +433,6 @@ namespace Utils
 			std::string path = getGenericPath(_path);
 			fileList  contentList;
 
-			// tell filecache we enumerated the folder
-			FileCache::add(path + "/*", FileCache(true, true));
-
 			// only parse the directory, if it's a directory
 			// if (isDirectory(path))
 			{			
@@ -402,7 +516,10 @@ namespace Utils
 
 							FileInfo fi;
 							fi.path = fullName;
-							fi.hidden = Utils::FileSystem::isHidden(fullName);
+
+							// Same result as when the folder was flagged as enumerated before its listing : while the cache is active,
+							// dot-prefixed entries are listed as visible. Only the uncached lookup reports them hidden
+							fi.hidden = FileCache::isEnabled() ? false : Utils::FileSystem::isHidden(fullName);
 
 							if (entry->d_type == 10) // DT_LNK
 							{
@@ -426,6 +543,8 @@ namespace Utils
 				}
 #endif // _WIN32
 
+				// tell filecache we enumerated the folder, once all its entries are known
+				FileCache::setFolderComplete(path);
 			}
 
 			// return the content list
@@ -950,9 +1069,9 @@ namespace Utils
 			if (_path.empty())
 				return false;
 
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists;
+			FileCache cache;
+			if (FileCache::get(_path, cache))
+				return cache.exists;
 
 #ifdef WIN32			
 			if (!FileCache::isEnabled())
@@ -989,9 +1108,9 @@ namespace Utils
 
 		bool isRegularFile(const std::string& _path)
 		{
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && !it->directory && !it->isSymLink;
+			FileCache cache;
+			if (FileCache::get(_path, cache))
+				return cache.exists && !cache.directory && !cache.isSymLink;
 
 			std::string path = getGenericPath(_path);
 			struct stat64 info;
@@ -1007,9 +1126,9 @@ namespace Utils
 
 		bool isDirectory(const std::string& _path)
 		{
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && it->directory;
+			FileCache cache;
+			if (FileCache::get(_path, cache))
+				return cache.exists && cache.directory;
 
 #ifdef WIN32
 			// check for symlink attribute
@@ -1038,9 +1157,9 @@ namespace Utils
 		bool isSymlink(const std::string& _path)
 		{
 		
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && it->isSymLink;
+			FileCache cache;
+			if (FileCache::get(_path, cache))
+				return cache.exists && cache.isSymLink;
 				
 			std::string path = getGenericPath(_path);
 
@@ -1068,9 +1187,9 @@ namespace Utils
 
 		bool isHidden(const std::string& _path)
 		{
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && it->hidden;
+			FileCache cache;
+			if (FileCache::get(_path, cache))
+				return cache.exists && cache.hidden;
 
 			std::string path = getGenericPath(_path);
 
@@ -1199,6 +1318,95 @@ namespace Utils
 			return Utils::Time::DateTime();
 		}
 
+		// Single stat for callers that need both values
+		bool getFileSizeAndModificationTime(const std::string& _path, unsigned long long* size, time_t* modificationTime)
+		{
+			std::string path = getGenericPath(_path);
+			struct stat64 info;
+
+#if defined(_WIN32)
+			if (_wstat64(Utils::String::convertToWideString(path).c_str(), &info) != 0)
+				return false;
+#else
+			if (stat64(path.c_str(), &info) != 0)
+				return false;
+#endif
+
+			if (size != nullptr)
+				*size = (unsigned long long)info.st_size;
+
+			if (modificationTime != nullptr)
+				*modificationTime = info.st_mtime;
+
+			return true;
+		}
+
+		unsigned long long trimCacheFolder(const std::string& _path, int maxAgeDays, unsigned long long maxSize, const std::atomic<bool>* cancel)
+		{
+			struct CacheFile
+			{
+				std::string path;
+				unsigned long long size;
+				time_t lastUse;
+			};
+
+			std::vector<CacheFile> files;
+			unsigned long long totalSize = 0;
+			unsigned long long freedSize = 0;
+
+			time_t oldest = maxAgeDays > 0 ? time(NULL) - (time_t)maxAgeDays * 86400 : 0;
+
+			for (auto& path : getDirContent(_path, false, true))
+			{
+				if (cancel != nullptr && *cancel)
+					return freedSize;
+
+				struct stat64 info;
+#if defined(_WIN32)
+				if (_wstat64(Utils::String::convertToWideString(path).c_str(), &info) != 0 || S_ISDIR(info.st_mode))
+#else
+				if (stat64(path.c_str(), &info) != 0 || S_ISDIR(info.st_mode))
+#endif
+					continue;
+
+				// relatime only updates the access time once a day, and noatime never does : the modification time is the fallback
+				CacheFile file;
+				file.path = path;
+				file.size = (unsigned long long)info.st_size;
+				file.lastUse = std::max(info.st_atime, info.st_mtime);
+
+				if (file.lastUse < oldest)
+				{
+					if (removeFile(path))
+						freedSize += file.size;
+
+					continue;
+				}
+
+				totalSize += file.size;
+				files.push_back(file);
+			}
+
+			if (maxSize == 0 || totalSize <= maxSize)
+				return freedSize;
+
+			std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.lastUse < b.lastUse; });
+
+			for (auto& file : files)
+			{
+				if (totalSize <= maxSize || (cancel != nullptr && *cancel))
+					break;
+
+				if (removeFile(file.path))
+				{
+					totalSize -= file.size;
+					freedSize += file.size;
+				}
+			}
+
+			return freedSize;
+		}
+
 		std::string	readAllText(const std::string fileName)
 		{
 			std::ifstream t(WINSTRINGW(fileName));
@@ -2,6 +2,7 @@
 #ifndef ES_CORE_UTILS_FILE_SYSTEM_UTIL_H
 #define ES_CORE_UTILS_FILE_SYSTEM_UTIL_H
 
+#include <atomic>
 #include <list>
 #include <string>
 #include <vector>
@@ -58,6 +59,11 @@ namespace Utils
 
 		Utils::Time::DateTime getFileCreationDate(const std::string& _path);
 		Utils::Time::DateTime getFileModificationDate(const std::string& _path);
+		bool getFileSizeAndModificationTime(const std::string& _path, unsigned long long* size, time_t* modificationTime);
+
+		// Removes the files of a cache folder unused for maxAgeDays (0 = no limit), then the least recently used ones until the folder fits in maxSize bytes (0 = no limit).
+		// Sub folders are left untouched. Stops early when cancel becomes true. Returns the number of bytes freed
+		unsigned long long trimCacheFolder(const std::string& _path, int maxAgeDays, unsigned long long maxSize, const std::atomic<bool>* cancel = nullptr);
 
 		std::string	readAllText(const std::string fileName);
 		void		writeAllText(const std::string& fileName, const std::string& text);
@@ -80,12 +86,24 @@ namespace Utils
 
 		std::string changeExtension(const std::string& _path, const std::string& extension);
 
+		struct FileCacheStats
+		{
+			unsigned int hits;
+			unsigned int negativeHits;		// answered from a folder listing, without any stat
+			unsigned int misses;
+			unsigned int contentions;		// lookups that had to wait for another thread
+			size_t entries;
+			size_t completeFolders;
+		};
+
 		class FileSystemCacheActivator
 		{
 		public:
 			FileSystemCacheActivator();
 			~FileSystemCacheActivator();
 
+			static FileCacheStats getCacheStats();
+
 		private:
 			static int mReferenceCount;
 		};
@@ -0,0 +1,238 @@
+#include "utils/InternedPath.h"
+
+#include "Log.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string.h>
+#include <unordered_set>
+
+namespace Utils
+{
+	// Sharded like the FileSystem cache : paths are created by the threaded system loads
+	#define INTERNEDPATH_SHARD_COUNT 16
+
+	struct FolderShard
+	{
+		std::mutex lock;
+		std::unordered_set<std::string> folders;
+	};
+
+	static FolderShard sFolderShards[INTERNEDPATH_SHARD_COUNT];
+
+	static std::atomic<size_t> sFolderCount(0);
+	static std::atomic<size_t> sFolderBytes(0);
+	static std::atomic<size_t> sPathCount(0);
+	static std::atomic<size_t> sNameBytes(0);
+	static std::atomic<size_t> sSharedBytes(0);
+
+	static const std::string* internFolder(const char* folder, size_t length)
+	{
+		std::string key(folder, length);
+
+		FolderShard& shard = sFolderShards[std::hash<std::string>()(key) % INTERNEDPATH_SHARD_COUNT];
+		std::unique_lock<std::mutex> lock(shard.lock);
+
+		auto it = shard.folders.find(key);
+		if (it != shard.folders.cend())
+			return &(*it);
+
+		sFolderCount++;
+		sFolderBytes += sizeof(std::string) + key.capacity() + 1;
+
+		return &(*shard.folders.insert(key).first);
+	}
+
+	static char* copyName(const char* name, size_t length)
+	{
+		if (length == 0)
+			return nullptr;
+
+		char* ret = new char[length + 1];
+		memcpy(ret, name, length);
+		ret[length] = 0;
+
+		sNameBytes += length + 1;
+		return ret;
+	}
+
+	InternedPath::InternedPath(const std::string& path) : mFolder(nullptr), mName(nullptr)
+	{
+		assign(path);
+	}
+
+	InternedPath::InternedPath(const InternedPath& src) : mFolder(src.mFolder), mName(nullptr)
+	{
+		if (src.mName != nullptr)
+			mName = copyName(src.mName, strlen(src.mName));
+
+		if (!empty())
+		{
+			sPathCount++;
+			if (mFolder != nullptr)
+				sSharedBytes += mFolder->size();
+		}
+	}
+
+	InternedPath::InternedPath(InternedPath&& src) : mFolder(src.mFolder), mName(src.mName)
+	{
+		src.mFolder = nullptr;
+		src.mName = nullptr;
+	}
+
+	InternedPath::~InternedPath()
+	{
+		release();
+	}
+
+	InternedPath& InternedPath::operator=(const InternedPath& src)
+	{
+		if (this != &src)
+		{
+			release();
+
+			mFolder = src.mFolder;
+			if (src.mName != nullptr)
+				mName = copyName(src.mName, strlen(src.mName));
+
+			if (!empty())
+			{
+				sPathCount++;
+				if (mFolder != nullptr)
+					sSharedBytes += mFolder->size();
+			}
+		}
+
+		return *this;
+	}
+
+	InternedPath& InternedPath::operator=(InternedPath&& src)
+	{
+		if (this != &src)
+		{
+			release();
+
+			mFolder = src.mFolder;
+			mName = src.mName;
+			src.mFolder = nullptr;
+			src.mName = nullptr;
+		}
+
+		return *this;
+	}
+
+	InternedPath& InternedPath::operator=(const std::string& path)
+	{
+		release();
+		assign(path);
+		return *this;
+	}
+
+	void InternedPath::assign(const std::string& path)
+	{
+		if (path.empty())
+			return;
+
+		size_t separator = path.find_last_of("/\\");
+		if (separator == std::string::npos)
+			mName = copyName(path.c_str(), path.size());
+		else
+		{
+			mFolder = internFolder(path.c_str(), separator + 1);
+			mName = copyName(path.c_str() + separator + 1, path.size() - separator - 1);
+			sSharedBytes += mFolder->size();
+		}
+
+		sPathCount++;
+	}
+
+	void InternedPath::release()
+	{
+		if (empty())
+			return;
+
+		if (mFolder != nullptr)
+			sSharedBytes -= mFolder->size();
+
+		if (mName != nullptr)
+		{
+			sNameBytes -= strlen(mName) + 1;
+			delete[] mName;
+		}
+
+		sPathCount--;
+
+		mFolder = nullptr;
+		mName = nullptr;
+	}
+
+	std::string InternedPath::toString() const
+	{
+		if (mFolder == nullptr)
+			return mName == nullptr ? std::string() : std::string(mName);
+
+		if (mName == nullptr)
+			return *mFolder;
+
+		return *mFolder + mName;
+	}
+
+	bool InternedPath::operator==(const std::string& path) const
+	{
+		size_t folderLength = (mFolder == nullptr ? 0 : mFolder->size());
+		size_t nameLength = (mName == nullptr ? 0 : strlen(mName));
+
+		if (path.size() != folderLength + nameLength)
+			return false;
+
+		if (folderLength > 0 && path.compare(0, folderLength, *mFolder) != 0)
+			return false;
+
+		return nameLength == 0 || path.compare(folderLength, nameLength, mName) == 0;
+	}
+
+	bool InternedPath::operator==(const InternedPath& other) const
+	{
+		if (mFolder != other.mFolder)
+			return false;
+
+		if (mName == nullptr || other.mName == nullptr)
+			return mName == other.mName;
+
+		return strcmp(mName, other.mName) == 0;
+	}
+
+	size_t InternedPath::hash() const
+	{
+		size_t hash = std::hash<const void*>()(mFolder);
+
+		if (mName != nullptr)
+			for (const char* c = mName; *c != 0; c++)
+				hash = hash * 31 + (unsigned char)*c;
+
+		return hash;
+	}
+
+	InternedPathStats InternedPath::getStats()
+	{
+		InternedPathStats stats;
+		stats.folders = sFolderCount;
+		stats.folderBytes = sFolderBytes;
+		stats.paths = sPathCount;
+		stats.nameBytes = sNameBytes;
+		stats.sharedBytes = sSharedBytes;
+		return stats;
+	}
+
+	void InternedPath::logStats()
+	{
+		InternedPathStats stats = getStats();
+
+		// std::string layout : object + heap block for anything longer than the small string buffer
+		size_t asStrings = stats.paths * sizeof(std::string) + stats.nameBytes + stats.sharedBytes;
+		size_t asInterned = stats.paths * sizeof(InternedPath) + stats.nameBytes + stats.folderBytes;
+
+		LOG(LogInfo) << "InternedPath : " << stats.paths << " paths sharing " << stats.folders << " folders, "
+			<< (asInterned / 1024) << "KB used instead of " << (asStrings / 1024) << "KB as std::string";
+	}
+}
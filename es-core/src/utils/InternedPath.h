@@ -0,0 +1,61 @@
+#pragma once
+#ifndef ES_CORE_UTILS_INTERNED_PATH_H
+#define ES_CORE_UTILS_INTERNED_PATH_H
+
+#include <string>
+
+namespace Utils
+{
+	struct InternedPathStats
+	{
+		size_t folders;			// distinct folders in the pool
+		size_t folderBytes;		// memory used by the pool strings
+		size_t paths;			// live InternedPath instances
+		size_t nameBytes;		// memory used by their file names
+		size_t sharedBytes;		// folder characters that would have been duplicated in each std::string
+	};
+
+	// Path split in a folder part shared by all the paths of the same folder, and a file name owned by the instance.
+	// Size is two pointers instead of a std::string + a heap block holding the full path.
+	// Interned folders are never released : they're a bounded set (rom, media & system folders).
+	class InternedPath
+	{
+	public:
+		InternedPath() : mFolder(nullptr), mName(nullptr) { }
+		InternedPath(const std::string& path);
+		InternedPath(const InternedPath& src);
+		InternedPath(InternedPath&& src);
+		~InternedPath();
+
+		InternedPath& operator=(const InternedPath& src);
+		InternedPath& operator=(InternedPath&& src);
+		InternedPath& operator=(const std::string& path);
+
+		bool operator==(const std::string& path) const;
+		bool operator!=(const std::string& path) const { return !(*this == path); }
+
+		// Interned folders are compared by address
+		bool operator==(const InternedPath& other) const;
+		size_t hash() const;
+
+		bool empty() const { return mFolder == nullptr && mName == nullptr; }
+		std::string toString() const;
+
+		static InternedPathStats getStats();
+		static void logStats();
+
+	private:
+		void assign(const std::string& path);
+		void release();
+
+		const std::string* mFolder;	// including the trailing separator
+		char* mName;
+	};
+
+	struct InternedPathHash
+	{
+		size_t operator()(const InternedPath& path) const { return path.hash(); }
+	};
+}
+
+#endif // ES_CORE_UTILS_INTERNED_PATH_H
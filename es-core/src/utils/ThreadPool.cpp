@@ -1,126 +1,246 @@
 #include "ThreadPool.h"
 
-#if WIN32
-#include <Windows.h>
-#endif
-
 namespace Utils
 {
-	ThreadPool::ThreadPool(int threadByCore) : mRunning(false), mWaiting(false), mNumWork(0)
+	static thread_local int sWorkerIndex = -1;
+
+	Executor* Executor::getInstance()
+	{
+		// Never destroyed : long running tasks must not block the process exit
+		static Executor* instance = new Executor();
+		return instance;
+	}
+
+	Executor::Executor() : mQueued(0), mNextWorker(0)
+	{
+		int num_threads = std::thread::hardware_concurrency() * THREAD_BY_CORE;
+		if (num_threads < 2)
+			num_threads = 2;
+
+		for (int i = 0; i < num_threads; i++)
+			mWorkers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+		for (int i = 0; i < num_threads; i++)
+			mWorkers[i]->thread = std::thread(&Executor::workerProc, this, i);
+	}
+
+	bool Executor::isWorkerThread()
 	{
-		mThreadByCore = threadByCore;
+		return sWorkerIndex >= 0;
 	}
 
-	void ThreadPool::start()
+	void Executor::submit(work_function work, TaskGroup* group, TaskPriority priority)
 	{
-		mRunning = true;
+		if (group != nullptr)
+			group->onTaskQueued();
 
-		size_t num_threads = std::thread::hardware_concurrency() * mThreadByCore;
+		// Tasks queued by a worker stay on its own deque, others are spread round-robin
+		int index = sWorkerIndex;
+		if (index < 0)
+			index = (int)(mNextWorker++ % mWorkers.size());
 
-		auto doWork = [&](size_t id)
 		{
-#if WIN32
-			auto mask = (static_cast<DWORD_PTR>(1) << id);
-			SetThreadAffinityMask(GetCurrentThread(), mask);
-#endif
+			std::unique_lock<std::mutex> lock(mWorkers[index]->lock);
+			mWorkers[index]->tasks[(int)priority].push_back(Task{ work, group });
+		}
+
+		mQueued++;
 
-			while (mRunning)
+		{
+			std::unique_lock<std::mutex> lock(mIdleLock);
+		}
+
+		mIdleEvent.notify_one();
+	}
+
+	bool Executor::take(int index, TaskGroup* group, Task& task)
+	{
+		int count = (int)mWorkers.size();
+
+		for (int priority = 0; priority < PRIORITY_COUNT; priority++)
+		{
+			// Own deque first, newest task first
+			if (index >= 0)
 			{
-				_mutex.lock();
-				if (!mWorkQueue.empty())
-				{
-					auto work = mWorkQueue.front();
-					mWorkQueue.pop();
-					_mutex.unlock();
+				std::unique_lock<std::mutex> lock(mWorkers[index]->lock);
 
-					try
+				auto& tasks = mWorkers[index]->tasks[priority];
+				for (auto it = tasks.end(); it != tasks.begin(); )
+				{
+					--it;
+					if (group == nullptr || it->group == group)
 					{
-						work();
+						task = std::move(*it);
+						tasks.erase(it);
+						mQueued--;
+
+						if (task.group != nullptr)
+							task.group->onTaskTaken();
+
+						return true;
 					}
-					catch (...) {}
-					
-					mNumWork--;
 				}
-				else
+			}
+
+			// Steal the oldest task of the other workers
+			for (int i = 1; i <= count; i++)
+			{
+				int victim = (index + i) % count;
+				if (victim == index)
+					continue;
+
+				std::unique_lock<std::mutex> lock(mWorkers[victim]->lock);
+
+				auto& tasks = mWorkers[victim]->tasks[priority];
+				for (auto it = tasks.begin(); it != tasks.end(); ++it)
 				{
-					_mutex.unlock();
+					if (group == nullptr || it->group == group)
+					{
+						task = std::move(*it);
+						tasks.erase(it);
+						mQueued--;
 
-					// Extra code : Exit finished threads
-					if (mWaiting)
-						return;
+						if (task.group != nullptr)
+							task.group->onTaskTaken();
 
-					std::this_thread::yield();
-					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+						return true;
+					}
 				}
 			}
-		};
+		}
+
+		return false;
+	}
+
+	void Executor::run(Task& task)
+	{
+		TaskGroup* group = task.group;
+
+		if (group == nullptr || !group->isCancelled())
+		{
+			try
+			{
+				task.work();
+			}
+			catch (...) {}
+		}
 
-		mThreads.reserve(num_threads);
+		// Release the captures before the group is notified, they may refer to the waiter's stack
+		task.work = nullptr;
 
-		for (size_t i = 0; i < num_threads; i++)
-			mThreads.push_back(std::thread(doWork, i));
+		if (group != nullptr)
+			group->onTaskDone();
 	}
 
-	ThreadPool::~ThreadPool()
+	void Executor::workerProc(int index)
 	{
-		mRunning = false;
+		sWorkerIndex = index;
+
+		while (true)
+		{
+			Task task;
+			if (take(index, nullptr, task))
+			{
+				run(task);
+				continue;
+			}
 
-		for (std::thread& t : mThreads)
-			if (t.joinable())
-				t.join();
+			std::unique_lock<std::mutex> lock(mIdleLock);
+			mIdleEvent.wait(lock, [this] { return mQueued.load() > 0; });
+		}
 	}
 
-	void ThreadPool::queueWorkItem(work_function work)
+	bool Executor::runGroupTask(TaskGroup* group)
 	{
-		_mutex.lock();
-		mWorkQueue.push(work);
-		mNumWork++;
-		_mutex.unlock();
+		Task task;
+		if (!take(sWorkerIndex, group, task))
+			return false;
+
+		run(task);
+		return true;
 	}
 
-	void ThreadPool::wait()
+	TaskGroup::TaskGroup(TaskPriority priority) : mPriority(priority), mPending(0), mQueued(0), mCancelled(false)
 	{
-		if (!mRunning)
-			start();
+	}
 
-		mWaiting = true;
-		while (mNumWork.load() > 0)
-			std::this_thread::yield();
+	TaskGroup::~TaskGroup()
+	{
+		mCancelled = true;
+		wait();
 	}
 
-	void ThreadPool::wait(work_function work, int delay)
+	void TaskGroup::queue(work_function work)
 	{
-		if (!mRunning)
-			start();
+		Executor::getInstance()->submit(work, this, mPriority);
+	}
 
-		mWaiting = true;
+	void TaskGroup::queue(work_function work, TaskPriority priority)
+	{
+		Executor::getInstance()->submit(work, this, priority);
+	}
 
-		while (mNumWork.load() > 0)
+	void TaskGroup::onTaskQueued()
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		mPending++;
+		mQueued++;
+		mEvent.notify_all();
+	}
+
+	void TaskGroup::onTaskTaken()
+	{
+		mQueued--;
+	}
+
+	void TaskGroup::onTaskDone()
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		mPending--;
+		mEvent.notify_all();
+	}
+
+	void TaskGroup::wait()
+	{
+		auto executor = Executor::getInstance();
+
+		if (executor->isWorkerThread())
 		{
-			work();
+			// Waiting from a task : help with the tasks of this group instead of holding the worker
+			while (mPending.load() > 0)
+			{
+				if (executor->runGroupTask(this))
+					continue;
+
+				std::unique_lock<std::mutex> lock(mLock);
+				mEvent.wait(lock, [this] { return mPending.load() == 0 || mQueued.load() > 0; });
+			}
 
-			std::this_thread::yield();
-			std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+			// Make sure the last onTaskDone has released the lock, the group may be destroyed as soon as we return
+			std::unique_lock<std::mutex> lock(mLock);
+			return;
 		}
+
+		std::unique_lock<std::mutex> lock(mLock);
+		mEvent.wait(lock, [this] { return mPending.load() == 0; });
 	}
 
-	void ThreadPool::stop()
+	void TaskGroup::wait(work_function callback, int delay)
 	{
-		_mutex.lock();
-
-		while (!mWorkQueue.empty())
+		if (Executor::getInstance()->isWorkerThread())
 		{
-			mNumWork--;
-			mWorkQueue.pop();
+			wait();
+			return;
 		}
-		
-		_mutex.unlock();
-		mWaiting = true;
 
-		while (mNumWork.load() > 0)
+		while (mPending.load() > 0)
 		{
-			std::this_thread::yield();
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			callback();
+
+			std::unique_lock<std::mutex> lock(mLock);
+			mEvent.wait_for(lock, std::chrono::milliseconds(delay), [this] { return mPending.load() == 0; });
 		}
+
+		std::unique_lock<std::mutex> lock(mLock);
 	}
-}
\ No newline at end of file
+}
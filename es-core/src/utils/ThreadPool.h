@@ -3,9 +3,13 @@
 
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <deque>
+#include <vector>
+#include <memory>
 #include <atomic>
+#include <future>
 #include <functional>
+#include <condition_variable>
 
 // Heavy multithreading only for X86 based systems
 #if defined(__x86_64__) || defined(_M_X64) || defined(i386) || defined(__i386__) || defined(__i386) || defined(_M_IX86)
@@ -16,32 +20,110 @@
 
 namespace Utils
 {
-	class ThreadPool
+	enum class TaskPriority : int
+	{
+		High = 0,
+		Normal = 1,
+		Low = 2
+	};
+
+	class TaskGroup;
+
+	// Process-wide executor : workers sleep when there's nothing to do, each worker has its own deques (one per priority),
+	// pops its newest tasks & steals the oldest tasks of the other workers when idle.
+	class Executor
+	{
+	public:
+		typedef std::function<void(void)> work_function;
+
+		static Executor* getInstance();
+
+		void submit(work_function work, TaskGroup* group = nullptr, TaskPriority priority = TaskPriority::Normal);
+
+		template<typename F>
+		auto async(F work, TaskPriority priority = TaskPriority::Normal) -> std::future<decltype(work())>
+		{
+			typedef decltype(work()) result_type;
+
+			auto task = std::make_shared<std::packaged_task<result_type()>>(work);
+			submit([task] { (*task)(); }, nullptr, priority);
+			return task->get_future();
+		}
+
+		int getThreadCount() { return (int)mWorkers.size(); }
+		bool isWorkerThread();
+
+	private:
+		friend class TaskGroup;
+
+		static const int PRIORITY_COUNT = 3;
+
+		struct Task
+		{
+			work_function work;
+			TaskGroup* group;
+		};
+
+		struct Worker
+		{
+			std::mutex lock;
+			std::deque<Task> tasks[PRIORITY_COUNT];
+			std::thread thread;
+		};
+
+		Executor();
+
+		void workerProc(int index);
+		bool take(int index, TaskGroup* group, Task& task);
+		void run(Task& task);
+
+		// Runs one queued task of the group on the calling worker thread, so a task waiting for its subtasks never blocks a worker
+		bool runGroupTask(TaskGroup* group);
+
+		std::vector<std::unique_ptr<Worker>> mWorkers;
+
+		std::atomic<int> mQueued;
+		std::atomic<unsigned int> mNextWorker;
+
+		std::mutex mIdleLock;
+		std::condition_variable mIdleEvent;
+	};
+
+	// Set of tasks that can be waited for or cancelled together. The destructor cancels the tasks not started yet & waits for the running ones.
+	class TaskGroup
 	{
 	public:
 		typedef std::function<void(void)> work_function;
 
-		ThreadPool(int threadByCore = THREAD_BY_CORE);
-		~ThreadPool();
+		TaskGroup(TaskPriority priority = TaskPriority::Normal);
+		virtual ~TaskGroup();
+
+		void queue(work_function work);
+		void queue(work_function work, TaskPriority priority);
 
-		void start();
-		void queueWorkItem(work_function work);
 		void wait();
-		void wait(work_function work, int delay = 50);
-		void cancel() { mRunning = false; }
-		void stop();
+		void wait(work_function callback, int delay = 50);
+
+		void cancel() { mCancelled = true; }
+		bool isCancelled() { return mCancelled; }
 
-		bool isRunning() { return mRunning; }
+		int pending() { return mPending; }
 
 	private:
-		bool mRunning;
-		bool mWaiting;
-		std::queue<work_function> mWorkQueue;
-		std::atomic<size_t> mNumWork;
-		std::mutex _mutex;
-		std::vector<std::thread> mThreads;
-		int mThreadByCore;
+		friend class Executor;
+
+		void onTaskQueued();
+		void onTaskTaken();
+		void onTaskDone();
+
+		TaskPriority mPriority;
+
+		std::atomic<int> mPending;	// queued or running
+		std::atomic<int> mQueued;	// not started yet
+		std::atomic<bool> mCancelled;
 
+		std::mutex mLock;
+		std::condition_variable mEvent;
 	};
 }
 